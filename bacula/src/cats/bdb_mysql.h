@@ -33,7 +33,8 @@ public:
    B_DB_MYSQL(JCR *jcr, const char *db_driver, const char *db_name,
               const char *db_user, const char *db_password,
               const char *db_address, int db_port, const char *db_socket,
-              bool mult_db_connections, bool disable_batch_insert);
+              bool mult_db_connections, bool disable_batch_insert,
+              int pool_size);
    ~B_DB_MYSQL();
 
    /* low level operations */
@@ -16,6 +16,17 @@
 #ifndef __BDB_SQLITE_H_
 #define __BDB_SQLITE_H_ 1
 
+/*
+ * Number of insert statements to batch-up in batch insert
+ * mode. Multi-row VALUES lists need SQLite 3.7.11 or later,
+ * older libraries insert one row per statement.
+ */
+#if SQLITE_VERSION_NUMBER >= 3007011
+#define SQLITE_CHANGES_PER_BATCH_INSERT 100
+#else
+#define SQLITE_CHANGES_PER_BATCH_INSERT 1
+#endif
+
 class B_DB_SQLITE: public B_DB_PRIV {
 private:
    struct sqlite3 *m_db_handle;
@@ -28,7 +39,8 @@ public:
    B_DB_SQLITE(JCR *jcr, const char *db_driver, const char *db_name,
                const char *db_user, const char *db_password,
                const char *db_address, int db_port, const char *db_socket,
-               bool mult_db_connections, bool disable_batch_insert);
+               bool mult_db_connections, bool disable_batch_insert,
+               int pool_size);
    ~B_DB_SQLITE();
 
    /* Used internaly by sqlite.c to access fields in db_sql_query() */
@@ -840,7 +840,7 @@ void Bvfs::get_all_file_versions(DBId_t pathid, DBId_t fnid, const char *client)
         ,edit_uint64(fnid, ed1), edit_uint64(pathid, ed2), client, q.c_str(),
         limit, offset);
    Dmsg1(dbglevel_sql, "q=%s\n", query.c_str());
-   db_sql_query(db, query.c_str(), list_entries, user_data);
+   db_big_sql_query(db, query.c_str(), list_entries, user_data);
 }
 
 /*
@@ -863,7 +863,7 @@ void Bvfs::get_volumes(DBId_t  fileid)
   " ORDER BY JobMediaId LIMIT %d OFFSET %d"
         ,edit_uint64(fileid, ed1), limit, offset);
    Dmsg1(dbglevel_sql, "q=%s\n", query.c_str());
-   db_sql_query(db, query.c_str(), list_entries, user_data);
+   db_big_sql_query(db, query.c_str(), list_entries, user_data);
 }
 
 DBId_t Bvfs::get_root()
@@ -882,8 +882,25 @@ static int path_handler(void *ctx, int fields, char **row)
    return fs->_handle_path(ctx, fields, row);
 }
 
+static int entry_handler(void *ctx, int fields, char **row)
+{
+   Bvfs *fs = (Bvfs *) ctx;
+   return fs->_handle_entry(ctx, fields, row);
+}
+
+/*
+ * The rows are streamed to the handlers, so we count them
+ *  here instead of asking the backend for the result size.
+ */
+int Bvfs::_handle_entry(void *ctx, int fields, char **row)
+{
+   nb_record++;
+   return list_entries(user_data, fields, row);
+}
+
 int Bvfs::_handle_path(void *ctx, int fields, char **row)
 {
+   nb_record++;
    if (bvfs_is_dir(row)) {
       /* can have the same path 2 times */
       if (strcmp(row[BVFS_PathId], prev_dir)) {
@@ -933,7 +950,7 @@ void Bvfs::ls_special_dirs()
         query.c_str(), edit_uint64(dir_filenameid, ed2), jobids);
 
    Dmsg1(dbglevel_sql, "q=%s\n", query2.c_str());
-   db_sql_query(db, query2.c_str(), path_handler, this);
+   db_big_sql_query(db, query2.c_str(), path_handler, this);
 }
 
 /* Returns true if we have dirs to read */
@@ -1003,8 +1020,8 @@ bool Bvfs::ls_dirs()
    Dmsg1(dbglevel_sql, "q=%s\n", query.c_str());
 
    db_lock(db);
-   db_sql_query(db, query.c_str(), path_handler, this);
-   nb_record = sql_num_rows(db);
+   nb_record = 0;
+   db_big_sql_query(db, query.c_str(), path_handler, this);
    db_unlock(db);
 
    return nb_record == limit;
@@ -1057,8 +1074,8 @@ bool Bvfs::ls_files()
    Dmsg1(dbglevel_sql, "q=%s\n", query.c_str());
 
    db_lock(db);
-   db_sql_query(db, query.c_str(), list_entries, user_data);
-   nb_record = sql_num_rows(db);
+   nb_record = 0;
+   db_big_sql_query(db, query.c_str(), entry_handler, this);
    db_unlock(db);
 
    return nb_record == limit;
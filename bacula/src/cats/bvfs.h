@@ -193,6 +193,7 @@ public:
 
    /* for internal use */
    int _handle_path(void *, int, char **);
+   int _handle_entry(void *, int, char **);
 
    /* Handle Delta parts if any */
 
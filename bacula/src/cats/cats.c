@@ -47,6 +47,61 @@ bool B_DB::db_match_database(const char *db_driver, const char *db_name,
    return match;
 }
 
+/*
+ * Catalog connection pool
+ *
+ *  Jobs that do not ask for a dedicated connection share the open
+ *   connections to the same catalog, serialized by db_lock().  With
+ *   a pool size of one (the default) every Job shares a single
+ *   connection; with a bigger pool, up to pool_size connections are
+ *   opened and a new user gets the least used one, so the number of
+ *   backend connections does not follow the number of Jobs.
+ *
+ *  The pool size comes from the Catalog resource, the Director gives
+ *   it to db_init_database(), so it is set before a new connection
+ *   is put in the list that other Jobs look at.
+ *
+ *  The statistics are updated with atomic operations, db_lock() is
+ *   called for every catalog request.
+ */
+static DB_POOL_STATS db_stats;
+
+/*
+ * Called by the backends with their DB queue locked
+ *
+ *  Returns: connection to share
+ *           NULL if a new connection must be opened
+ */
+B_DB *db_find_pooled_connection(dlist *db_list, const char *db_driver,
+                                const char *db_name, const char *db_address,
+                                int db_port)
+{
+   B_DB *mdb, *best = NULL;
+   int count = 0, pool_size = 1;
+
+   foreach_dlist(mdb, db_list) {
+      if (mdb->db_match_database(db_driver, db_name, db_address, db_port)) {
+         count++;
+         pool_size = MAX(pool_size, mdb->get_pool_size());
+         if (!best || mdb->get_refcount() < best->get_refcount()) {
+            best = mdb;
+         }
+      }
+   }
+   if (count < pool_size) {
+      return NULL;
+   }
+   return best;
+}
+
+void db_get_pool_stats(DB_POOL_STATS *stats)
+{
+   stats->locks = __sync_fetch_and_add(&db_stats.locks, 0);
+   stats->wait_time = __sync_fetch_and_add(&db_stats.wait_time, 0);
+   stats->max_wait = __sync_fetch_and_add(&db_stats.max_wait, 0);
+   stats->busy_time = __sync_fetch_and_add(&db_stats.busy_time, 0);
+}
+
 B_DB *B_DB::db_clone_database_connection(JCR *jcr, bool mult_db_connections)
 {
    /*
@@ -62,7 +117,8 @@ B_DB *B_DB::db_clone_database_connection(JCR *jcr, bool mult_db_connections)
     * A bit more to do here just open a new session to the database.
     */
    return db_init_database(jcr, m_db_driver, m_db_name, m_db_user, m_db_password,
-                           m_db_address, m_db_port, m_db_socket, true, m_disabled_batch_insert);
+                           m_db_address, m_db_port, m_db_socket, true, m_disabled_batch_insert,
+                           m_pool_size);
 }
 
 const char *B_DB::db_get_type(void)
@@ -87,11 +143,24 @@ const char *B_DB::db_get_type(void)
 void B_DB::_db_lock(const char *file, int line)
 {
    int errstat;
+   btime_t start, wait, old;
 
+   start = get_current_btime();
    if ((errstat = rwl_writelock_p(&m_lock, file, line)) != 0) {
       berrno be;
       e_msg(file, line, M_FATAL, 0, "rwl_writelock failure. stat=%d: ERR=%s\n",
             errstat, be.bstrerror(errstat));
+      return;
+   }
+   if (m_lock.w_active == 1) {        /* not a recursive lock */
+      m_locked_at = get_current_btime();
+      wait = m_locked_at - start;
+      __sync_fetch_and_add(&db_stats.locks, 1);
+      __sync_fetch_and_add(&db_stats.wait_time, wait);
+      old = db_stats.max_wait;
+      while (wait > old && !__sync_bool_compare_and_swap(&db_stats.max_wait, old, wait)) {
+         old = db_stats.max_wait;
+      }
    }
 }
 
@@ -104,6 +173,10 @@ void B_DB::_db_unlock(const char *file, int line)
 {
    int errstat;
 
+   if (m_lock.w_active == 1) {        /* last unlock */
+      btime_t busy = get_current_btime() - m_locked_at;
+      __sync_fetch_and_add(&db_stats.busy_time, busy);
+   }
    if ((errstat = rwl_writeunlock(&m_lock)) != 0) {
       berrno be;
       e_msg(file, line, M_FATAL, 0, "rwl_writeunlock failure. stat=%d: ERR=%s\n",
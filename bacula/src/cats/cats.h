@@ -151,6 +151,7 @@ struct VOL_PARAMS {
    uint64_t StartAddr;                /* Start address */
    uint64_t EndAddr;                  /* End address */
    int32_t InChanger;                 /* InChanger flag */
+   bool ByteAddr;                     /* addresses are byte offsets (disk) */
 // uint32_t Copy;                     /* identical copy */
 // uint32_t Stripe;                   /* RAIT strip number */
 };
@@ -450,6 +451,8 @@ protected:
    int m_db_port;                         /* port for host name address */
    bool m_disabled_batch_insert;          /* explicitly disabled batch insert mode ? */
    bool m_dedicated;                      /* is this connection dedicated? */
+   btime_t m_locked_at;                   /* time db_lock() was taken */
+   int m_pool_size;                       /* max shared connections to this catalog */
 
 public:
    POOLMEM *errmsg;                       /* nicely edited error message */
@@ -474,6 +477,8 @@ public:
    bool is_connected(void) { return m_connected; };
    bool batch_insert_available(void) { return m_have_batch_insert; };
    void increment_refcount(void) { m_ref_count++; };
+   int get_refcount(void) { return m_ref_count; };
+   int get_pool_size(void) { return m_pool_size; };
 
    /* low level methods */
    bool db_match_database(const char *db_driver, const char *db_name,
@@ -505,6 +510,14 @@ public:
    };
 };
 
+/* Catalog connection usage, see db_get_pool_stats() */
+struct DB_POOL_STATS {
+   uint64_t locks;                        /* times a connection was taken */
+   btime_t wait_time;                     /* total time waiting for a connection */
+   btime_t max_wait;                      /* longest wait */
+   btime_t busy_time;                     /* total time connections were held */
+};
+
 /* sql_query Query Flags */
 #define QF_STORE_RESULT 0x01
 
@@ -521,29 +534,25 @@ public:
 /* Object used in db_list_xxx function */
 class LIST_CTX {
 public:
-   char line[256];              /* Used to print last dash line */
    int32_t num_rows;
 
    e_list_type type;            /* Vertical/Horizontal */
    DB_LIST_HANDLER *send;       /* send data back */
-   bool once;                   /* Used to print header one time */
+   bool once;                   /* Set when the columns are known */
    void *ctx;                   /* send() user argument */
    B_DB *mdb;
    JCR *jcr;
 
-   void empty() {
-      once = false;
-      line[0] = '\0';
-   }
+   int num_fields;              /* Number of columns */
+   char **names;                /* Column names */
+   bool *numeric;               /* Set for numeric columns */
+   int *widths;                 /* Display width of each column */
+   alist *rows;                 /* First rows, kept to size the columns */
 
-   void send_dashes() {
-      if (*line) {
-         send(ctx, line);
-      }
-   }
+   /* Print the rows still kept and the last dash line */
+   void send_dashes();
 
    LIST_CTX(JCR *j, B_DB *m, DB_LIST_HANDLER *h, void *c, e_list_type t) {
-      line[0] = '\0';
       once = false;
       num_rows = 0;
       type = t;
@@ -551,7 +560,13 @@ public:
       ctx = c;
       jcr = j;
       mdb = m;
+      num_fields = 0;
+      names = NULL;
+      numeric = NULL;
+      widths = NULL;
+      rows = NULL;
    }
+   ~LIST_CTX();
 };
 
 /*
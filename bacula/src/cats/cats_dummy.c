@@ -22,7 +22,7 @@
 
 B_DB *db_init_database(JCR *jcr, const char *db_driver, const char *db_name, const char *db_user,
         const char *db_password, const char *db_address, int db_port, const char *db_socket,
-        bool mult_db_connections, bool disable_batch_insert)
+        bool mult_db_connections, bool disable_batch_insert, int pool_size)
 {
    Jmsg(jcr, M_FATAL, 0, _("Please replace this null libbaccats library with a proper one.\n"));
    return NULL;
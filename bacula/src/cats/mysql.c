@@ -55,7 +55,8 @@ B_DB_MYSQL::B_DB_MYSQL(JCR *jcr,
                        int db_port,
                        const char *db_socket,
                        bool mult_db_connections,
-                       bool disable_batch_insert)
+                       bool disable_batch_insert,
+                       int pool_size)
 {
    /*
     * Initialize the parent class members.
@@ -110,6 +111,7 @@ B_DB_MYSQL::B_DB_MYSQL(JCR *jcr,
     * the creation function to add this parameter.
     */
    m_dedicated = mult_db_connections;
+   m_pool_size = pool_size > 0 ? pool_size : 1;
 
    /*
     * Initialize the private members.
@@ -672,7 +674,7 @@ bool B_DB_MYSQL::sql_batch_insert(JCR *jcr, ATTR_DBR *ar)
  */
 B_DB *db_init_database(JCR *jcr, const char *db_driver, const char *db_name, const char *db_user,
                        const char *db_password, const char *db_address, int db_port, const char *db_socket,
-                       bool mult_db_connections, bool disable_batch_insert)
+                       bool mult_db_connections, bool disable_batch_insert, int pool_size)
 {
    B_DB_MYSQL *mdb = NULL;
 
@@ -683,20 +685,21 @@ B_DB *db_init_database(JCR *jcr, const char *db_driver, const char *db_name, con
    P(mutex);                          /* lock DB queue */
 
    /*
-    * Look to see if DB already open
+    * Look to see if DB already open, and if we can share it
     */
    if (db_list && !mult_db_connections) {
-      foreach_dlist(mdb, db_list) {
-         if (mdb->db_match_database(db_driver, db_name, db_address, db_port)) {
-            Dmsg1(100, "DB REopen %s\n", db_name);
-            mdb->increment_refcount();
-            goto bail_out;
-         }
+      mdb = (B_DB_MYSQL *)db_find_pooled_connection(db_list, db_driver, db_name,
+                                                    db_address, db_port);
+      if (mdb) {
+         Dmsg2(100, "DB REopen %s refcount=%d\n", db_name, mdb->get_refcount());
+         mdb->increment_refcount();
+         goto bail_out;
       }
    }
    Dmsg0(100, "db_init_database first time\n");
    mdb = New(B_DB_MYSQL(jcr, db_driver, db_name, db_user, db_password, db_address,
-                        db_port, db_socket, mult_db_connections, disable_batch_insert));
+                        db_port, db_socket, mult_db_connections, disable_batch_insert,
+                        pool_size));
 
 bail_out:
    V(mutex);
@@ -28,6 +28,12 @@
 
 /* Database prototypes */
 
+/* cats.c */
+B_DB *db_find_pooled_connection(dlist *db_list, const char *db_driver,
+                                const char *db_name, const char *db_address,
+                                int db_port);
+void db_get_pool_stats(DB_POOL_STATS *stats);
+
 /* sql.c */
 bool db_open_batch_connexion(JCR *jcr, B_DB *mdb);
 char *db_strerror(B_DB *mdb);
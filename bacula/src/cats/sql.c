@@ -457,135 +457,223 @@ void list_dashes(B_DB *mdb, DB_LIST_HANDLER *send, void *ctx)
    send(ctx, "\n");
 }
 
-/* Small handler to print the last line of a list xxx command */
-static void last_line_handler(void *vctx, const char *str)
+/*
+ * The callback version of list_result() is used with db_big_sql_query()
+ *  to list results that can be very large.  Nothing is kept in memory
+ *  but the first LIST_SIZING_ROWS rows, that are used to compute the
+ *  column widths of a horizontal list.  They are printed as soon as we
+ *  have enough of them, and the following rows are sent as they
+ *  arrive.  A vertical list does not need the column widths, so every
+ *  row is sent immediately.
+ */
+#define LIST_SIZING_ROWS 1000
+
+static void list_free_row(LIST_CTX *pctx, char **row)
 {
-   LIST_CTX *ctx = (LIST_CTX *)vctx;
-   bstrncat(ctx->line, str, sizeof(ctx->line));
+   for (int i = 0; i < pctx->num_fields; i++) {
+      if (row[i]) {
+         free(row[i]);
+      }
+   }
+   free(row);
 }
 
-int list_result(void *vctx, int nb_col, char **row)
+LIST_CTX::~LIST_CTX()
 {
-   SQL_FIELD *field;
-   int i, col_len, max_len = 0;
-   int num_fields;
-   char buf[2000], ewc[30];
-
-   LIST_CTX *pctx = (LIST_CTX *)vctx;
-   DB_LIST_HANDLER *send = pctx->send;
-   e_list_type type = pctx->type;
-   B_DB *mdb = pctx->mdb;
-   void *ctx = pctx->ctx;
-   JCR *jcr = pctx->jcr;
-
-   num_fields = sql_num_fields(mdb);
-   if (!pctx->once) {
-      pctx->once = true;
+   char **row;
 
-      Dmsg1(800, "list_result starts looking at %d fields\n", num_fields);
-      /* determine column display widths */
-      sql_field_seek(mdb, 0);
-      for (i = 0; i < num_fields; i++) {
-         Dmsg1(800, "list_result processing field %d\n", i);
-         field = sql_fetch_field(mdb);
-         if (!field) {
-            break;
-         }
-         col_len = cstrlen(field->name);
-         if (type == VERT_LIST) {
-            if (col_len > max_len) {
-               max_len = col_len;
-            }
-         } else {
-            if (sql_field_is_numeric(mdb, field->type) && (int)field->max_length > 0) { /* fixup for commas */
-               field->max_length += (field->max_length - 1) / 3;
-            }
-            if (col_len < (int)field->max_length) {
-               col_len = field->max_length;
-            }
-            if (col_len < 4 && !sql_field_is_not_null(mdb, field->flags)) {
-               col_len = 4;                 /* 4 = length of the word "NULL" */
-            }
-            field->max_length = col_len;    /* reset column info */
-         }
+   if (rows) {
+      foreach_alist(row, rows) {
+         list_free_row(this, row);
+      }
+      delete rows;
+   }
+   if (names) {
+      for (int i = 0; i < num_fields; i++) {
+         free(names[i]);
       }
+      free(names);
+   }
+   if (numeric) {
+      free(numeric);
+   }
+   if (widths) {
+      free(widths);
+   }
+}
 
-      pctx->num_rows++;
+/*
+ * Get the column names and types, they are available only
+ *  while the query is running.
+ */
+static void list_init_columns(LIST_CTX *pctx, int nb_col)
+{
+   SQL_FIELD *field;
+   int i, col_len, max_len = 0;
 
-      Dmsg0(800, "list_result finished first loop\n");
-      if (type == VERT_LIST) {
-         goto vertical_list;
+   pctx->once = true;
+   pctx->num_fields = nb_col;
+   pctx->names = (char **)malloc(nb_col * sizeof(char *));
+   pctx->numeric = (bool *)malloc(nb_col * sizeof(bool));
+   pctx->widths = (int *)malloc(nb_col * sizeof(int));
+
+   Dmsg1(800, "list_result starts looking at %d fields\n", nb_col);
+   sql_field_seek(pctx->mdb, 0);
+   for (i = 0; i < nb_col; i++) {
+      field = sql_fetch_field(pctx->mdb);
+      if (field) {
+         pctx->names[i] = bstrdup(field->name);
+         pctx->numeric[i] = sql_field_is_numeric(pctx->mdb, field->type);
+      } else {
+         pctx->names[i] = bstrdup("");
+         pctx->numeric[i] = false;
       }
+      col_len = cstrlen(pctx->names[i]);
+      pctx->widths[i] = col_len;
+      if (col_len > max_len) {
+         max_len = col_len;
+      }
+   }
+   if (pctx->type == VERT_LIST) {
+      for (i = 0; i < nb_col; i++) {
+         pctx->widths[i] = max_len;
+      }
+   } else {
+      pctx->rows = New(alist(100, not_owned_by_alist));
+   }
+}
 
-      Dmsg1(800, "list_result starts second loop looking at %d fields\n", num_fields);
+/* Value of a column as it will be displayed */
+static const char *list_value(LIST_CTX *pctx, int i, const char *val, char *ewc)
+{
+   if (val == NULL) {
+      return "NULL";
+   }
+   if (pctx->numeric[i] && !pctx->jcr->gui && is_an_integer(val)) {
+      return add_commas((char *)val, ewc);
+   }
+   return val;
+}
 
-      /* Keep the result to display the same line at the end of the table */
-      list_dashes(mdb, last_line_handler, pctx);
-      send(ctx, pctx->line);
+static void list_send_dashes(LIST_CTX *pctx)
+{
+   POOL_MEM buf;
+   int i, j, len;
 
-      send(ctx, "|");
-      sql_field_seek(mdb, 0);
-      for (i = 0; i < num_fields; i++) {
-         Dmsg1(800, "list_result looking at field %d\n", i);
-         field = sql_fetch_field(mdb);
-         if (!field) {
-            break;
-         }
-         max_len = max_length(field->max_length);
-         bsnprintf(buf, sizeof(buf), " %-*s |", max_len, field->name);
-         send(ctx, buf);
+   pm_strcpy(buf, "+");
+   for (i = 0; i < pctx->num_fields; i++) {
+      len = max_length(pctx->widths[i]) + 2;
+      for (j = 0; j < len; j++) {
+         pm_strcat(buf, "-");
       }
-      send(ctx, "\n");
-      list_dashes(mdb, send, ctx);
+      pm_strcat(buf, "+");
    }
+   pm_strcat(buf, "\n");
+   pctx->send(pctx->ctx, buf.c_str());
+}
 
-   Dmsg1(800, "list_result starts third loop looking at %d fields\n", num_fields);
+static void list_send_row(LIST_CTX *pctx, char **row)
+{
+   char buf[2000], ewc[30];
+   int i;
 
-   sql_field_seek(mdb, 0);
-   send(ctx, "|");
-   for (i = 0; i < num_fields; i++) {
-      field = sql_fetch_field(mdb);
-      if (!field) {
-         break;
+   if (pctx->type == VERT_LIST) {
+      for (i = 0; i < pctx->num_fields; i++) {
+         bsnprintf(buf, sizeof(buf), " %*s: %s\n", pctx->widths[i],
+                   pctx->names[i], list_value(pctx, i, row[i], ewc));
+         pctx->send(pctx->ctx, buf);
       }
-      max_len = max_length(field->max_length);
-      if (row[i] == NULL) {
-         bsnprintf(buf, sizeof(buf), " %-*s |", max_len, "NULL");
-      } else if (sql_field_is_numeric(mdb, field->type) && !jcr->gui && is_an_integer(row[i])) {
-         bsnprintf(buf, sizeof(buf), " %*s |", max_len,
-                   add_commas(row[i], ewc));
+      pctx->send(pctx->ctx, "\n");
+      return;
+   }
+
+   pctx->send(pctx->ctx, "|");
+   for (i = 0; i < pctx->num_fields; i++) {
+      const char *val = list_value(pctx, i, row[i], ewc);
+      if (val == ewc) {                 /* numbers are right aligned */
+         bsnprintf(buf, sizeof(buf), " %*s |", max_length(pctx->widths[i]), val);
       } else {
-         bsnprintf(buf, sizeof(buf), " %-*s |", max_len, row[i]);
+         bsnprintf(buf, sizeof(buf), " %-*s |", max_length(pctx->widths[i]), val);
       }
-      send(ctx, buf);
+      pctx->send(pctx->ctx, buf);
    }
-   send(ctx, "\n");
-   return 0;
+   pctx->send(pctx->ctx, "\n");
+}
 
-vertical_list:
+/*
+ * Print the header of a horizontal list followed by the rows
+ *  kept so far, then forget them.
+ */
+static void list_flush_rows(LIST_CTX *pctx)
+{
+   char buf[2000];
+   char **row;
 
-   Dmsg1(800, "list_result starts vertical list at %d fields\n", num_fields);
+   list_send_dashes(pctx);
+   pctx->send(pctx->ctx, "|");
+   for (int i = 0; i < pctx->num_fields; i++) {
+      bsnprintf(buf, sizeof(buf), " %-*s |", max_length(pctx->widths[i]),
+                pctx->names[i]);
+      pctx->send(pctx->ctx, buf);
+   }
+   pctx->send(pctx->ctx, "\n");
+   list_send_dashes(pctx);
 
-   sql_field_seek(mdb, 0);
-   for (i = 0; i < num_fields; i++) {
-      field = sql_fetch_field(mdb);
-      if (!field) {
-         break;
-      }
-      if (row[i] == NULL) {
-         bsnprintf(buf, sizeof(buf), " %*s: %s\n", max_len, field->name, "NULL");
-      } else if (sql_field_is_numeric(mdb, field->type) && !jcr->gui && is_an_integer(row[i])) {
-         bsnprintf(buf, sizeof(buf), " %*s: %s\n", max_len, field->name,
-                   add_commas(row[i], ewc));
-      } else {
-         bsnprintf(buf, sizeof(buf), " %*s: %s\n", max_len, field->name, row[i]);
+   foreach_alist(row, pctx->rows) {
+      list_send_row(pctx, row);
+      list_free_row(pctx, row);
+   }
+   delete pctx->rows;
+   pctx->rows = NULL;
+}
+
+int list_result(void *vctx, int nb_col, char **row)
+{
+   LIST_CTX *pctx = (LIST_CTX *)vctx;
+   char **copy, ewc[30];
+   int i, len;
+
+   if (!pctx->once) {
+      list_init_columns(pctx, nb_col);
+   }
+   pctx->num_rows++;
+
+   if (!pctx->rows) {
+      list_send_row(pctx, row);         /* widths are known */
+      return 0;
+   }
+
+   copy = (char **)malloc(pctx->num_fields * sizeof(char *));
+   for (i = 0; i < pctx->num_fields; i++) {
+      copy[i] = row[i] ? bstrdup(row[i]) : NULL;
+      len = cstrlen(list_value(pctx, i, row[i], ewc));
+      if (len > pctx->widths[i]) {
+         pctx->widths[i] = len;
       }
-      send(ctx, buf);
    }
-   send(ctx, "\n");
+   pctx->rows->append(copy);
+   if (pctx->rows->size() >= LIST_SIZING_ROWS) {
+      Dmsg1(800, "list_result sized columns on %d rows\n", pctx->num_rows);
+      list_flush_rows(pctx);
+   }
    return 0;
 }
 
+/*
+ * Called when the query is over, print what is still kept
+ *  and the closing line of a horizontal list.
+ */
+void LIST_CTX::send_dashes()
+{
+   if (!once || type == VERT_LIST) {
+      return;
+   }
+   if (rows) {
+      list_flush_rows(this);
+   }
+   list_send_dashes(this);
+}
+
 /*
  * If full_list is set, we list vertically, otherwise, we
  *  list on one line horizontally.
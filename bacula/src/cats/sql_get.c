@@ -423,7 +423,7 @@ int db_get_job_volume_parameters(JCR *jcr, B_DB *mdb, JobId_t JobId, VOL_PARAMS
    Mmsg(mdb->cmd,
 "SELECT VolumeName,MediaType,FirstIndex,LastIndex,StartFile,"
 "JobMedia.EndFile,StartBlock,JobMedia.EndBlock,"
-"Slot,StorageId,InChanger"
+"Slot,StorageId,InChanger,Media.EndFile,Media.EndBlock,VolBytes"
 " FROM JobMedia,Media WHERE JobMedia.JobId=%s"
 " AND JobMedia.MediaId=Media.MediaId ORDER BY VolIndex,JobMediaId",
         edit_int64(JobId, ed1));
@@ -451,6 +451,7 @@ int db_get_job_volume_parameters(JCR *jcr, B_DB *mdb, JobId_t JobId, VOL_PARAMS
             } else {
                DBId_t StorageId;
                uint32_t StartBlock, EndBlock, StartFile, EndFile;
+               uint64_t VolEndAddr, VolBytes;
                bstrncpy(Vols[i].VolumeName, row[0], MAX_NAME_LENGTH);
                bstrncpy(Vols[i].MediaType, row[1], MAX_NAME_LENGTH);
                Vols[i].FirstIndex = str_to_uint64(row[2]);
@@ -464,6 +465,15 @@ int db_get_job_volume_parameters(JCR *jcr, B_DB *mdb, JobId_t JobId, VOL_PARAMS
                Vols[i].Slot = str_to_uint64(row[8]);
                StorageId = str_to_uint64(row[9]);
                Vols[i].InChanger = str_to_uint64(row[10]);
+               /*
+                * On disk the SD records the end of the Volume as the
+                *  offset of its last byte, on tape as a file and block
+                *  number, far below the bytes written.
+                */
+               VolEndAddr = (str_to_uint64(row[11])<<32) | str_to_uint64(row[12]);
+               VolBytes = str_to_uint64(row[13]);
+               Vols[i].ByteAddr = VolEndAddr < VolBytes &&
+                                  VolBytes - VolEndAddr <= 1024 * 1024;
                Vols[i].Storage[0] = 0;
                SId[i] = StorageId;
             }
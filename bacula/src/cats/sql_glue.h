@@ -27,7 +27,8 @@ const char *db_get_type(B_DB *mdb);
 B_DB *db_init_database(JCR *jcr, const char *db_driver, const char *db_name,
               const char *db_user, const char *db_password,
               const char *db_address, int db_port,
-              const char *db_socket, bool mult_db_connections, bool disable_batch_insert);
+              const char *db_socket, bool mult_db_connections, bool disable_batch_insert,
+              int pool_size=1);
 bool db_open_database(JCR *jcr, B_DB *mdb);
 void db_close_database(JCR *jcr, B_DB *mdb);
 void db_thread_cleanup(B_DB *mdb);
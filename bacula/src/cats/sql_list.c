@@ -36,13 +36,16 @@
  */
 
 /*
- * Submit general SQL query
+ * Submit general SQL query, the rows are sent to the console
+ *  as they are read from the catalog.
  */
 int db_list_sql_query(JCR *jcr, B_DB *mdb, const char *query, DB_LIST_HANDLER *sendit,
                       void *ctx, int verbose, e_list_type type)
 {
+   LIST_CTX lctx(jcr, mdb, sendit, ctx, type);
+
    db_lock(mdb);
-   if (!sql_query(mdb, query, QF_STORE_RESULT)) {
+   if (!db_big_sql_query(mdb, query, list_result, &lctx)) {
       Mmsg(mdb->errmsg, _("Query failed: %s\n"), sql_strerror(mdb));
       if (verbose) {
          sendit(ctx, mdb->errmsg);
@@ -51,7 +54,10 @@ int db_list_sql_query(JCR *jcr, B_DB *mdb, const char *query, DB_LIST_HANDLER *s
       return 0;
    }
 
-   list_result(jcr, mdb, sendit, ctx, type);
+   if (lctx.num_rows == 0) {
+      sendit(ctx, _("No results to list.\n"));
+   }
+   lctx.send_dashes();
    sql_free_result(mdb);
    db_unlock(mdb);
    return 1;
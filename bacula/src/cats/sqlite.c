@@ -63,7 +63,8 @@ B_DB_SQLITE::B_DB_SQLITE(JCR *jcr,
                          int db_port,
                          const char *db_socket,
                          bool mult_db_connections,
-                         bool disable_batch_insert)
+                         bool disable_batch_insert,
+                         int pool_size)
 {
    /*
     * Initialize the parent class members.
@@ -106,6 +107,7 @@ B_DB_SQLITE::B_DB_SQLITE(JCR *jcr,
     * the creation function to add this parameter.
     */
    m_dedicated = mult_db_connections;
+   m_pool_size = pool_size > 0 ? pool_size : 1;
 
    /*
     * Initialize the private members.
@@ -666,6 +668,14 @@ bool B_DB_SQLITE::sql_batch_end(JCR *jcr, const char *error)
 {
    m_status = 0;
 
+   /*
+    * Flush any pending inserts.
+    */
+   if (changes) {
+      changes = 0;
+      return sql_query(cmd);
+   }
+
    return true;
 }
 
@@ -690,12 +700,35 @@ bool B_DB_SQLITE::sql_batch_insert(JCR *jcr, ATTR_DBR *ar)
       digest = ar->Digest;
    }
 
-   Mmsg(cmd, "INSERT INTO batch VALUES "
-        "(%u,%s,'%s','%s','%s','%s',%u)",
-        ar->FileIndex, edit_int64(ar->JobId,ed1), esc_path,
-        esc_name, ar->attr, digest, ar->DeltaSeq);
+   /*
+    * Try to batch up multiple inserts using multi-row inserts.
+    */
+   if (changes == 0) {
+      Mmsg(cmd, "INSERT INTO batch VALUES "
+           "(%u,%s,'%s','%s','%s','%s',%u)",
+           ar->FileIndex, edit_int64(ar->JobId,ed1), esc_path,
+           esc_name, ar->attr, digest, ar->DeltaSeq);
+   } else {
+      /*
+       * We use the esc_obj for temporary storage otherwise
+       * we keep on copying data.
+       */
+      Mmsg(esc_obj, ",(%u,%s,'%s','%s','%s','%s',%u)",
+           ar->FileIndex, edit_int64(ar->JobId,ed1), esc_path,
+           esc_name, ar->attr, digest, ar->DeltaSeq);
+      pm_strcat(cmd, esc_obj);
+   }
+   changes++;
 
-   return sql_query(cmd);
+   /*
+    * See if we need to flush the query buffer filled
+    * with multi-row inserts.
+    */
+   if ((changes % SQLITE_CHANGES_PER_BATCH_INSERT) == 0) {
+      changes = 0;
+      return sql_query(cmd);
+   }
+   return true;
 }
 
 /*
@@ -706,7 +739,7 @@ B_DB *db_init_database(JCR *jcr, const char *db_driver, const char *db_name,
                        const char *db_user, const char *db_password,
                        const char *db_address, int db_port,
                        const char *db_socket, bool mult_db_connections,
-                       bool disable_batch_insert)
+                       bool disable_batch_insert, int pool_size)
 {
    B_DB *mdb = NULL;
 
@@ -726,7 +759,7 @@ B_DB *db_init_database(JCR *jcr, const char *db_driver, const char *db_name,
    Dmsg0(300, "db_init_database first time\n");
    mdb = New(B_DB_SQLITE(jcr, db_driver, db_name, db_user, db_password,
                          db_address, db_port, db_socket, mult_db_connections,
-                         disable_batch_insert));
+                         disable_batch_insert, pool_size));
 
 bail_out:
    V(mutex);
@@ -27,8 +27,57 @@
 #include "bacula.h"
 #include "dird.h"
 
+/*
+ * Two pieces of a Volume closer than this are read as one
+ *  rather than positioning between them. On disk the Volume
+ *  address is in bytes, on tape it counts blocks within a file.
+ */
+#define BSR_MERGE_GAP_BYTES  (16 * 1024 * 1024)
+#define BSR_MERGE_GAP_BLOCKS 256
+
+/* One range of a Volume to read */
+struct BSR_RANGE {
+   const char *VolumeName;
+   uint64_t StartAddr;
+   uint64_t EndAddr;
+   bool ByteAddr;                     /* disk Volume */
+};
+
+/* What reading a bootstrap will cost, reported before the Job runs */
+struct BSR_STATS {
+   int num_ranges;                    /* ranges in bootstrap */
+   int max_ranges;                    /* allocated ranges */
+   BSR_RANGE *ranges;
+   int num_jobmedia;                  /* JobMedia records they cover */
+   uint64_t bytes;                    /* estimated bytes to restore */
+};
+
 /* Forward referenced functions */
-static uint32_t write_bsr(UAContext *ua, RESTORE_CTX &rx, FILE *fd);
+static uint32_t write_bsr(UAContext *ua, RESTORE_CTX &rx, FILE *fd, int part,
+                          BSR_STATS *stats);
+
+/*
+ * Can the next piece of a Volume be reached by reading on from
+ *  the end of the previous one? On tape only within the same file,
+ *  or when the next piece starts the following file.
+ */
+static bool voladdr_near(bool ByteAddr, uint64_t EndAddr, uint64_t StartAddr)
+{
+   uint32_t EndFile, StartFile;
+
+   if (StartAddr <= EndAddr) {
+      return true;
+   }
+   if (ByteAddr) {
+      return StartAddr - EndAddr <= BSR_MERGE_GAP_BYTES;
+   }
+   EndFile = (uint32_t)(EndAddr >> 32);
+   StartFile = (uint32_t)(StartAddr >> 32);
+   if (StartFile == EndFile) {
+      return (uint32_t)StartAddr - (uint32_t)EndAddr <= BSR_MERGE_GAP_BLOCKS;
+   }
+   return StartFile == EndFile + 1 && (uint32_t)StartAddr == 0;
+}
 
 /*
  * Create new FileIndex entry for BSR
@@ -79,7 +128,7 @@ static bool get_storage_device(char *device, char *storage)
  *  writing out the fi, constrain them to those values.
  *
  * We are called here once for each JobMedia record
- *  for each Volume.
+ *  for each Volume. With fd NULL, only count the files.
  */
 static uint32_t write_findex(RBSR_FINDEX *fi,
               int32_t FirstIndex, int32_t LastIndex, FILE *fd)
@@ -93,10 +142,14 @@ static uint32_t write_findex(RBSR_FINDEX *fi,
          findex = fi->findex < FirstIndex ? FirstIndex : fi->findex;
          findex2 = fi->findex2 > LastIndex ? LastIndex : fi->findex2;
          if (findex == findex2) {
-            fprintf(fd, "FileIndex=%d\n", findex);
+            if (fd) {
+               fprintf(fd, "FileIndex=%d\n", findex);
+            }
             count++;
          } else {
-            fprintf(fd, "FileIndex=%d-%d\n", findex, findex2);
+            if (fd) {
+               fprintf(fd, "FileIndex=%d-%d\n", findex, findex2);
+            }
             count += findex2 - findex + 1;
          }
       }
@@ -121,6 +174,25 @@ static bool is_volume_selected(RBSR_FINDEX *fi,
    return false;
 }
 
+static int find_volume_part(RESTORE_CTX &rx, const char *VolumeName)
+{
+   for (int i=0; i < rx.num_vol_parts; i++) {
+      if (strcmp(rx.vol_parts[i].VolumeName, VolumeName) == 0) {
+         return i;
+      }
+   }
+   return -1;
+}
+
+/*
+ * Return the part of a split restore that reads the given Volume
+ */
+static int get_volume_part(RESTORE_CTX &rx, const char *VolumeName)
+{
+   int i = find_volume_part(rx, VolumeName);
+   return i < 0 ? 0 : rx.vol_parts[i].part;
+}
+
 
 /* Create a new bootstrap record */
 RBSR *new_bsr()
@@ -163,6 +235,8 @@ bool complete_bsr(UAContext *ua, RBSR *bsr)
       }
       bsr->VolSessionId = jr.VolSessionId;
       bsr->VolSessionTime = jr.VolSessionTime;
+      bsr->JobBytes = jr.JobBytes;
+      bsr->JobFiles = jr.JobFiles;
       if (jr.JobFiles == 0) {      /* zero files is OK, not an error, but */
          bsr->VolCount = 0;        /*   there are no volumes */
          continue;
@@ -183,10 +257,15 @@ bool complete_bsr(UAContext *ua, RBSR *bsr)
 static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
 static uint32_t uniq = 0;
 
-static void make_unique_restore_filename(UAContext *ua, POOL_MEM &fname)
+/*
+ * The bootstrap of a part of a split restore always gets its own
+ *  file, the command line is not looked at as it is replaced by
+ *  the run command of the previous part.
+ */
+static void make_unique_restore_filename(UAContext *ua, POOL_MEM &fname, int part)
 {
    JCR *jcr = ua->jcr;
-   int i = find_arg_with_value(ua, "bootstrap");
+   int i = part < 0 ? find_arg_with_value(ua, "bootstrap") : -1;
    if (i >= 0) {
       Mmsg(fname, "%s", ua->argv[i]);
       jcr->unlink_bsr = false;
@@ -203,17 +282,63 @@ static void make_unique_restore_filename(UAContext *ua, POOL_MEM &fname)
    jcr->RestoreBootstrap = bstrdup(fname.c_str());
 }
 
+static int cmp_bsr_range(const void *a, const void *b)
+{
+   const BSR_RANGE *ra = (const BSR_RANGE *)a;
+   const BSR_RANGE *rb = (const BSR_RANGE *)b;
+   int ret = strcmp(ra->VolumeName, rb->VolumeName);
+   if (ret == 0) {
+      ret = ra->StartAddr < rb->StartAddr ? -1 : ra->StartAddr > rb->StartAddr;
+   }
+   return ret;
+}
+
 /*
- * Write the bootstrap records to file
+ * Tell the user what reading the bootstrap will cost. The SD
+ *  mounts each Volume once and reads its ranges in address
+ *  order, so count one mount per Volume and one positioning for
+ *  each range not reached by simply reading on.
  */
-uint32_t write_bsr_file(UAContext *ua, RESTORE_CTX &rx)
+static void report_bsr_stats(UAContext *ua, BSR_STATS *stats)
+{
+   char ed1[50];
+   int mounts = 0;
+   int seeks = 0;
+   uint64_t EndAddr = 0;
+
+   qsort(stats->ranges, stats->num_ranges, sizeof(BSR_RANGE), cmp_bsr_range);
+   for (int i=0; i < stats->num_ranges; i++) {
+      BSR_RANGE *r = &stats->ranges[i];
+      if (i == 0 || strcmp(r->VolumeName, stats->ranges[i-1].VolumeName) != 0) {
+         mounts++;
+         EndAddr = 0;                 /* freshly mounted Volume */
+      }
+      if (!voladdr_near(r->ByteAddr, EndAddr, r->StartAddr)) {
+         seeks++;
+      }
+      EndAddr = MAX(EndAddr, r->EndAddr);
+   }
+   Dmsg2(100, "bsr: %d JobMedia records written as %d ranges\n",
+         stats->num_jobmedia, stats->num_ranges);
+   ua->send_msg(_("The restore will mount %d Volume%s, position %d time%s and read about %s bytes.\n"),
+      mounts, mounts == 1 ? "" : "s", seeks, seeks == 1 ? "" : "s",
+      edit_uint64_with_suffix(stats->bytes, ed1));
+}
+
+/*
+ * Write the bootstrap records of the given part (-1 for all) to file
+ */
+static uint32_t write_bsr_to_file(UAContext *ua, RESTORE_CTX &rx, int part)
 {
    FILE *fd;
    POOL_MEM fname(PM_MESSAGE);
+   BSR_STATS stats;
    uint32_t count = 0;;
    bool err;
 
-   make_unique_restore_filename(ua, fname);
+   memset(&stats, 0, sizeof(stats));
+
+   make_unique_restore_filename(ua, fname, part);
    fd = fopen(fname.c_str(), "w+b");
    if (!fd) {
       berrno be;
@@ -222,7 +347,7 @@ uint32_t write_bsr_file(UAContext *ua, RESTORE_CTX &rx)
       goto bail_out;
    }
    /* Write them to file */
-   count = write_bsr(ua, rx, fd);
+   count = write_bsr(ua, rx, fd, part, &stats);
    err = ferror(fd);
    fclose(fd);
    if (count == 0) {
@@ -236,15 +361,35 @@ uint32_t write_bsr_file(UAContext *ua, RESTORE_CTX &rx)
    }
 
    ua->send_msg(_("Bootstrap records written to %s\n"), fname.c_str());
+   report_bsr_stats(ua, &stats);
 
    if (chk_dbglvl(10)) {
       print_bsr(ua, rx);
    }
 
 bail_out:
+   if (stats.ranges) {
+      free(stats.ranges);
+   }
    return count;
 }
 
+/*
+ * Write the bootstrap records to file
+ */
+uint32_t write_bsr_file(UAContext *ua, RESTORE_CTX &rx)
+{
+   return write_bsr_to_file(ua, rx, -1);
+}
+
+/*
+ * Write the bootstrap records of one part of a split restore
+ */
+uint32_t write_bsr_part_file(UAContext *ua, RESTORE_CTX &rx, int part)
+{
+   return write_bsr_to_file(ua, rx, part);
+}
+
 static void display_vol_info(UAContext *ua, RESTORE_CTX &rx, JobId_t JobId)
 {
    POOL_MEM volmsg(PM_MESSAGE);
@@ -313,11 +458,31 @@ void display_bsr_info(UAContext *ua, RESTORE_CTX &rx)
    return;
 }
 
+static void add_bsr_range(BSR_STATS *stats, const char *VolumeName,
+                          uint64_t StartAddr, uint64_t EndAddr, bool ByteAddr)
+{
+   if (stats->num_ranges == stats->max_ranges) {
+      stats->max_ranges = stats->max_ranges ? stats->max_ranges * 2 : 32;
+      stats->ranges = (BSR_RANGE *)brealloc(stats->ranges,
+                          stats->max_ranges * sizeof(BSR_RANGE));
+   }
+   stats->ranges[stats->num_ranges].VolumeName = VolumeName;
+   stats->ranges[stats->num_ranges].StartAddr = StartAddr;
+   stats->ranges[stats->num_ranges].EndAddr = EndAddr;
+   stats->ranges[stats->num_ranges].ByteAddr = ByteAddr;
+   stats->num_ranges++;
+}
+
 /*
  * Write bsr data for a single bsr record
+ *
+ * Consecutive JobMedia records of the same Volume are written as a
+ *  single entry when the gap between them is cheaper to read than
+ *  to position over.
  */
 static uint32_t write_bsr_item(RBSR *bsr, UAContext *ua,
-                   RESTORE_CTX &rx, FILE *fd, bool &first, uint32_t &LastIndex)
+                   RESTORE_CTX &rx, FILE *fd, bool &first, uint32_t &LastIndex,
+                   int part, BSR_STATS *stats)
 {
    char ed1[50], ed2[50];
    uint32_t count = 0;
@@ -329,49 +494,87 @@ static uint32_t write_bsr_item(RBSR *bsr, UAContext *ua,
     *   VolCount is the number of JobMedia records.
     */
    for (int i=0; i < bsr->VolCount; i++) {
-      if (!is_volume_selected(bsr->fi, bsr->VolParams[i].FirstIndex,
-           bsr->VolParams[i].LastIndex)) {
-         bsr->VolParams[i].VolumeName[0] = 0;  /* zap VolumeName */
+      VOL_PARAMS *vol = &bsr->VolParams[i];
+      if (!is_volume_selected(bsr->fi, vol->FirstIndex, vol->LastIndex)) {
+         vol->VolumeName[0] = 0;      /* zap VolumeName */
          continue;
       }
+      if (part >= 0 && get_volume_part(rx, vol->VolumeName) != part) {
+         continue;                    /* read by another job */
+      }
+
+      /* Coalesce the following JobMedia records of this Volume */
+      int last = i;
+      uint32_t FirstIndex = vol->FirstIndex;
+      uint32_t VolLastIndex = vol->LastIndex;
+      for (int j=i+1; j < bsr->VolCount; j++) {
+         VOL_PARAMS *next = &bsr->VolParams[j];
+         if (next->VolumeName[0] == 0) {
+            continue;                 /* zapped on a previous pass */
+         }
+         if (strcmp(next->VolumeName, vol->VolumeName) != 0 ||
+             !voladdr_near(vol->ByteAddr, bsr->VolParams[last].EndAddr,
+                           next->StartAddr)) {
+            break;
+         }
+         if (is_volume_selected(bsr->fi, next->FirstIndex, next->LastIndex)) {
+            last = j;
+            FirstIndex = MIN(FirstIndex, next->FirstIndex);
+            VolLastIndex = MAX(VolLastIndex, next->LastIndex);
+         }
+      }
+      for (int j=i+1; j <= last; j++) {
+         if (!is_volume_selected(bsr->fi, bsr->VolParams[j].FirstIndex,
+              bsr->VolParams[j].LastIndex)) {
+            bsr->VolParams[j].VolumeName[0] = 0;  /* zap VolumeName */
+         }
+      }
+
       if (!rx.store) {
-         find_storage_resource(ua, rx, bsr->VolParams[i].Storage,
-                                       bsr->VolParams[i].MediaType);
+         find_storage_resource(ua, rx, vol->Storage, vol->MediaType);
       }
-      fprintf(fd, "Storage=\"%s\"\n", bsr->VolParams[i].Storage);
-      fprintf(fd, "Volume=\"%s\"\n", bsr->VolParams[i].VolumeName);
-      fprintf(fd, "MediaType=\"%s\"\n", bsr->VolParams[i].MediaType);
+      fprintf(fd, "Storage=\"%s\"\n", vol->Storage);
+      fprintf(fd, "Volume=\"%s\"\n", vol->VolumeName);
+      fprintf(fd, "MediaType=\"%s\"\n", vol->MediaType);
       if (bsr->fileregex) {
          fprintf(fd, "FileRegex=%s\n", bsr->fileregex);
       }
-      if (get_storage_device(device, bsr->VolParams[i].Storage)) {
+      if (get_storage_device(device, vol->Storage)) {
          fprintf(fd, "Device=\"%s\"\n", device);
       }
-      if (bsr->VolParams[i].Slot > 0) {
-         fprintf(fd, "Slot=%d\n", bsr->VolParams[i].Slot);
+      if (vol->Slot > 0) {
+         fprintf(fd, "Slot=%d\n", vol->Slot);
       }
       fprintf(fd, "VolSessionId=%u\n", bsr->VolSessionId);
       fprintf(fd, "VolSessionTime=%u\n", bsr->VolSessionTime);
-      fprintf(fd, "VolAddr=%s-%s\n", edit_uint64(bsr->VolParams[i].StartAddr, ed1),
-              edit_uint64(bsr->VolParams[i].EndAddr, ed2));
+      fprintf(fd, "VolAddr=%s-%s\n", edit_uint64(vol->StartAddr, ed1),
+              edit_uint64(bsr->VolParams[last].EndAddr, ed2));
 //    Dmsg2(100, "bsr VolParam FI=%u LI=%u\n",
-//      bsr->VolParams[i].FirstIndex, bsr->VolParams[i].LastIndex);
+//      FirstIndex, VolLastIndex);
 
-      count = write_findex(bsr->fi, bsr->VolParams[i].FirstIndex,
-                           bsr->VolParams[i].LastIndex, fd);
+      count = write_findex(bsr->fi, FirstIndex, VolLastIndex, fd);
       if (count) {
          fprintf(fd, "Count=%u\n", count);
       }
       total_count += count;
+      if (stats) {
+         add_bsr_range(stats, vol->VolumeName, vol->StartAddr,
+                       bsr->VolParams[last].EndAddr, vol->ByteAddr);
+         stats->num_jobmedia += last - i + 1;
+         if (bsr->JobFiles) {
+            stats->bytes += (uint64_t)((double)bsr->JobBytes * count / bsr->JobFiles);
+         }
+      }
       /* If the same file is present on two tapes or in two files
        *   on a tape, it is a continuation, and should not be treated
        *   twice in the totals.
        */
-      if (!first && LastIndex == bsr->VolParams[i].FirstIndex) {
+      if (!first && LastIndex == FirstIndex) {
          total_count--;
       }
       first = false;
-      LastIndex = bsr->VolParams[i].LastIndex;
+      LastIndex = VolLastIndex;
+      i = last;
    }
    return total_count;
 }
@@ -385,7 +588,8 @@ static uint32_t write_bsr_item(RBSR *bsr, UAContext *ua,
  * The bsrs must be written out in the order the JobIds
  *  are found in the jobid list.
  */
-static uint32_t write_bsr(UAContext *ua, RESTORE_CTX &rx, FILE *fd)
+static uint32_t write_bsr(UAContext *ua, RESTORE_CTX &rx, FILE *fd, int part,
+                          BSR_STATS *stats)
 {
    bool first = true;
    uint32_t LastIndex = 0;
@@ -395,14 +599,14 @@ static uint32_t write_bsr(UAContext *ua, RESTORE_CTX &rx, FILE *fd)
    RBSR *bsr;
    if (*rx.JobIds == 0) {
       for (bsr=rx.bsr; bsr; bsr=bsr->next) {
-         total_count += write_bsr_item(bsr, ua, rx, fd, first, LastIndex);
+         total_count += write_bsr_item(bsr, ua, rx, fd, first, LastIndex, part, stats);
       }
       return total_count;
    }
    for (p=rx.JobIds; get_next_jobid_from_list(&p, &JobId) > 0; ) {
       for (bsr=rx.bsr; bsr; bsr=bsr->next) {
          if (JobId == bsr->JobId) {
-            total_count += write_bsr_item(bsr, ua, rx, fd, first, LastIndex);
+            total_count += write_bsr_item(bsr, ua, rx, fd, first, LastIndex, part, stats);
          }
       }
    }
@@ -411,7 +615,121 @@ static uint32_t write_bsr(UAContext *ua, RESTORE_CTX &rx, FILE *fd)
 
 void print_bsr(UAContext *ua, RESTORE_CTX &rx)
 {
-   write_bsr(ua, rx, stdout);
+   write_bsr(ua, rx, stdout, -1, NULL);
+}
+
+static int volume_part_root(RBSR_VOLPART *vp, int i)
+{
+   while (vp[i].parent != i) {
+      vp[i].parent = vp[vp[i].parent].parent;
+      i = vp[i].parent;
+   }
+   return i;
+}
+
+/*
+ * Split the Volumes of the restore into at most max_parts groups
+ *  that can be read by different drives at the same time.  A file
+ *  continued from one Volume onto the next must be read by a single
+ *  job, so such Volumes are kept together, as is any Volume used by
+ *  several JobIds.  The groups are then balanced on the number of
+ *  files to restore.
+ *
+ * Returns: number of parts, 1 if the restore cannot be split
+ */
+int split_bsr_by_volume(RESTORE_CTX &rx, int max_parts)
+{
+   RBSR *bsr;
+   RBSR_VOLPART *vp;
+   uint64_t *load;
+   int num_entries = 0;
+   int nparts = 0;
+
+   for (bsr=rx.bsr; bsr; bsr=bsr->next) {
+      num_entries += bsr->VolCount;
+   }
+   if (max_parts < 2 || num_entries < 2) {
+      return 1;
+   }
+   if (rx.vol_parts) {
+      free(rx.vol_parts);
+   }
+   vp = rx.vol_parts = (RBSR_VOLPART *)bmalloc(num_entries * sizeof(RBSR_VOLPART));
+   rx.num_vol_parts = 0;
+
+   for (bsr=rx.bsr; bsr; bsr=bsr->next) {
+      int prev = -1;
+      uint32_t PrevLastIndex = 0;
+      for (int i=0; i < bsr->VolCount; i++) {
+         VOL_PARAMS *vol = &bsr->VolParams[i];
+         if (!vol->VolumeName[0] ||
+             !is_volume_selected(bsr->fi, vol->FirstIndex, vol->LastIndex)) {
+            continue;
+         }
+         int j = find_volume_part(rx, vol->VolumeName);
+         if (j < 0) {
+            j = rx.num_vol_parts++;
+            bstrncpy(vp[j].VolumeName, vol->VolumeName, sizeof(vp[j].VolumeName));
+            vp[j].parent = j;
+            vp[j].part = -1;
+            vp[j].weight = 0;
+         }
+         vp[j].weight += write_findex(bsr->fi, vol->FirstIndex, vol->LastIndex, NULL);
+         /* File spanning two Volumes, keep them in the same part */
+         if (prev >= 0 && prev != j && PrevLastIndex == vol->FirstIndex) {
+            vp[volume_part_root(vp, j)].parent = volume_part_root(vp, prev);
+         }
+         prev = j;
+         PrevLastIndex = vol->LastIndex;
+      }
+   }
+
+   /* Sum up the weight of each group on its root */
+   for (int i=0; i < rx.num_vol_parts; i++) {
+      int root = volume_part_root(vp, i);
+      if (root != i) {
+         vp[root].weight += vp[i].weight;
+         vp[i].weight = 0;
+      }
+   }
+
+   /* Biggest group first, into the least loaded part */
+   load = (uint64_t *)bmalloc(max_parts * sizeof(uint64_t));
+   memset(load, 0, max_parts * sizeof(uint64_t));
+   for ( ;; ) {
+      int best = -1;
+      for (int i=0; i < rx.num_vol_parts; i++) {
+         if (vp[i].parent == i && vp[i].part < 0 &&
+             (best < 0 || vp[i].weight > vp[best].weight)) {
+            best = i;
+         }
+      }
+      if (best < 0) {
+         break;
+      }
+      int part = 0;
+      if (nparts < max_parts) {
+         part = nparts++;
+      } else {
+         for (int p=1; p < max_parts; p++) {
+            if (load[p] < load[part]) {
+               part = p;
+            }
+         }
+      }
+      vp[best].part = part;
+      load[part] += vp[best].weight;
+   }
+   free(load);
+
+   for (int i=0; i < rx.num_vol_parts; i++) {
+      vp[i].part = vp[volume_part_root(vp, i)].part;
+      Dmsg2(100, "Restore part %d reads Volume %s\n", vp[i].part, vp[i].VolumeName);
+   }
+   if (nparts < 2) {
+      nparts = 1;
+   }
+   return nparts;
 }
 
 
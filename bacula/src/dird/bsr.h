@@ -51,5 +51,18 @@ struct RBSR {
    VOL_PARAMS *VolParams;             /* Volume, start/end file/blocks */
    RBSR_FINDEX *fi;                   /* File indexes this JobId */
    char *fileregex;                   /* Only restore files matching regex */
+   uint64_t JobBytes;                 /* Job size, for read estimate */
+   uint32_t JobFiles;                 /* Job files, for read estimate */
 };
 
+
+/*
+ * Volume to part map used when a restore is split so that
+ *  several drives can read its Volumes at the same time.
+ */
+struct RBSR_VOLPART {
+   char VolumeName[MAX_NAME_LENGTH];
+   int parent;                        /* Volumes that must go together */
+   int part;                          /* part reading this Volume */
+   uint64_t weight;                   /* files selected on this Volume */
+};
@@ -0,0 +1,213 @@
+/*
+   Bacula® - The Network Backup Solution
+
+   Copyright (C) 2014-2014 Free Software Foundation Europe e.V.
+
+   The main author of Bacula is Kern Sibbald, with contributions from many
+   others, a complete list can be found in the file AUTHORS.
+
+   You may use this file and others of this release according to the
+   license defined in the LICENSE file, which includes the Affero General
+   Public License, v3.0 ("AGPLv3") and some additional permissions and
+   terms pursuant to its AGPLv3 Section 7.
+
+   Bacula® is a registered trademark of Kern Sibbald.
+*/
+/*
+ * Cache of the Client, FileSet and Pool catalog ids.
+ *
+ * Each Job start looks up (or creates) the Client, FileSet and Pool
+ *  records by name, then updates the Client record with the Uname
+ *  sent by the FD.  When hundreds of Jobs are started at the same
+ *  time, these queries queue behind each other on the catalog.  The
+ *  ids do not change once the records exist, so they are kept here
+ *  for "Catalog Cache Time" seconds (0 disables the cache).
+ *
+ * The entries are keyed by kind, Catalog name and record name (plus
+ *  the MD5 for the FileSets).  The cache is flushed when the
+ *  configuration is reloaded and when a Pool is deleted.
+ */
+
+#include "bacula.h"
+#include "dird.h"
+
+static const int dbglvl = 150;
+
+struct CATID_ENTRY {
+   hlink link;
+   DBId_t id;
+   time_t expires;                    /* entry not used after this time */
+   bool written;                      /* Client record updated with info */
+   char info[MAX_NAME_LENGTH];        /* Client Uname or FileSet CreateTime */
+   char key[1];
+};
+
+static pthread_mutex_t catid_mutex = PTHREAD_MUTEX_INITIALIZER;
+static htable *catid_cache = NULL;
+static uint32_t catid_hits = 0;
+static uint32_t catid_misses = 0;
+
+static const char *catid_kinds[] = { "Client", "FileSet", "Pool" };
+
+static utime_t cache_time()
+{
+   return director ? director->catalog_cache_time : 0;
+}
+
+static void make_key(POOL_MEM &key, JCR *jcr, int kind, const char *name,
+                     const char *md5)
+{
+   Mmsg(key, "%s:%s:%s:%s", catid_kinds[kind],
+        jcr->catalog ? jcr->catalog->name() : "", name, NPRT(md5));
+}
+
+/* Needs catid_mutex */
+static CATID_ENTRY *find_entry(POOL_MEM &key)
+{
+   CATID_ENTRY *entry;
+
+   if (!catid_cache) {
+      return NULL;
+   }
+   entry = (CATID_ENTRY *)catid_cache->lookup(key.c_str());
+   if (entry && entry->expires < time(NULL)) {
+      return NULL;
+   }
+   return entry;
+}
+
+/*
+ * Look for the id of a catalog record.  On success, the id is set and
+ *  the saved info is copied in info.
+ */
+bool get_cached_catalog_id(JCR *jcr, int kind, const char *name, const char *md5,
+                           DBId_t *id, char *info, int info_len)
+{
+   POOL_MEM key(PM_NAME);
+   CATID_ENTRY *entry;
+   bool found = false;
+
+   if (cache_time() == 0) {
+      return false;
+   }
+   make_key(key, jcr, kind, name, md5);
+   P(catid_mutex);
+   if ((entry = find_entry(key)) != NULL) {
+      *id = entry->id;
+      if (info) {
+         bstrncpy(info, entry->info, info_len);
+      }
+      catid_hits++;
+      found = true;
+   } else {
+      catid_misses++;
+   }
+   V(catid_mutex);
+   Dmsg3(dbglvl, "Catalog id cache %s for %s found=%d\n", catid_kinds[kind], name, found);
+   return found;
+}
+
+/* Remember the id of a catalog record that exists */
+void cache_catalog_id(JCR *jcr, int kind, const char *name, const char *md5,
+                      DBId_t id, const char *info)
+{
+   POOL_MEM key(PM_NAME);
+   CATID_ENTRY *entry = NULL;
+   utime_t ttl = cache_time();
+
+   if (ttl == 0 || id == 0) {
+      return;
+   }
+   make_key(key, jcr, kind, name, md5);
+   P(catid_mutex);
+   if (!catid_cache) {
+      catid_cache = (htable *)malloc(sizeof(htable));
+      catid_cache->init(entry, &entry->link, 1000);
+   }
+   entry = (CATID_ENTRY *)catid_cache->lookup(key.c_str());
+   if (!entry) {
+      int len = strlen(key.c_str());
+      entry = (CATID_ENTRY *)catid_cache->hash_malloc(sizeof(CATID_ENTRY) + len);
+      memcpy(entry->key, key.c_str(), len + 1);
+      catid_cache->insert(entry->key, entry);
+   } else if (entry->id != id || strcmp(entry->info, NPRT(info)) != 0) {
+      entry->written = false;
+   }
+   entry->id = id;
+   entry->expires = time(NULL) + ttl;
+   bstrncpy(entry->info, info ? info : "", sizeof(entry->info));
+   V(catid_mutex);
+}
+
+/*
+ * The Client record is updated at each Job start with the Uname
+ *  sent by the FD.  If the same Director already wrote this Uname
+ *  since the last reload, the update can be skipped.
+ */
+bool is_client_record_current(JCR *jcr, const char *name, const char *uname)
+{
+   POOL_MEM key(PM_NAME);
+   CATID_ENTRY *entry;
+   bool current = false;
+
+   if (cache_time() == 0) {
+      return false;
+   }
+   make_key(key, jcr, CATID_CLIENT, name, NULL);
+   P(catid_mutex);
+   if ((entry = find_entry(key)) != NULL) {
+      current = entry->written && strcmp(entry->info, uname) == 0;
+   }
+   V(catid_mutex);
+   return current;
+}
+
+void set_client_record_current(JCR *jcr, const char *name, const char *uname)
+{
+   POOL_MEM key(PM_NAME);
+   CATID_ENTRY *entry;
+
+   if (cache_time() == 0) {
+      return;
+   }
+   make_key(key, jcr, CATID_CLIENT, name, NULL);
+   P(catid_mutex);
+   if ((entry = find_entry(key)) != NULL) {
+      bstrncpy(entry->info, uname, sizeof(entry->info));
+      entry->written = true;
+   }
+   V(catid_mutex);
+}
+
+/* Forget everything, the records may have changed */
+void flush_catalog_id_cache()
+{
+   P(catid_mutex);
+   if (catid_cache) {
+      Dmsg2(dbglvl, "Flush catalog id cache hits=%u misses=%u\n",
+            catid_hits, catid_misses);
+      catid_cache->destroy();
+      free(catid_cache);
+      catid_cache = NULL;
+   }
+   V(catid_mutex);
+}
+
+/* For the status command */
+int edit_catalog_id_cache_status(POOLMEM *&buf)
+{
+   char ed1[50], ed2[50];
+   int len;
+
+   *buf = 0;
+   if (cache_time() == 0) {
+      return 0;
+   }
+   P(catid_mutex);
+   len = Mmsg(buf, _(" Catalog id cache: entries=%d hits=%s misses=%s\n"),
+              catid_cache ? catid_cache->size() : 0,
+              edit_uint64_with_commas(catid_hits, ed1),
+              edit_uint64_with_commas(catid_misses, ed2));
+   V(catid_mutex);
+   return len;
+}
@@ -454,7 +454,8 @@ static void update_attribute(JCR *jcr, char *msg, int32_t msglen)
          jcr->cached_attribute = false;
       }
       /* Any cached attr is flushed so we can reuse jcr->attr and jcr->ar */
-      jcr->attr = check_pool_memory_size(jcr->attr, msglen);
+      /* Room after the message for the legacy form of a compact LStat */
+      jcr->attr = check_pool_memory_size(jcr->attr, msglen + MAXSTRING);
       memcpy(jcr->attr, msg, msglen);
       p = jcr->attr - msg + p;    /* point p into jcr->attr */
       skip_nonspaces(&p);         /* skip FileIndex */
@@ -478,6 +479,9 @@ static void update_attribute(JCR *jcr, char *msg, int32_t msglen)
          }
       }
 
+      if (stat_compact_to_legacy(attr, jcr->attr + msglen)) {
+         attr = jcr->attr + msglen;
+      }
       Dmsg2(400, "dird<stored: stream=%d %s\n", Stream, fname);
       Dmsg1(400, "dird<stored: attr=%s\n", attr);
       ar->attr = attr;
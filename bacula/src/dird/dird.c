@@ -98,23 +98,37 @@ static bool check_catalog(cat_op mode);
  *   not defined (other daemons), then writing the database
  *   is disabled.
  */
-static bool dir_sql_query(JCR *jcr, const char *cmd)
+/*
+ * The message delivery thread calls these with the connection the
+ *  Job had when the message was queued, while the Job may use it,
+ *  so take the catalog lock.
+ */
+static bool dir_sql_query(JCR *jcr, B_DB *mdb, const char *cmd)
 {
-   if (!jcr || !jcr->db || !jcr->db->is_connected()) {
+   bool ok;
+
+   if (!jcr || !mdb) {
       return false;
    }
-
-   return db_sql_query(jcr->db, cmd);
+   db_lock(mdb);
+   ok = mdb->is_connected() && db_sql_query(mdb, cmd);
+   db_unlock(mdb);
+   return ok;
 }
 
 static bool dir_sql_escape(JCR *jcr, B_DB *mdb, char *snew, char *old, int len)
 {
-   if (!jcr || !jcr->db || !jcr->db->is_connected()) {
+   bool ok;
+
+   if (!jcr || !mdb) {
       return false;
    }
-
-   db_escape_string(jcr, mdb, snew, old, len);
-   return true;
+   db_lock(mdb);
+   if ((ok = mdb->is_connected())) {
+      db_escape_string(jcr, mdb, snew, old, len);
+   }
+   db_unlock(mdb);
+   return ok;
 }
 
 static void usage()
@@ -324,6 +338,7 @@ int main (int argc, char *argv[])
    start_UA_server(director->DIRaddrs);
 
    start_watchdog();                  /* start network watchdog thread */
+   start_message_delivery();          /* start async message delivery thread */
 
    init_jcr_subsystem();              /* start JCR watchdogs etc. */
 
@@ -365,6 +380,7 @@ void terminate_dird(int sig)
    delete_pid_file(director->pid_directory, "bacula-dir", get_first_port_host_order(director->DIRaddrs));
    term_scheduler();
    term_job_server();
+   flush_catalog_id_cache();
    if (runjob) {
       free(runjob);
    }
@@ -543,6 +559,9 @@ void reload_config(int sig)
       endeach_jcr(jcr);
    }
 
+   /* Resources may have been renamed or changed */
+   flush_catalog_id_cache();
+
    /* Reset globals */
    set_working_directory(director->working_directory);
    FDConnectTimeout = director->FDConnectTimeout;
@@ -599,6 +618,7 @@ static bool check_resources()
             configfile);
          OK = false;
       }
+      set_tls_kernel_offload(director->tls_kernel_offload);
       /* tls_require implies tls_enable */
       if (director->tls_require) {
          if (have_tls) {
@@ -966,7 +986,8 @@ static bool check_catalog(cat_op mode)
                             catalog->db_password, catalog->db_address,
                             catalog->db_port, catalog->db_socket,
                             catalog->mult_db_connections,
-                            catalog->disable_batch_insert);
+                            catalog->disable_batch_insert,
+                            catalog->pool_size);
       if (!db || !db_open_database(NULL, db)) {
          Pmsg2(000, _("Could not open Catalog \"%s\", database \"%s\".\n"),
               catalog->name(), catalog->db_name);
@@ -58,6 +58,13 @@ struct del_ctx {
    int tot_ids;                       /* total to process */
 };
 
+/* Kinds of records in the catalog id cache, see catcache.c */
+enum {
+   CATID_CLIENT  = 0,
+   CATID_FILESET = 1,
+   CATID_POOL    = 2
+};
+
 /* Flags for find_next_volume_for_append() */
 enum {
   fnv_create_vol    = true,
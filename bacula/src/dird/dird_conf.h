@@ -120,6 +120,9 @@ public:
    bool tls_enable;                   /* Enable TLS */
    bool tls_require;                  /* Require TLS */
    bool tls_verify_peer;              /* TLS Verify Client Certificate */
+   bool tls_kernel_offload;           /* Let the kernel do the TLS encryption */
+   bool sched_lookahead;              /* Start longest Jobs of a priority first */
+   utime_t catalog_cache_time;        /* Keep Client/FileSet/Pool ids this long */
    char *verid;                       /* Custom Id to print in version command */
    /* Methods */
    char *name() const;
@@ -223,6 +226,7 @@ public:
    char *db_name;
    char *db_driver;                   /* Select appropriate driver */
    uint32_t mult_db_connections;      /* set if multiple connections wanted */
+   uint32_t pool_size;                /* max shared connections to the catalog */
    bool disable_batch_insert;         /* set if batch inserts should be disabled */
 
    /* Methods */
@@ -396,6 +400,7 @@ public:
    int32_t NumConcurrentJobs;         /* number of concurrent jobs running */
    uint32_t MaxSpawnedJobs;           /* Max Jobs that can be started by Migration/Copy */
    bool allow_mixed_priority;         /* Allow jobs with higher priority concurrently with this */
+   bool allow_backfill;               /* Allow to start ahead of higher priority jobs */
 
    MSGS      *messages;               /* How and where to send messages */
    SCHED     *schedule;               /* When -- Automatic schedule */
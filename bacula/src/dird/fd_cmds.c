@@ -134,9 +134,14 @@ int connect_to_file_daemon(JCR *jcr, int retry_interval, int max_retry_time,
           cr.FileRetention = jcr->client->FileRetention;
           cr.JobRetention = jcr->client->JobRetention;
           bstrncpy(cr.Uname, fd->msg+strlen(OKjob)+1, sizeof(cr.Uname));
-          if (!db_update_client_record(jcr, jcr->db, &cr)) {
+          /* Another Job may have written the same values already */
+          if (is_client_record_current(jcr, cr.Name, cr.Uname)) {
+             Dmsg1(100, "Client record %s is up to date\n", cr.Name);
+          } else if (!db_update_client_record(jcr, jcr->db, &cr)) {
              Jmsg(jcr, M_WARNING, 0, _("Error updating Client record. ERR=%s\n"),
                 db_strerror(jcr->db));
+          } else {
+             set_client_record_current(jcr, cr.Name, cr.Uname);
           }
        }
    } else {
@@ -117,6 +117,8 @@ static RES_ITEM options_items[] = {
    {"strippath",       store_opts,    {0},     0, 0, 0},
    {"honornodumpflag", store_opts,    {0},     0, 0, 0},
    {"xattrsupport",    store_opts,    {0},     0, 0, 0},
+   {"compactattributes", store_opts,  {0},     0, 0, 0},
+   {"dedupmetadata",   store_opts,    {0},     0, 0, 0},
    {NULL, NULL, {0}, 0, 0, 0}
 };
 
@@ -148,7 +150,9 @@ enum {
    INC_KW_CHKCHANGES,
    INC_KW_STRIPPATH,
    INC_KW_HONOR_NODUMP,
-   INC_KW_XATTR
+   INC_KW_XATTR,
+   INC_KW_COMPACT_ATTR,
+   INC_KW_DEDUP_METADATA
 };
 
 /*
@@ -183,6 +187,8 @@ static struct s_kw FS_option_kw[] = {
    {"strippath",   INC_KW_STRIPPATH},
    {"honornodumpflag", INC_KW_HONOR_NODUMP},
    {"xattrsupport", INC_KW_XATTR},
+   {"compactattributes", INC_KW_COMPACT_ATTR},
+   {"dedupmetadata", INC_KW_DEDUP_METADATA},
    {NULL,          0}
 };
 
@@ -255,6 +261,10 @@ static struct s_fs_opt FS_options[] = {
    {"no",       INC_KW_HONOR_NODUMP,  "0"},
    {"yes",      INC_KW_XATTR,         "X"},
    {"no",       INC_KW_XATTR,         "0"},
+   {"yes",      INC_KW_COMPACT_ATTR,  "L"},
+   {"no",       INC_KW_COMPACT_ATTR,  "0"},
+   {"yes",      INC_KW_DEDUP_METADATA, "Q"},
+   {"no",       INC_KW_DEDUP_METADATA, "0"},
    {NULL,       0,                      0}
 };
 
@@ -31,6 +31,7 @@ static void job_monitor_destructor(watchdog_t *self);
 static bool job_check_maxwaittime(JCR *jcr);
 static bool job_check_maxruntime(JCR *jcr);
 static bool job_check_maxrunschedtime(JCR *jcr);
+static void estimate_job_run_time(JCR *jcr);
 
 /* Imported subroutines */
 extern void term_scheduler();
@@ -116,13 +117,16 @@ bool setup_job(JCR *jcr)
                               jcr->catalog->db_user, jcr->catalog->db_password,
                               jcr->catalog->db_address, jcr->catalog->db_port,
                               jcr->catalog->db_socket, jcr->catalog->mult_db_connections,
-                              jcr->catalog->disable_batch_insert);
+                              jcr->catalog->disable_batch_insert,
+                              jcr->catalog->pool_size);
    if (!jcr->db || !db_open_database(jcr, jcr->db)) {
       Jmsg(jcr, M_FATAL, 0, _("Could not open database \"%s\".\n"),
                  jcr->catalog->db_name);
       if (jcr->db) {
          Jmsg(jcr, M_FATAL, 0, "%s", db_strerror(jcr->db));
+         wait_message_delivery(jcr);
          db_close_database(jcr, jcr->db);
+         jcr->db = NULL;
       }
       goto bail_out;
    }
@@ -224,6 +228,7 @@ bool setup_job(JCR *jcr)
       goto bail_out;
    }
 
+   estimate_job_run_time(jcr);
    generate_plugin_event(jcr, bDirEventJobInit);
    Dsm_check(100);
    return true;
@@ -232,6 +237,61 @@ bail_out:
    return false;
 }
 
+struct est_run_ctx {
+   utime_t total;                     /* sum of run times */
+   int count;                         /* number of jobs */
+};
+
+static int est_run_time_handler(void *ctx, int num_fields, char **row)
+{
+   est_run_ctx *est = (est_run_ctx *)ctx;
+   utime_t start, end;
+
+   if (num_fields < 2 || !row[0] || !row[1]) {
+      return 0;
+   }
+   start = str_to_utime(row[0]);
+   end = str_to_utime(row[1]);
+   if (start > 0 && end > start) {
+      est->total += end - start;
+      est->count++;
+   }
+   return 0;
+}
+
+/*
+ * Estimate the run time of the job from the last good runs
+ *  of the same Job at the same level. The job queue uses it
+ *  to start the longest jobs of a priority first.
+ */
+static void estimate_job_run_time(JCR *jcr)
+{
+   POOL_MEM query, esc;
+   est_run_ctx est;
+   char ed1[50];
+   int len = strlen(jcr->job->name());
+
+   est.total = 0;
+   est.count = 0;
+   jcr->est_run_time = 0;
+   if (!director->sched_lookahead || !jcr->db) {
+      return;                         /* only used by Scheduler Lookahead */
+   }
+   esc.check_size(len * 2 + 1);
+   db_escape_string(jcr, jcr->db, esc.c_str(), jcr->job->name(), len);
+   Mmsg(query, "SELECT StartTime, EndTime FROM Job WHERE Name='%s' "
+        "AND Type='%c' AND Level='%c' AND JobStatus IN ('T','W') AND JobId<>%s "
+        "ORDER BY JobTDate DESC LIMIT 5",
+        esc.c_str(), jcr->getJobType(), jcr->getJobLevel(),
+        edit_int64(jcr->JobId, ed1));
+   if (db_sql_query(jcr->db, query.c_str(), est_run_time_handler, &est) &&
+       est.count > 0) {
+      jcr->est_run_time = est.total / est.count;
+   }
+   Dmsg3(100, "JobId=%d estimated run time=%lld from %d jobs\n",
+         jcr->JobId, jcr->est_run_time, est.count);
+}
+
 void update_job_end(JCR *jcr, int TermCode)
 {
    dequeue_messages(jcr);             /* display any queued messages */
@@ -796,6 +856,9 @@ DBId_t get_or_create_pool_record(JCR *jcr, char *pool_name)
    bstrncpy(pr.Name, pool_name, sizeof(pr.Name));
    Dmsg1(110, "get_or_create_pool=%s\n", pool_name);
 
+   if (get_cached_catalog_id(jcr, CATID_POOL, pr.Name, NULL, &pr.PoolId, NULL, 0)) {
+      return pr.PoolId;
+   }
    while (!db_get_pool_record(jcr, jcr->db, &pr)) { /* get by Name */
       /* Try to create the pool */
       if (create_pool(jcr, jcr->db, jcr->pool, POOL_OP_CREATE) < 0) {
@@ -806,6 +869,7 @@ DBId_t get_or_create_pool_record(JCR *jcr, char *pool_name)
          Jmsg(jcr, M_INFO, 0, _("Created database record for Pool \"%s\".\n"), pr.Name);
       }
    }
+   cache_catalog_id(jcr, CATID_POOL, pr.Name, NULL, pr.PoolId, NULL);
    return pr.PoolId;
 }
 
@@ -1065,10 +1129,14 @@ bool get_or_create_client_record(JCR *jcr)
       jcr->client_name = get_pool_memory(PM_NAME);
    }
    pm_strcpy(jcr->client_name, jcr->client->hdr.name);
-   if (!db_create_client_record(jcr, jcr->db, &cr)) {
-      Jmsg(jcr, M_FATAL, 0, _("Could not create Client record. ERR=%s\n"),
-         db_strerror(jcr->db));
-      return false;
+   if (!get_cached_catalog_id(jcr, CATID_CLIENT, cr.Name, NULL, &cr.ClientId,
+                              cr.Uname, sizeof(cr.Uname))) {
+      if (!db_create_client_record(jcr, jcr->db, &cr)) {
+         Jmsg(jcr, M_FATAL, 0, _("Could not create Client record. ERR=%s\n"),
+            db_strerror(jcr->db));
+         return false;
+      }
+      cache_catalog_id(jcr, CATID_CLIENT, cr.Name, NULL, cr.ClientId, cr.Uname);
    }
    jcr->jr.ClientId = cr.ClientId;
    if (cr.Uname[0]) {
@@ -1088,6 +1156,7 @@ bool get_or_create_client_record(JCR *jcr)
 bool get_or_create_fileset_record(JCR *jcr)
 {
    FILESET_DBR fsr;
+   const char *md5;
 
    memset(&fsr, 0, sizeof(FILESET_DBR));
    bstrncpy(fsr.FileSet, jcr->fileset->hdr.name, sizeof(fsr.FileSet));
@@ -1105,13 +1174,22 @@ bool get_or_create_fileset_record(JCR *jcr)
    } else {
       Jmsg(jcr, M_WARNING, 0, _("FileSet MD5 digest not found.\n"));
    }
-   if (!jcr->fileset->ignore_fs_changes ||
-       !db_get_fileset_record(jcr, jcr->db, &fsr)) {
-      if (!db_create_fileset_record(jcr, jcr->db, &fsr)) {
-         Jmsg(jcr, M_ERROR, 0, _("Could not create FileSet \"%s\" record. ERR=%s\n"),
-            fsr.FileSet, db_strerror(jcr->db));
-         return false;
+   /* With ignore_fs_changes, any FileSet record with this name is OK */
+   md5 = jcr->fileset->ignore_fs_changes ? "*any*" : fsr.MD5;
+   if (get_cached_catalog_id(jcr, CATID_FILESET, fsr.FileSet, md5, &fsr.FileSetId,
+                             fsr.cCreateTime, sizeof(fsr.cCreateTime))) {
+      /* Nothing to do */
+   } else {
+      if (!jcr->fileset->ignore_fs_changes ||
+          !db_get_fileset_record(jcr, jcr->db, &fsr)) {
+         if (!db_create_fileset_record(jcr, jcr->db, &fsr)) {
+            Jmsg(jcr, M_ERROR, 0, _("Could not create FileSet \"%s\" record. ERR=%s\n"),
+               fsr.FileSet, db_strerror(jcr->db));
+            return false;
+         }
       }
+      cache_catalog_id(jcr, CATID_FILESET, fsr.FileSet, md5, fsr.FileSetId,
+                       fsr.cCreateTime);
    }
    jcr->jr.FileSetId = fsr.FileSetId;
    bstrncpy(jcr->FSCreateTime, fsr.cCreateTime, sizeof(jcr->FSCreateTime));
@@ -1260,6 +1338,7 @@ void dird_free_jcr(JCR *jcr)
       jcr->batch_started = false;
    }
    if (jcr->db) {
+      wait_message_delivery(jcr);
       db_close_database(jcr, jcr->db);
       jcr->db = NULL;
    }
@@ -45,6 +45,7 @@ static int  start_server(jobq_t *jq);
 static bool acquire_resources(JCR *jcr);
 static bool reschedule_job(JCR *jcr, jobq_t *jq, jobq_item_t *je);
 static void dec_write_store(JCR *jcr);
+static bool can_backfill(JCR *jcr, alist *blocked);
 
 /*
  * Initialize a job queue
@@ -83,6 +84,8 @@ int jobq_init(jobq_t *jq, int threads, void *(*engine)(void *arg))
    jq->max_workers = threads;         /* max threads to create */
    jq->num_workers = 0;               /* no threads yet */
    jq->idle_workers = 0;              /* no idle threads */
+   jq->num_reordered = 0;
+   jq->num_backfilled = 0;
    jq->engine = engine;               /* routine to run */
    jq->valid = JOBQ_VALID;
    /* Initialize the job queues */
@@ -242,12 +245,19 @@ int jobq_add(jobq_t *jq, JCR *jcr)
 
    /* While waiting in a queue this job is not attached to a thread */
    set_jcr_in_tsd(INVALID_JCR);
+   jcr->backfilled = false;
    if (job_canceled(jcr)) {
       /* Add job to ready queue so that it is canceled quickly */
       jq->ready_jobs->prepend(item);
       Dmsg1(2300, "Prepended job=%d to ready queue\n", jcr->JobId);
    } else {
-      /* Add this job to the wait queue in priority sorted order */
+      /*
+       * Add this job to the wait queue in priority sorted order.
+       *  With Scheduler Lookahead, jobs of the same priority are
+       *  sorted by estimated run time, longest first, so that
+       *  short jobs fill the devices at the end of the window
+       *  instead of a long job starting last.
+       */
       foreach_dlist(li, jq->waiting_jobs) {
          Dmsg2(2300, "waiting item jobid=%d priority=%d\n",
             li->jcr->JobId, li->jcr->JobPriority);
@@ -258,6 +268,16 @@ int jobq_add(jobq_t *jq, JCR *jcr)
             inserted = true;
             break;
          }
+         if (director->sched_lookahead &&
+             li->jcr->JobPriority == jcr->JobPriority &&
+             li->jcr->est_run_time < jcr->est_run_time) {
+            jq->waiting_jobs->insert_before(item, li);
+            jq->num_reordered++;
+            Dmsg4(2300, "lookahead jobid=%d est=%lld before jobid=%d est=%lld\n",
+               jcr->JobId, jcr->est_run_time, li->jcr->JobId, li->jcr->est_run_time);
+            inserted = true;
+            break;
+         }
       }
       /* If not jobs in wait queue, append it */
       if (!inserted) {
@@ -320,6 +340,44 @@ int jobq_remove(jobq_t *jq, JCR *jcr)
 }
 
 
+/*
+ * Get a snapshot of the job queue for status output
+ */
+void jobq_get_status(jobq_t *jq, jobq_status_t *st)
+{
+   memset(st, 0, sizeof(jobq_status_t));
+   if (jq->valid != JOBQ_VALID) {
+      return;
+   }
+   P(jq->mutex);
+   st->waiting = jq->waiting_jobs->size();
+   st->ready = jq->ready_jobs->size();
+   st->running = jq->running_jobs->size();
+   st->max_workers = jq->max_workers;
+   st->num_reordered = jq->num_reordered;
+   st->num_backfilled = jq->num_backfilled;
+   V(jq->mutex);
+}
+
+/*
+ * Call fn for each job of the waiting queue, in the order the
+ *  queue will try them.  The queue is locked, so fn must not
+ *  block nor call back into the queue.
+ */
+void jobq_foreach_waiting(jobq_t *jq, void (*fn)(JCR *jcr, void *ctx), void *ctx)
+{
+   jobq_item_t *item;
+
+   if (jq->valid != JOBQ_VALID) {
+      return;
+   }
+   P(jq->mutex);
+   foreach_dlist(item, jq->waiting_jobs) {
+      fn(item->jcr, ctx);
+   }
+   V(jq->mutex);
+}
+
 /*
  * Start the server thread if it isn't already running
  */
@@ -489,35 +547,46 @@ void *jobq_server(void *arg)
          bool running_allow_mix = false;
          je = (jobq_item_t *)jq->waiting_jobs->first();
          jobq_item_t *re = (jobq_item_t *)jq->running_jobs->first();
+         /*
+          * The reference Priority is the most urgent one (lowest value)
+          *   of the running jobs that were not backfilled, a backfilled
+          *   job must not lower the priority of the queue.
+          */
+         Priority = je->jcr->JobPriority;
          if (re) {
-            Priority = re->jcr->JobPriority;
-            Dmsg2(2300, "JobId %d is running. Look for pri=%d\n",
-                  re->jcr->JobId, Priority);
+            bool found = false;
             running_allow_mix = true;
-            for ( ; re; ) {
-               Dmsg2(2300, "JobId %d is also running with %s\n",
+            for ( ; re; re = (jobq_item_t *)jq->running_jobs->next(re)) {
+               Dmsg3(2300, "JobId %d is running with %s%s\n",
                      re->jcr->JobId,
-                     re->jcr->job->allow_mixed_priority ? "mix" : "no mix");
+                     re->jcr->job->allow_mixed_priority ? "mix" : "no mix",
+                     re->jcr->backfilled ? " (backfill)" : "");
                if (!re->jcr->job->allow_mixed_priority) {
                   running_allow_mix = false;
-                  break;
                }
-               re = (jobq_item_t *)jq->running_jobs->next(re);
+               if (!re->jcr->backfilled && (!found || re->jcr->JobPriority < Priority)) {
+                  Priority = re->jcr->JobPriority;
+                  found = true;
+               }
             }
-            Dmsg1(2300, "The running job(s) %s mixing priorities.\n",
-                  running_allow_mix ? "allow" : "don't allow");
+            Dmsg2(2300, "The running job(s) %s mixing priorities. Look for pri=%d\n",
+                  running_allow_mix ? "allow" : "don't allow", Priority);
          } else {
-            Priority = je->jcr->JobPriority;
             Dmsg1(2300, "No job running. Look for Job pri=%d\n", Priority);
          }
          /*
           * Walk down the list of waiting jobs and attempt
-          *   to acquire the resources it needs.
+          *   to acquire the resources it needs. The jobs
+          *   that cannot start are kept in blocked, so that
+          *   a lower priority job that allows backfill can
+          *   check that it does not get in their way.
           */
+         alist blocked(10, not_owned_by_alist);
          for ( ; je;  ) {
             /* je is current job item on the queue, jn is the next one */
             JCR *jcr = je->jcr;
             jobq_item_t *jn = (jobq_item_t *)jq->waiting_jobs->next(je);
+            bool backfill = false;
 
             Dmsg4(2300, "Examining Job=%d JobPri=%d want Pri=%d (%s)\n",
                   jcr->JobId, jcr->JobPriority, Priority,
@@ -528,16 +597,41 @@ void *jobq_server(void *arg)
                   || (jcr->JobPriority < Priority &&
                       jcr->job->allow_mixed_priority && running_allow_mix))) {
                jcr->setJobStatus(JS_WaitPriority);
-               break;
+               /*
+                * Only a job of lower priority (larger value) can be
+                *   backfilled. Stop here as before for a more urgent
+                *   job or when there are no more workers to spare.
+                */
+               if (jcr->JobPriority < Priority ||
+                   jq->running_jobs->size() + jq->ready_jobs->size() +
+                   blocked.size() + 1 > jq->max_workers) {
+                  break;
+               }
+               if (!can_backfill(jcr, &blocked)) {
+                  blocked.append(jcr);
+                  je = jn;
+                  continue;
+               }
+               backfill = true;
             }
 
             if (!acquire_resources(jcr)) {
                /* If resource conflict, job is canceled */
                if (!job_canceled(jcr)) {
+                  if (backfill) {
+                     jcr->setJobStatus(JS_WaitPriority);
+                  }
+                  blocked.append(jcr);
                   je = jn;            /* point to next waiting job */
                   continue;
                }
             }
+            if (backfill && !job_canceled(jcr)) {
+               jcr->backfilled = true;
+               jq->num_backfilled++;
+               Jmsg(jcr, M_INFO, 0, _("Job %s started ahead of higher priority jobs (backfill).\n"),
+                    jcr->Job);
+            }
 
             /*
              * Got all locks, now remove it from wait queue and append it
@@ -802,6 +896,43 @@ static bool acquire_resources(JCR *jcr)
    return true;
 }
 
+/*
+ * A job with Allow Backfill may start before the jobs of higher
+ *  priority are done, but only if it uses none of the Storage,
+ *  Client or Job resources that a waiting job of higher priority
+ *  is waiting for, so that it cannot delay it. The caller makes
+ *  sure that a worker remains for each of the blocked jobs.
+ *
+ *  Returns: true  if the job may start now
+ *           false if it must wait for its priority
+ */
+static bool can_backfill(JCR *jcr, alist *blocked)
+{
+   JCR *bjcr;
+
+   if (!jcr->job->allow_backfill || job_canceled(jcr)) {
+      return false;
+   }
+   foreach_alist(bjcr, blocked) {
+      if (bjcr->JobPriority >= jcr->JobPriority) {
+         continue;
+      }
+      if (bjcr->job == jcr->job ||
+          (bjcr->client && bjcr->client == jcr->client)) {
+         Dmsg2(200, "No backfill for JobId=%d, Client/Job used by JobId=%d\n",
+               jcr->JobId, bjcr->JobId);
+         return false;
+      }
+      if ((jcr->wstore && (jcr->wstore == bjcr->wstore || jcr->wstore == bjcr->rstore)) ||
+          (jcr->rstore && (jcr->rstore == bjcr->wstore || jcr->rstore == bjcr->rstore))) {
+         Dmsg2(200, "No backfill for JobId=%d, Storage used by JobId=%d\n",
+               jcr->JobId, bjcr->JobId);
+         return false;
+      }
+   }
+   return true;
+}
+
 static pthread_mutex_t rstore_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 /*
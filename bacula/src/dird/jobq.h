@@ -51,9 +51,23 @@ struct jobq_t {
    int               max_workers;     /* max threads */
    int               num_workers;     /* current threads */
    int               idle_workers;    /* idle threads */
+   uint32_t          num_reordered;   /* jobs queued ahead of shorter ones */
+   uint32_t          num_backfilled;  /* jobs started ahead of their priority */
    void             *(*engine)(void *arg); /* user engine */
 };
 
+/*
+ * Snapshot of the queue for status output
+ */
+struct jobq_status_t {
+   int               waiting;         /* jobs in waiting queue */
+   int               ready;           /* jobs in ready queue */
+   int               running;         /* jobs running */
+   int               max_workers;     /* max threads */
+   uint32_t          num_reordered;   /* jobs queued ahead of shorter ones */
+   uint32_t          num_backfilled;  /* jobs started ahead of their priority */
+};
+
 #define JOBQ_VALID  0xdec1993
 
 extern int jobq_init(
@@ -64,5 +78,8 @@ extern int jobq_init(
 extern int jobq_destroy(jobq_t *wq);
 extern int jobq_add(jobq_t *wq, JCR *jcr);
 extern int jobq_remove(jobq_t *wq, JCR *jcr);
+extern void jobq_get_status(jobq_t *wq, jobq_status_t *st);
+extern void jobq_foreach_waiting(jobq_t *wq, void (*fn)(JCR *jcr, void *ctx),
+                                 void *ctx);
 
 #endif /* __JOBQ_H */
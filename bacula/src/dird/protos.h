@@ -54,6 +54,16 @@ extern bool send_client_addr_to_sd(JCR *jcr);
 extern bool send_store_addr_to_fd(JCR *jcr, STORE *store,
                char *store_address, uint32_t store_port);
 
+/* catcache.c */
+extern bool get_cached_catalog_id(JCR *jcr, int kind, const char *name, const char *md5,
+              DBId_t *id, char *info, int info_len);
+extern void cache_catalog_id(JCR *jcr, int kind, const char *name, const char *md5,
+              DBId_t id, const char *info);
+extern bool is_client_record_current(JCR *jcr, const char *name, const char *uname);
+extern void set_client_record_current(JCR *jcr, const char *name, const char *uname);
+extern void flush_catalog_id_cache();
+extern int edit_catalog_id_cache_status(POOLMEM *&buf);
+
 /* vbackup.c */
 extern bool do_vbackup_init(JCR *jcr);
 extern bool do_vbackup(JCR *jcr);
@@ -65,6 +75,8 @@ RBSR *new_bsr();
 void free_bsr(RBSR *bsr);
 bool complete_bsr(UAContext *ua, RBSR *bsr);
 uint32_t write_bsr_file(UAContext *ua, RESTORE_CTX &rx);
+int split_bsr_by_volume(RESTORE_CTX &rx, int max_parts);
+uint32_t write_bsr_part_file(UAContext *ua, RESTORE_CTX &rx, int part);
 void display_bsr_info(UAContext *ua, RESTORE_CTX &rx);
 void add_findex(RBSR *bsr, uint32_t JobId, int32_t findex);
 void add_findex_all(RBSR *bsr, uint32_t JobId);
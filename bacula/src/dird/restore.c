@@ -466,6 +466,10 @@ bool restore_bootstrap(JCR *jcr)
          if (!send_runscripts_commands(jcr)) {
             goto bail_out;
          }
+         /* Plugin objects and the ACL/xattr dictionary */
+         if (!send_restore_objects(jcr)) {
+            goto bail_out;
+         }
       }
 
       fd->fsend("%s", restore_cmd.c_str());
@@ -113,6 +113,9 @@ struct RESTORE_CTX {
    char *RegexWhere;
    char *replace;
    RBSR *bsr;
+   RBSR_VOLPART *vol_parts;           /* Volume to part map for split restore */
+   int num_vol_parts;                 /* entries in vol_parts */
+   int drives;                        /* max drives to read with, 0 = one */
    POOLMEM *fname;                    /* filename only */
    POOLMEM *path;                     /* path only */
    POOLMEM *query;
@@ -101,7 +101,7 @@ static struct cmdstruct commands[] = {                                      /* C
  { NT_("disable"),    disable_cmd,   _("Disable a job, attributes batch process"), NT_("job=<name> | batch"),  true},
  { NT_("enable"),     enable_cmd,    _("Enable a job, attributes batch process"), NT_("job=<name> | batch"),   true},
  { NT_("estimate"),   estimate_cmd,  _("Performs FileSet estimate, listing gives full listing"),
-   NT_("fileset=<fs> client=<cli> level=<level> accurate=<yes/no> job=<job> listing"), true},
+   NT_("fileset=<fs> client=<cli> level=<level> accurate=<yes/no> job=<job> listing fast"), true},
 
  { NT_("exit"),       quit_cmd,      _("Terminate Bconsole session"), NT_(""),         false},
  { NT_("gui"),        gui_cmd,       _("Non-interactive gui mode"),   NT_("on | off"), false},
@@ -132,7 +132,7 @@ static struct cmdstruct commands[] = {                                      /* C
  { NT_("restore"),    restore_cmd,   _("Restore files"),
    NT_("where=</path> client=<client> storage=<storage> bootstrap=<file> "
        "restorejob=<job>"
-       "\n\tcomment=<text> jobid=<jobid> copies done select all"), false},
+       "\n\tcomment=<text> jobid=<jobid> drives=<n> copies done select all"), false},
 
  { NT_("relabel"),    relabel_cmd,   _("Relabel a tape"),
    NT_("storage=<storage-name> oldvolume=<old-volume-name>\n\tvolume=<newvolume-name> pool=<pool>"), false},
@@ -1168,6 +1168,7 @@ static int estimate_cmd(UAContext *ua, const char *cmd)
    CLIENT *client = NULL;
    FILESET *fileset = NULL;
    int listing = 0;
+   int fast = 0;
    char since[MAXSTRING];
    JCR *jcr = ua->jcr;
    int accurate=-1;
@@ -1231,6 +1232,10 @@ static int estimate_cmd(UAContext *ua, const char *cmd)
          listing = 1;
          continue;
       }
+      if (strcasecmp(ua->argk[i], NT_("fast")) == 0) {
+         fast = 1;
+         continue;
+      }
       if (strcasecmp(ua->argk[i], NT_("level")) == 0) {
          if (ua->argv[i]) {
             if (!get_level_from_name(ua->jcr, ua->argv[i])) {
@@ -1341,7 +1346,7 @@ static int estimate_cmd(UAContext *ua, const char *cmd)
       goto bail_out;
    }
 
-   jcr->file_bsock->fsend("estimate listing=%d\n", listing);
+   jcr->file_bsock->fsend("estimate listing=%d fast=%d\n", listing, fast);
    while (jcr->file_bsock->recv() >= 0) {
       ua->send_msg("%s", jcr->file_bsock->msg);
    }
@@ -1556,6 +1561,7 @@ static int delete_pool(UAContext *ua)
    }
    if (ua->pint32_val) {
       db_delete_pool_record(ua->jcr, ua->db, &pr);
+      flush_catalog_id_cache();
    }
    return 1;
 }
@@ -2078,7 +2084,8 @@ bool open_db(UAContext *ua)
                              ua->catalog->db_user,
                              ua->catalog->db_password, ua->catalog->db_address,
                              ua->catalog->db_port, ua->catalog->db_socket,
-                             mult_db_conn, ua->catalog->disable_batch_insert);
+                             mult_db_conn, ua->catalog->disable_batch_insert,
+                             ua->catalog->pool_size);
    if (!ua->db || !db_open_database(ua->jcr, ua->db)) {
       ua->error_msg(_("Could not open catalog database \"%s\".\n"),
                  ua->catalog->db_name);
@@ -2108,6 +2115,7 @@ bool open_db(UAContext *ua)
 void close_db(UAContext *ua)
 {
    if (ua->jcr) {
+      wait_message_delivery(ua->jcr);  /* catalog messages use jcr->db */
       ua->jcr->db = NULL;
    }
 
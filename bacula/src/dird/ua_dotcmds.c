@@ -43,6 +43,7 @@ extern bool dot_status_cmd(UAContext *ua, const char *cmd);
 
 /* Forward referenced functions */
 static bool admin_cmds(UAContext *ua, const char *cmd);
+static bool profile_cmd(UAContext *ua, const char *cmd);
 static bool jobscmd(UAContext *ua, const char *cmd);
 static bool filesetscmd(UAContext *ua, const char *cmd);
 static bool clientscmd(UAContext *ua, const char *cmd);
@@ -97,6 +98,7 @@ static struct cmdstruct commands[] = { /* help */  /* can be used in runscript *
  { NT_(".messages"),   getmsgscmd,               NULL,       false},
  { NT_(".msgs"),       msgscmd,                  NULL,       false},
  { NT_(".pools"),      poolscmd,                 NULL,       true},
+ { NT_(".profile"),    profile_cmd,              NULL,       false},
  { NT_(".quit"),       dot_quit_cmd,             NULL,       false},
  { NT_(".putfile"),    putfile_cmd,              NULL,       false}, /* use @putfile */
  { NT_(".schedule"),   schedulescmd,             NULL,       false},
@@ -822,7 +824,6 @@ static bool getmsgscmd(UAContext *ua, const char *cmd)
    return 1;
 }
 
-#ifdef DEVELOPER
 static void do_storage_cmd(UAContext *ua, STORE *store, const char *cmd)
 {
    BSOCK *sd;
@@ -875,6 +876,100 @@ static void do_client_cmd(UAContext *ua, CLIENT *client, const char *cmd)
    return;
 }
 
+/*
+ * Sampling profiler, see lib/profiler.c
+ *
+ *   .profile [dir | client=<name> | storage=<name>] start [hz=<n>] [jobid=<n>]
+ *   .profile [dir | client=<name> | storage=<name>] stop
+ *   .profile [dir | client=<name> | storage=<name>] status
+ *
+ *  The folded stacks are written in the working directory of the
+ *  daemon when the profiler is stopped.
+ */
+static bool profile_cmd(UAContext *ua, const char *cmd)
+{
+   STORE *store=NULL;
+   CLIENT *client=NULL;
+   bool dir=false;
+   const char *action=NULL;
+   POOL_MEM remote_cmd(PM_MESSAGE), msg(PM_MESSAGE);
+   int hz=0;
+   uint32_t JobId=0;
+   int i;
+
+   for (i=1; i<ua->argc; i++) {
+      if (strcasecmp(ua->argk[i], "dir") == 0 ||
+          strcasecmp(ua->argk[i], "director") == 0) {
+         dir = true;
+
+      } else if (strcasecmp(ua->argk[i], "client") == 0 ||
+                 strcasecmp(ua->argk[i], "fd") == 0) {
+         client = NULL;
+         if (ua->argv[i]) {
+            client = (CLIENT *)GetResWithName(R_CLIENT, ua->argv[i]);
+         }
+         if (!client) {
+            client = select_client_resource(ua);
+         }
+
+      } else if (strcasecmp(ua->argk[i], NT_("store")) == 0 ||
+                 strcasecmp(ua->argk[i], NT_("storage")) == 0 ||
+                 strcasecmp(ua->argk[i], NT_("sd")) == 0) {
+         store = NULL;
+         if (ua->argv[i]) {
+            store = (STORE *)GetResWithName(R_STORAGE, ua->argv[i]);
+         }
+         if (!store) {
+            store = get_storage_resource(ua, false/*no default*/);
+         }
+
+      } else if (strcasecmp(ua->argk[i], "start") == 0) {
+         action = "start";
+
+      } else if (strcasecmp(ua->argk[i], "stop") == 0) {
+         action = "stop";
+
+      } else if (strcasecmp(ua->argk[i], "status") == 0) {
+         action = "status";
+
+      } else if (strcasecmp(ua->argk[i], "hz") == 0 && ua->argv[i]) {
+         hz = atoi(ua->argv[i]);
+
+      } else if (strcasecmp(ua->argk[i], "jobid") == 0 && ua->argv[i]) {
+         JobId = str_to_int64(ua->argv[i]);
+      }
+   }
+
+   if (!action) {
+      ua->error_msg(_("Usage: .profile [dir | client=<name> | storage=<name>] "
+                      "start [hz=<n>] [jobid=<n>] | stop | status\n"));
+      return true;
+   }
+   if (strcmp(action, "start") == 0) {
+      Mmsg(remote_cmd, "profile start hz=%d jobid=%u\n", hz, JobId);
+   } else {
+      Mmsg(remote_cmd, "profile %s\n", action);
+   }
+   if (!store && !client) {
+      dir = true;
+   }
+
+   if (store) {
+      do_storage_cmd(ua, store, remote_cmd.c_str());
+   }
+
+   if (client) {
+      do_client_cmd(ua, client, remote_cmd.c_str());
+   }
+
+   if (dir) {
+      profiler_command(remote_cmd.c_str(), msg.addr());
+      ua->send_msg("%s", msg.c_str());
+   }
+   return true;
+}
+
+#ifdef DEVELOPER
 /*
  *   .die (seg fault)
  *   .dump (sm_dump)
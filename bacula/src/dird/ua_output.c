@@ -574,6 +574,7 @@ static bool list_nextvol(UAContext *ua, int ndays)
 
 get_out:
    if (jcr->db) {
+      wait_message_delivery(jcr);
       db_close_database(jcr, jcr->db);
       jcr->db = NULL;
    }
@@ -699,6 +700,7 @@ bool complete_jcr_for_job(JCR *jcr, JOB *job, POOL *pool)
    }
    if (jcr->db) {
       Dmsg0(100, "complete_jcr close db\n");
+      wait_message_delivery(jcr);
       db_close_database(jcr, jcr->db);
       jcr->db = NULL;
    }
@@ -709,12 +711,14 @@ bool complete_jcr_for_job(JCR *jcr, JOB *job, POOL *pool)
                               jcr->catalog->db_password, jcr->catalog->db_address,
                               jcr->catalog->db_port, jcr->catalog->db_socket,
                               jcr->catalog->mult_db_connections,
-                              jcr->catalog->disable_batch_insert);
+                              jcr->catalog->disable_batch_insert,
+                              jcr->catalog->pool_size);
    if (!jcr->db || !db_open_database(jcr, jcr->db)) {
       Jmsg(jcr, M_FATAL, 0, _("Could not open database \"%s\".\n"),
                  jcr->catalog->db_name);
       if (jcr->db) {
          Jmsg(jcr, M_FATAL, 0, "%s", db_strerror(jcr->db));
+         wait_message_delivery(jcr);
          db_close_database(jcr, jcr->db);
          jcr->db = NULL;
       }
@@ -727,6 +731,7 @@ bool complete_jcr_for_job(JCR *jcr, JOB *job, POOL *pool)
          Jmsg(jcr, M_FATAL, 0, _("Pool %s not in database. %s"), pr.Name,
             db_strerror(jcr->db));
          if (jcr->db) {
+            wait_message_delivery(jcr);
             db_close_database(jcr, jcr->db);
             jcr->db = NULL;
          }
@@ -64,9 +64,10 @@ static void get_and_display_basejobs(UAContext *ua, RESTORE_CTX *rx);
 int restore_cmd(UAContext *ua, const char *cmd)
 {
    RESTORE_CTX rx;                    /* restore context */
-   POOL_MEM buf;
+   POOL_MEM buf, opts;
    JOB *job;
-   int i;
+   int i, nparts = 1;
+   bool yes, user_bsr;
    JCR *jcr = ua->jcr;
    char *escaped_bsr_name = NULL;
    char *escaped_where_name = NULL;
@@ -124,6 +125,9 @@ int restore_cmd(UAContext *ua, const char *cmd)
       } else if (strcasecmp(ua->argk[i], "regexwhere") == 0) {
          rx.RegexWhere = ua->argv[i];
 
+      } else if (strcasecmp(ua->argk[i], "drives") == 0) {
+         rx.drives = str_to_int64(ua->argv[i]);
+
       } else if (strcasecmp(ua->argk[i], "optimizespeed") == 0) {
          if (strcasecmp(ua->argv[i], "0") || strcasecmp(ua->argv[i], "no") ||
              strcasecmp(ua->argv[i], "false")) {
@@ -233,21 +237,11 @@ int restore_cmd(UAContext *ua, const char *cmd)
    }
    get_restore_client_name(ua, rx);
 
-   escaped_bsr_name = escape_filename(jcr->RestoreBootstrap);
-
-   Mmsg(ua->cmd,
-        "run job=\"%s\" client=\"%s\" restoreclient=\"%s\" storage=\"%s\""
-        " bootstrap=\"%s\" files=%u catalog=\"%s\"",
-        job->name(), rx.ClientName, rx.RestoreClientName,
-        rx.store?rx.store->name():"",
-        escaped_bsr_name ? escaped_bsr_name : jcr->RestoreBootstrap,
-        rx.selected_files, ua->catalog->name());
-
-   /* Build run command */
-   pm_strcpy(buf, "");
+   /* Build run command options, common to all parts */
+   pm_strcpy(opts, "");
    if (rx.RestoreMediaType[0]) {
       Mmsg(buf, " mediatype=\"%s\"", rx.RestoreMediaType);
-      pm_strcat(ua->cmd, buf);
+      pm_strcat(opts, buf.c_str());
       pm_strcpy(buf, "");
    }
    if (rx.RegexWhere) {
@@ -260,45 +254,96 @@ int restore_cmd(UAContext *ua, const char *cmd)
       Mmsg(buf," where=\"%s\"",
            escaped_where_name ? escaped_where_name : rx.where);
    }
-   pm_strcat(ua->cmd, buf);
+   pm_strcat(opts, buf.c_str());
 
    if (rx.replace) {
       Mmsg(buf, " replace=%s", rx.replace);
-      pm_strcat(ua->cmd, buf);
+      pm_strcat(opts, buf.c_str());
    }
 
    if (rx.comment) {
       Mmsg(buf, " comment=\"%s\"", rx.comment);
-      pm_strcat(ua->cmd, buf);
-   }
-
-   if (escaped_bsr_name != NULL) {
-      bfree(escaped_bsr_name);
+      pm_strcat(opts, buf.c_str());
    }
 
    if (escaped_where_name != NULL) {
       bfree(escaped_where_name);
+      escaped_where_name = NULL;
    }
 
    if (regexp) {
       bfree(regexp);
+      regexp = NULL;
    }
 
-   if (find_arg(ua, NT_("yes")) > 0) {
-      pm_strcat(ua->cmd, " yes");    /* pass it on to the run command */
-   }
-   Dmsg1(200, "Submitting: %s\n", ua->cmd);
+   /* The run commands below replace ua->cmd, look at the arguments now */
+   yes = find_arg(ua, NT_("yes")) > 0;
+   user_bsr = find_arg_with_value(ua, NT_("bootstrap")) >= 0;
+
    /*
-    * Transfer jobids, to jcr to
-    *  pass to run_cmd().  Note, these are fields and
-    *  other things that are not passed on the command
-    *  line.
+    * With drives=n, run one restore Job per group of Volumes so that
+    *  each Job can read its Volumes in a different drive. Not done
+    *  for a user supplied bootstrap file.
     */
-   /* ***FIXME*** pass jobids on command line */
-   jcr->JobIds = rx.JobIds;
-   rx.JobIds = NULL;
-   parse_ua_args(ua);
-   run_cmd(ua, ua->cmd);
+   if (rx.drives > 1 && !user_bsr && jcr->unlink_bsr) {
+      nparts = split_bsr_by_volume(rx, rx.drives);
+   }
+   if (nparts > 1) {
+      ua->send_msg(_("The restore will be split into %d Jobs reading their Volumes in parallel.\n"),
+         nparts);
+      if (!ua->batch && !yes) {
+         if (!get_yesno(ua, _("OK to run? (yes/no): ")) || !ua->pint32_val) {
+            goto bail_out;
+         }
+         yes = true;                  /* do not ask again for each Job */
+      }
+      if (!user_bsr && jcr->unlink_bsr) {
+         unlink(jcr->RestoreBootstrap);  /* replaced by one bootstrap per part */
+      }
+   }
+
+   for (int part=0; part < nparts; part++) {
+      uint32_t files = rx.selected_files;
+
+      if (nparts > 1 && (files = write_bsr_part_file(ua, rx, part)) == 0) {
+         continue;
+      }
+      escaped_bsr_name = escape_filename(jcr->RestoreBootstrap);
+
+      Mmsg(ua->cmd,
+           "run job=\"%s\" client=\"%s\" restoreclient=\"%s\" storage=\"%s\""
+           " bootstrap=\"%s\" files=%u catalog=\"%s\"",
+           job->name(), rx.ClientName, rx.RestoreClientName,
+           rx.store?rx.store->name():"",
+           escaped_bsr_name ? escaped_bsr_name : jcr->RestoreBootstrap,
+           files, ua->catalog->name());
+      pm_strcat(ua->cmd, opts);
+      if (yes) {
+         pm_strcat(ua->cmd, " yes");  /* pass it on to the run command */
+      }
+
+      if (escaped_bsr_name != NULL) {
+         bfree(escaped_bsr_name);
+         escaped_bsr_name = NULL;
+      }
+      Dmsg1(200, "Submitting: %s\n", ua->cmd);
+      /*
+       * Transfer jobids, to jcr to
+       *  pass to run_cmd().  Note, these are fields and
+       *  other things that are not passed on the command
+       *  line.
+       */
+      /* ***FIXME*** pass jobids on command line */
+      if (part == nparts - 1) {
+         jcr->JobIds = rx.JobIds;
+         rx.JobIds = NULL;
+      } else {
+         jcr->JobIds = get_pool_memory(PM_FNAME);
+         pm_strcpy(jcr->JobIds, rx.JobIds);
+      }
+      parse_ua_args(ua);
+      run_cmd(ua, ua->cmd);
+   }
    free_rx(&rx);
    garbage_collect_memory();       /* release unused memory */
    return 1;
@@ -352,6 +397,10 @@ static void free_rx(RESTORE_CTX *rx)
    free_and_null_pool_memory(rx->path);
    free_and_null_pool_memory(rx->query);
    free_name_list(&rx->name_list);
+   if (rx->vol_parts) {
+      free(rx->vol_parts);
+      rx->vol_parts = NULL;
+   }
 }
 
 static bool has_value(UAContext *ua, int i)
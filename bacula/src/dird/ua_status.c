@@ -27,10 +27,12 @@
 
 extern void *start_heap;
 extern utime_t last_reload_time;
+extern jobq_t job_queue;              /* job queue */
 
 static void list_scheduled_jobs(UAContext *ua);
 static void llist_scheduled_jobs(UAContext *ua);
 static void list_running_jobs(UAContext *ua);
+static void list_job_queue(UAContext *ua);
 static void list_terminated_jobs(UAContext *ua);
 static void do_storage_status(UAContext *ua, STORE *store, char *cmd);
 static void do_client_status(UAContext *ua, CLIENT *client, char *cmd);
@@ -303,6 +305,23 @@ void list_dir_status_header(UAContext *ua)
             edit_uint64_with_commas(sm_max_bytes, b3),
             edit_uint64_with_commas(sm_buffers, b4),
             edit_uint64_with_commas(sm_max_buffers, b5));
+   DB_POOL_STATS dbs;
+   db_get_pool_stats(&dbs);
+   if (dbs.locks > 0) {
+      ua->send_msg(_(" Catalog: locks=%s avg_wait=%sus max_wait=%sus avg_busy=%sus\n"),
+         edit_uint64_with_commas(dbs.locks, b1),
+         edit_uint64_with_commas(dbs.wait_time / dbs.locks, b2),
+         edit_uint64_with_commas(dbs.max_wait, b3),
+         edit_uint64_with_commas(dbs.busy_time / dbs.locks, b4));
+   }
+
+   POOL_MEM delivery(PM_MESSAGE);
+   if (edit_message_delivery_status(delivery.addr()) > 0) {
+      ua->send_msg("%s", delivery.c_str());
+   }
+   if (edit_catalog_id_cache_status(delivery.addr()) > 0) {
+      ua->send_msg("%s", delivery.c_str());
+   }
 
    /* TODO: use this function once for all daemons */
    if (bplugin_list->size() > 0) {
@@ -336,6 +355,11 @@ static void do_director_status(UAContext *ua)
     */
    list_running_jobs(ua);
 
+   /*
+    * List what the job queue is waiting for
+    */
+   list_job_queue(ua);
+
    /*
     * List terminated jobs
     */
@@ -519,6 +543,7 @@ static void prt_runtime(UAContext *ua, sched_pkt *sp)
          sp->job->name(), mr.VolumeName);
    }
    if (close_db) {
+      wait_message_delivery(jcr);
       db_close_database(jcr, jcr->db);
    }
    jcr->db = ua->db;                  /* restore ua db to jcr */
@@ -854,7 +879,11 @@ static void list_running_jobs(UAContext *ua)
          msg = _("is waiting execution");
          break;
       case JS_Running:
-         msg = _("is running");
+         if (jcr->backfilled) {
+            msg = _("is running (backfilled)");
+         } else {
+            msg = _("is running");
+         }
          break;
       case JS_Blocked:
          msg = _("is blocked");
@@ -1031,6 +1060,71 @@ static void list_running_jobs(UAContext *ua)
    Dmsg0(200, "leave list_run_jobs()\n");
 }
 
+/* Rows of list_job_queue(), edited with the job queue locked */
+struct JOBQ_LIST_CTX {
+   UAContext *ua;
+   POOL_MEM rows;
+   int njobs;
+};
+
+static void edit_job_queue_row(JCR *jcr, void *ctx)
+{
+   JOBQ_LIST_CTX *lc = (JOBQ_LIST_CTX *)ctx;
+   POOL_MEM row;
+   char b1[50];
+
+   if (jcr->JobId == 0 || !acl_access_ok(lc->ua, Job_ACL, jcr->job->name())) {
+      return;
+   }
+   if (jcr->est_run_time > 0) {
+      edit_utime(jcr->est_run_time, b1, sizeof(b1));
+   } else {
+      bstrncpy(b1, _("unknown"), sizeof(b1));
+   }
+   Mmsg(row, _("%6d  %3d  %-17s %-8s  %s\n"),
+        jcr->JobId, jcr->JobPriority, b1,
+        jcr->job->allow_backfill ? _("yes") : _("no"),
+        jcr->job->name());
+   pm_strcat(lc->rows, row.c_str());
+   lc->njobs++;
+}
+
+/*
+ * Report the job queue decisions: the jobs waiting for resources
+ *  or for their priority, in the order the queue will try them,
+ *  with their estimated run time.
+ */
+static void list_job_queue(UAContext *ua)
+{
+   jobq_status_t st;
+   JOBQ_LIST_CTX lc;
+
+   if (ua->api) {
+      return;
+   }
+   jobq_get_status(&job_queue, &st);
+   if (st.waiting == 0) {
+      return;
+   }
+   ua->send_msg(_("\nJob Queue: waiting=%d ready=%d running=%d max=%d "
+                  "lookahead=%s reordered=%u backfilled=%u\n"),
+                st.waiting, st.ready, st.running, st.max_workers,
+                director->sched_lookahead ? _("yes") : _("no"),
+                st.num_reordered, st.num_backfilled);
+
+   /* Edit the rows with the queue locked, send them once unlocked */
+   lc.ua = ua;
+   lc.njobs = 0;
+   pm_strcpy(lc.rows, "");
+   jobq_foreach_waiting(&job_queue, edit_job_queue_row, &lc);
+   if (lc.njobs > 0) {
+      ua->send_msg(_(" JobId  Pri  Est.RunTime       Backfill  Name\n"));
+      ua->send_msg(_("======================================================================\n"));
+      ua->send_msg("%s", lc.rows.c_str());
+      ua->send_msg("====\n");
+   }
+}
+
 static void list_terminated_jobs(UAContext *ua)
 {
    char dt[MAX_TIME_LENGTH], b1[30], b2[30];
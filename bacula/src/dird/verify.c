@@ -520,6 +520,283 @@ void verify_cleanup(JCR *jcr, int TermCode)
    Dmsg0(100, "Leave verify_cleanup()\n");
 }
 
+/*
+ * Index of the File records of the Job we verify against.
+ *
+ *  The records are read with a single query before the FD starts
+ *   sending attributes, and each attribute is then looked up in
+ *   memory instead of doing a catalog query and a MarkId update per
+ *   file.  The records are hashed on the filename, and the name is
+ *   kept to check a match.  The names of the files that were not
+ *   seen are read at the end with their FileId.
+ *
+ *  DiskToCatalog compares each file with its last backup, so the
+ *   index is used only when no backup of the Client was done after
+ *   the Job we load.
+ */
+struct VERIFY_FILE {
+   hlink link;
+   VERIFY_FILE *dup;                  /* next record with the same key */
+   uint64_t name_hash;                /* hash of Path.Path+Filename.Name */
+   FileId_t FileId;
+   int32_t FileIndex;
+   bool seen;                         /* set when the FD sent it */
+   char LStat[1];                     /* LStat, Digest then name, malloced with the record */
+};
+
+struct VERIFY_INDEX {
+   htable *files;
+   bool by_index;                     /* key is the FileIndex, else the name hash */
+   uint32_t count;                    /* number of records */
+};
+
+/* Number of FileIds per query when listing the missing files */
+#define MISSING_BATCH 1000
+
+/* FNV-1a, the name of a record is split in Path and Filename */
+static uint64_t fname_hash(const char *path, const char *name)
+{
+   uint64_t hash = 14695981039346656037ULL;
+   const char *p;
+
+   for (p = path; *p; p++) {
+      hash = (hash ^ (uint8_t)*p) * 1099511628211ULL;
+   }
+   for (p = name; *p; p++) {
+      hash = (hash ^ (uint8_t)*p) * 1099511628211ULL;
+   }
+   return hash;
+}
+
+static uint64_t verify_key(VERIFY_INDEX *idx, uint64_t name_hash, int32_t FileIndex)
+{
+   return idx->by_index ? (uint64_t)(uint32_t)FileIndex : name_hash;
+}
+
+/* Called for each File record of the Job */
+static int verify_index_handler(void *ctx, int num_fields, char **row)
+{
+   VERIFY_INDEX *idx = (VERIFY_INDEX *)ctx;
+   VERIFY_FILE *vf, *first;
+   const char *digest = row[5] ? row[5] : "";
+   int lstat_len = strlen(row[4]);
+   int digest_len = strlen(digest);
+   int path_len = strlen(row[0]);
+   char *name;
+   uint64_t key;
+
+   vf = (VERIFY_FILE *)idx->files->hash_malloc(sizeof(VERIFY_FILE) + lstat_len +
+                          digest_len + path_len + strlen(row[1]) + 2);
+   vf->dup = NULL;
+   vf->name_hash = fname_hash(row[0], row[1]);
+   vf->FileIndex = str_to_int64(row[2]);
+   vf->FileId = (FileId_t)str_to_int64(row[3]);
+   vf->seen = false;
+   strcpy(vf->LStat, row[4]);
+   strcpy(vf->LStat + lstat_len + 1, digest);
+   name = vf->LStat + lstat_len + digest_len + 2;
+   strcpy(name, row[0]);
+   strcpy(name + path_len, row[1]);
+
+   key = verify_key(idx, vf->name_hash, vf->FileIndex);
+   first = (VERIFY_FILE *)idx->files->lookup(key);
+   if (first) {
+      vf->dup = first->dup;           /* e.g. directory saved twice */
+      first->dup = vf;
+   } else {
+      idx->files->insert(key, vf);
+   }
+   idx->count++;
+   return 0;
+}
+
+static void free_verify_index(VERIFY_INDEX *idx)
+{
+   if (idx) {
+      idx->files->destroy();
+      free(idx->files);
+      free(idx);
+   }
+}
+
+static const char *verify_file_name(VERIFY_FILE *vf)
+{
+   const char *digest = vf->LStat + strlen(vf->LStat) + 1;
+   return digest + strlen(digest) + 1;
+}
+
+/*
+ * For DiskToCatalog, the records of JobId are the last version of
+ *  the files only if no other good backup of the Client started
+ *  after it.
+ */
+static bool is_last_client_backup(JCR *jcr, JobId_t JobId)
+{
+   db_int64_ctx ctx;
+   POOL_MEM query;
+   char ed1[50], ed2[50];
+
+   if (jcr->previous_jr.JobId != JobId || jcr->previous_jr.JobType != JT_BACKUP) {
+      return false;
+   }
+   ctx.value = 0;
+   ctx.count = 0;
+   Mmsg(query,
+      "SELECT COUNT(*) FROM Job WHERE ClientId=%s AND Type='B' "
+      "AND JobStatus IN ('T','W') AND StartTime >= '%s' AND JobId<>%s",
+      edit_int64(jcr->previous_jr.ClientId, ed1), jcr->previous_jr.cStartTime,
+      edit_int64(JobId, ed2));
+   if (!db_sql_query(jcr->db, query.c_str(), db_int64_handler, (void *)&ctx)) {
+      return false;
+   }
+   return ctx.count == 1 && ctx.value == 0;
+}
+
+/*
+ * Read the File records of JobId, returns NULL if the query
+ *  fails or if the index cannot be used, and the caller will
+ *  query the catalog for each file.
+ */
+static VERIFY_INDEX *new_verify_index(JCR *jcr, JobId_t JobId)
+{
+   VERIFY_INDEX *idx;
+   VERIFY_FILE *vf = NULL;
+   POOL_MEM query;
+   char ed1[50];
+
+   if (jcr->getJobLevel() == L_VERIFY_DISK_TO_CATALOG &&
+       !is_last_client_backup(jcr, JobId)) {
+      Dmsg1(100, "JobId %u is not the last backup of the Client, no index\n", JobId);
+      return NULL;
+   }
+   idx = (VERIFY_INDEX *)malloc(sizeof(VERIFY_INDEX));
+   memset(idx, 0, sizeof(VERIFY_INDEX));
+   idx->by_index = jcr->getJobLevel() == L_VERIFY_VOLUME_TO_CATALOG;
+   idx->files = (htable *)malloc(sizeof(htable));
+   idx->files->init(vf, &vf->link, MAX(jcr->previous_jr.JobFiles, 1000));
+
+   Mmsg(query,
+      "SELECT Path.Path,Filename.Name,File.FileIndex,File.FileId,File.LStat,File.MD5 "
+      "FROM File,Path,Filename "
+      "WHERE File.JobId=%s AND File.FileIndex > 0 AND File.PathId=Path.PathId "
+      "AND File.FilenameId=Filename.FilenameId",
+      edit_int64(JobId, ed1));
+   if (!db_big_sql_query(jcr->db, query.c_str(), verify_index_handler, idx)) {
+      Jmsg(jcr, M_WARNING, 0, _("Unable to read the File records of JobId %s, checking each file. ERR=%s"),
+           ed1, db_strerror(jcr->db));
+      free_verify_index(idx);
+      return NULL;
+   }
+   Dmsg2(100, "Loaded %u File records of JobId %s\n", idx->count, ed1);
+   return idx;
+}
+
+/*
+ * Find the record of a file sent by the FD.  When a name appears
+ *  more than once in the Job, take a record that was not seen yet.
+ */
+static VERIFY_FILE *lookup_verify_index(VERIFY_INDEX *idx, const char *fname,
+                                        int32_t FileIndex)
+{
+   uint64_t name_hash = fname_hash(fname, "");
+   VERIFY_FILE *vf, *found = NULL;
+
+   vf = (VERIFY_FILE *)idx->files->lookup(verify_key(idx, name_hash, FileIndex));
+   for ( ; vf; vf = vf->dup) {
+      if (vf->name_hash != name_hash || (idx->by_index && vf->FileIndex != FileIndex) ||
+          strcmp(verify_file_name(vf), fname) != 0) {
+         continue;
+      }
+      if (!vf->seen) {
+         return vf;
+      }
+      if (!found) {
+         found = vf;
+      }
+   }
+   return found;
+}
+
+/*
+ * Find the catalog record of jcr->fname.  DiskToCatalog compares to
+ *  the last backup of each file, so a file that is not in the index
+ *  is searched in the other Jobs of the Client.
+ */
+static bool find_file_record(JCR *jcr, VERIFY_INDEX *idx, int32_t file_index,
+                             FILE_DBR *fdbr)
+{
+   VERIFY_FILE *vf;
+
+   if (idx) {
+      vf = lookup_verify_index(idx, jcr->fname, file_index);
+      if (vf) {
+         vf->seen = true;
+         fdbr->FileId = vf->FileId;
+         bstrncpy(fdbr->LStat, vf->LStat, sizeof(fdbr->LStat));
+         bstrncpy(fdbr->Digest, vf->LStat + strlen(vf->LStat) + 1, sizeof(fdbr->Digest));
+         return true;
+      }
+      if (jcr->getJobLevel() != L_VERIFY_DISK_TO_CATALOG) {
+         return false;
+      }
+   }
+   if (!db_get_file_attributes_record(jcr, jcr->db, jcr->fname,
+        &jcr->previous_jr, fdbr)) {
+      return false;
+   }
+   if (!idx) {
+      /*
+       * mark file record as visited by stuffing the
+       * current JobId, which is unique, into the MarkId field.
+       */
+      db_mark_file_record(jcr, jcr->db, fdbr->FileId, jcr->JobId);
+   }
+   return true;
+}
+
+static void send_missing_batch(JCR *jcr, POOL_MEM &ids)
+{
+   POOL_MEM query;
+
+   Mmsg(query,
+      "SELECT Path.Path,Filename.Name FROM File,Path,Filename "
+      "WHERE File.FileId IN (%s) AND File.PathId=Path.PathId "
+      "AND File.FilenameId=Filename.FilenameId", ids.c_str());
+   db_sql_query(jcr->db, query.c_str(), missing_handler, (void *)jcr);
+}
+
+/* Report the records of the index that the FD did not send */
+static void list_missing_files(JCR *jcr, VERIFY_INDEX *idx)
+{
+   VERIFY_FILE *vf;
+   POOL_MEM ids;
+   char ed1[50];
+   int nb = 0;
+
+   foreach_htable(vf, idx->files) {
+      for (VERIFY_FILE *dup = vf; dup; dup = dup->dup) {
+         if (dup->seen) {
+            continue;
+         }
+         if (nb > 0) {
+            pm_strcat(ids, ",");
+         }
+         pm_strcat(ids, edit_int64(dup->FileId, ed1));
+         if (++nb == MISSING_BATCH) {
+            send_missing_batch(jcr, ids);
+            pm_strcpy(ids, "");
+            nb = 0;
+         }
+      }
+      if (job_canceled(jcr)) {
+         return;
+      }
+   }
+   if (nb > 0) {
+      send_missing_batch(jcr, ids);
+   }
+}
+
 /*
  * This routine is called only during a Verify
  */
@@ -534,12 +811,15 @@ void get_attributes_and_compare_to_catalog(JCR *jcr, JobId_t JobId)
    POOLMEM *fname = get_pool_memory(PM_MESSAGE);
    int do_Digest = CRYPTO_DIGEST_NONE;
    int32_t file_index = 0;
+   VERIFY_INDEX *idx;
 
    memset(&fdbr, 0, sizeof(FILE_DBR));
    fd = jcr->file_bsock;
    fdbr.JobId = JobId;
    jcr->FileIndex = 0;
 
+   idx = new_verify_index(jcr, JobId);
+
    Dmsg0(20, "bdird: waiting to receive file attributes\n");
    /*
     * Get Attributes and Signature from File daemon
@@ -607,18 +887,11 @@ void get_attributes_and_compare_to_catalog(JCR *jcr, JobId_t JobId)
           * Find equivalent record in the database
           */
          fdbr.FileId = 0;
-         if (!db_get_file_attributes_record(jcr, jcr->db, jcr->fname,
-              &jcr->previous_jr, &fdbr)) {
+         if (!find_file_record(jcr, idx, file_index, &fdbr)) {
             Jmsg(jcr, M_INFO, 0, _("New file: %s\n"), jcr->fname);
             Dmsg1(020, _("File not in catalog: %s\n"), jcr->fname);
             jcr->setJobStatus(JS_Differences);
             continue;
-         } else {
-            /*
-             * mark file record as visited by stuffing the
-             * current JobId, which is unique, into the MarkId field.
-             */
-            db_mark_file_record(jcr, jcr->db, fdbr.FileId, jcr->JobId);
          }
 
          Dmsg3(400, "Found %s in catalog. inx=%d Opts=%s\n", jcr->fname,
@@ -760,22 +1033,28 @@ void get_attributes_and_compare_to_catalog(JCR *jcr, JobId_t JobId)
    }
 
    /* Now find all the files that are missing -- i.e. all files in
-    *  the database where the MarkId != current JobId
+    *  the index that were not seen, or all files in the database
+    *  where the MarkId != current JobId
     */
    jcr->fn_printed = false;
-   bsnprintf(buf, sizeof(buf),
-      "SELECT Path.Path,Filename.Name FROM File,Path,Filename "
-      "WHERE File.JobId=%d AND File.FileIndex > 0 "
-      "AND File.MarkId!=%d AND File.PathId=Path.PathId "
-      "AND File.FilenameId=Filename.FilenameId",
-         JobId, jcr->JobId);
-   /* missing_handler is called for each file found */
-   db_sql_query(jcr->db, buf, missing_handler, (void *)jcr);
+   if (idx) {
+      list_missing_files(jcr, idx);
+   } else {
+      bsnprintf(buf, sizeof(buf),
+         "SELECT Path.Path,Filename.Name FROM File,Path,Filename "
+         "WHERE File.JobId=%d AND File.FileIndex > 0 "
+         "AND File.MarkId!=%d AND File.PathId=Path.PathId "
+         "AND File.FilenameId=Filename.FilenameId",
+            JobId, jcr->JobId);
+      /* missing_handler is called for each file found */
+      db_sql_query(jcr->db, buf, missing_handler, (void *)jcr);
+   }
    if (jcr->fn_printed) {
       jcr->setJobStatus(JS_Differences);
    }
 
 bail_out:
+   free_verify_index(idx);
    free_pool_memory(fname);
 }
 
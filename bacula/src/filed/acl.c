@@ -89,6 +89,19 @@ static bacl_exit_code send_acl_stream(JCR *jcr, int stream)
       return bacl_exit_ok;
    }
 
+   /*
+    * Send only a reference when the same ACL was already sent
+    */
+   switch (send_metadata_ref(jcr, stream, jcr->acl_data->u.build->content,
+                             jcr->acl_data->u.build->content_length + 1)) {
+   case -1:
+      return bacl_exit_fatal;
+   case 1:
+      return bacl_exit_ok;
+   default:
+      break;
+   }
+
    /*
     * Send header
     */
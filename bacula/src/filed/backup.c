@@ -50,6 +50,8 @@ bool encode_and_send_attributes(JCR *jcr, FF_PKT *ff_pkt, int &data_stream);
 static bool crypto_session_start(JCR *jcr);
 static void crypto_session_end(JCR *jcr);
 static bool crypto_session_send(JCR *jcr, BSOCK *sd);
+static bool seal_data_record(JCR *jcr, BSOCK *sd, int32_t stream,
+                             uint32_t file_no, uint32_t record_no);
 static void close_vss_backup_session(JCR *jcr);
 
 /**
@@ -154,6 +156,10 @@ bool blast_data_to_storage_daemon(JCR *jcr, char *addr)
       set_find_changed_function((FF_PKT *)jcr->ff, accurate_check_file);
    }
 
+   if (me->offload_digests) {
+      init_digest_pipe(jcr);
+   }
+
    start_heartbeat_monitor(jcr);
 
    if (have_acl) {
@@ -172,6 +178,10 @@ bool blast_data_to_storage_daemon(JCR *jcr, char *addr)
       jcr->xattr_data->u.build->content = get_pool_memory(PM_MESSAGE);
    }
 
+   if (have_acl || have_xattr) {
+      init_metadata_dict(jcr);
+   }
+
    /** Subroutine save_file() is called for each file */
    if (!find_files(jcr, (FF_PKT *)jcr->ff, save_file, plugin_save)) {
       ok = false;                     /* error */
@@ -189,6 +199,10 @@ bool blast_data_to_storage_daemon(JCR *jcr, char *addr)
 
    close_vss_backup_session(jcr);
 
+   save_metadata_dict(jcr);          /* ACL/xattr referenced in this job */
+   free_metadata_dict(jcr);
+   free_digest_pipe(jcr);
+
    accurate_finish(jcr);              /* send deleted or base file list to SD */
 
    stop_heartbeat_monitor(jcr);
@@ -272,6 +286,13 @@ static bool crypto_session_start(JCR *jcr)
       /** ... and store the encoded size */
       jcr->crypto.pki_session_encoded_size = size;
 
+      /** AEAD ciphers seal each data record alone, one context is enough */
+      jcr->crypto.pki_aead = crypto_cipher_new(jcr->crypto.pki_session, true, &size);
+      if (jcr->crypto.pki_aead && !crypto_cipher_is_aead(jcr->crypto.pki_aead)) {
+         crypto_cipher_free(jcr->crypto.pki_aead);
+         jcr->crypto.pki_aead = NULL;
+      }
+
       /** Allocate the encryption/decryption buffer */
       jcr->crypto.crypto_buf = get_memory(CRYPTO_CIPHER_MAX_BLOCK_SIZE);
    }
@@ -280,6 +301,10 @@ static bool crypto_session_start(JCR *jcr)
 
 static void crypto_session_end(JCR *jcr)
 {
+   if (jcr->crypto.pki_aead) {
+      crypto_cipher_free(jcr->crypto.pki_aead);
+      jcr->crypto.pki_aead = NULL;
+   }
    if (jcr->crypto.crypto_buf) {
       free_pool_memory(jcr->crypto.crypto_buf);
       jcr->crypto.crypto_buf = NULL;
@@ -525,8 +550,8 @@ int save_file(JCR *jcr, FF_PKT *ff_pkt, bool top_level)
          }
       }
 
-      /** Enable encryption */
-      if (jcr->crypto.pki_encrypt) {
+      /** Enable encryption, AEAD ciphers seal the records of any stream */
+      if (jcr->crypto.pki_encrypt && !jcr->crypto.pki_aead) {
          ff_pkt->flags |= FO_ENCRYPT;
       }
    }
@@ -691,11 +716,8 @@ int save_file(JCR *jcr, FF_PKT *ff_pkt, bool top_level)
          Dmsg1(300, "bfiled>stored:header %s\n", sd->msg);
          pm_memcpy(sd->msg, ff_pkt->hfsinfo.fndrinfo, 32);
          sd->msglen = 32;
-         if (digest) {
-            crypto_digest_update(digest, (uint8_t *)sd->msg, sd->msglen);
-         }
-         if (signing_digest) {
-            crypto_digest_update(signing_digest, (uint8_t *)sd->msg, sd->msglen);
+         if (digest || signing_digest) {
+            digest_pipe_update(jcr, digest, signing_digest, sd->msg, sd->msglen);
          }
          sd->send();
          sd->signal(BNET_EOD);
@@ -754,6 +776,9 @@ int save_file(JCR *jcr, FF_PKT *ff_pkt, bool top_level)
       }
    }
 
+   /** The digests must be up to date before we finalize them */
+   drain_digest_pipe(jcr);
+
    /** Terminate the signing digest and send it to the Storage daemon */
    if (signing_digest) {
       uint32_t size = 0;
@@ -853,6 +878,7 @@ bail_out:
       jcr->plugin = NULL;
       jcr->opt_plugin = false;
    }
+   drain_digest_pipe(jcr);            /* digests may still be in use */
    if (digest) {
       crypto_digest_free(digest);
    }
@@ -865,6 +891,37 @@ bail_out:
    return rtnstat;
 }
 
+/**
+ * Seal the record in sd->msg with the AEAD cipher of the Job.  The
+ *  original stream, the FileIndex and the record number are sent in
+ *  clear in front of the encrypted record, and are authenticated with
+ *  it.  Each record gets its own nonce, so they can be opened in any
+ *  order.
+ */
+static bool seal_data_record(JCR *jcr, BSOCK *sd, int32_t stream,
+                             uint32_t file_no, uint32_t record_no)
+{
+   uint8_t *buf = (uint8_t *)jcr->crypto.crypto_buf;
+   uint32_t sealed_len;
+   ser_declare;
+
+   ser_begin(buf, STREAM_AEAD_HEADER_SIZE);
+   ser_int32(stream);
+   ser_int32(jcr->JobFiles);          /* FileIndex of the file */
+   ser_uint32(file_no);
+   ser_uint32(record_no);
+   if (!crypto_cipher_seal(jcr->crypto.pki_aead, ((uint64_t)file_no << 32) | record_no,
+          buf, STREAM_AEAD_HEADER_SIZE, (uint8_t *)sd->msg, sd->msglen,
+          buf + STREAM_AEAD_HEADER_SIZE, &sealed_len)) {
+      /** Encryption failed. Shouldn't happen. */
+      Jmsg(jcr, M_FATAL, 0, _("Encryption error\n"));
+      return false;
+   }
+   sd->msg = jcr->crypto.crypto_buf;
+   sd->msglen = STREAM_AEAD_HEADER_SIZE + sealed_len;
+   return true;
+}
+
 /**
  * Send data read from an already open file descriptor.
  *
@@ -889,6 +946,8 @@ static int send_data(JCR *jcr, int stream, FF_PKT *ff_pkt, DIGEST *digest,
    uint32_t cipher_input_len;
    uint32_t cipher_block_size;
    uint32_t encrypted_len;
+   uint32_t aead_file = 0;            /* AEAD stream and record numbers */
+   uint32_t aead_record = 0;
 #ifdef FD_NO_SEND_TEST
    return 1;
 #endif
@@ -988,13 +1047,20 @@ static int send_data(JCR *jcr, int stream, FF_PKT *ff_pkt, DIGEST *digest,
             cipher_block_size - 1) / cipher_block_size * cipher_block_size);
 
       wbuf = jcr->crypto.crypto_buf; /* Encrypted, possibly compressed output here. */
+   } else if (jcr->crypto.pki_aead) {
+      /** Room for the clear header, the largest record and the tag */
+      jcr->crypto.crypto_buf = check_pool_memory_size(jcr->crypto.crypto_buf,
+           MAX(rsize, (int32_t)max_compress_len) + OFFSET_FADDR_SIZE +
+           STREAM_AEAD_HEADER_SIZE + CRYPTO_CIPHER_TAG_SIZE);
+      aead_file = ++jcr->crypto.aead_files;
    }
 
    /**
     * Send Data header to Storage daemon
     *    <file-index> <stream> <expected stream length>
     */
-   if (!sd->fsend("%ld %d %lld", jcr->JobFiles, stream,
+   if (!sd->fsend("%ld %d %lld", jcr->JobFiles,
+        jcr->crypto.pki_aead ? STREAM_AEAD_DATA : stream,
         (int64_t)ff_pkt->statp.st_size)) {
       if (!jcr->is_job_canceled()) {
          Jmsg1(jcr, M_FATAL, 0, _("Network send error to SD. ERR=%s\n"),
@@ -1062,14 +1128,9 @@ static int send_data(JCR *jcr, int stream, FF_PKT *ff_pkt, DIGEST *digest,
       /** Uncompressed cipher input length */
       cipher_input_len = sd->msglen;
 
-      /** Update checksum if requested */
-      if (digest) {
-         crypto_digest_update(digest, (uint8_t *)rbuf, sd->msglen);
-      }
-
-      /** Update signing digest if requested */
-      if (signing_digest) {
-         crypto_digest_update(signing_digest, (uint8_t *)rbuf, sd->msglen);
+      /** Update checksum and signing digest if requested */
+      if (digest || signing_digest) {
+         digest_pipe_update(jcr, digest, signing_digest, rbuf, sd->msglen);
       }
 
 #ifdef HAVE_LIBZ
@@ -1194,6 +1255,9 @@ static int send_data(JCR *jcr, int stream, FF_PKT *ff_pkt, DIGEST *digest,
          sd->msglen += OFFSET_FADDR_SIZE; /* include fileAddr in size */
       }
       sd->msg = wbuf;              /* set correct write buffer */
+      if (aead_file && !seal_data_record(jcr, sd, stream, aead_file, aead_record++)) {
+         goto err;
+      }
       if (!sd->send()) {
          if (!jcr->is_job_canceled()) {
             Jmsg1(jcr, M_FATAL, 0, _("Network send error to SD. ERR=%s\n"),
@@ -1242,6 +1306,25 @@ static int send_data(JCR *jcr, int stream, FF_PKT *ff_pkt, DIGEST *digest,
          jcr->JobBytes += sd->msglen;     /* count bytes saved possibly compressed/encrypted */
          sd->msg = msgsave;               /* restore bnet buffer */
       }
+   } else if (aead_file) {
+      /**
+       * Close the sealed stream with the number of records, so that
+       *  a truncated stream is detected at restore time.
+       */
+      sd->msglen = 0;
+      if (!seal_data_record(jcr, sd, stream, aead_file,
+                            aead_record | STREAM_AEAD_LAST_RECORD)) {
+         goto err;
+      }
+      if (!sd->send()) {
+         if (!jcr->is_job_canceled()) {
+            Jmsg1(jcr, M_FATAL, 0, _("Network send error to SD. ERR=%s\n"),
+                  sd->bstrerror());
+         }
+         goto err;
+      }
+      jcr->JobBytes += sd->msglen;
+      sd->msg = msgsave;                  /* restore bnet buffer */
    }
 
    if (!sd->signal(BNET_EOD)) {        /* indicate end of file data */
@@ -1290,7 +1373,11 @@ bool encode_and_send_attributes(JCR *jcr, FF_PKT *ff_pkt, int &data_stream)
       Jmsg0(jcr, M_FATAL, 0, _("Invalid file flags, no supported data stream type.\n"));
       return false;
    }
-   encode_stat(attribs, &ff_pkt->statp, sizeof(ff_pkt->statp), ff_pkt->LinkFI, data_stream);
+   if (ff_pkt->flags & FO_COMPACT_ATTR) {
+      encode_stat_compact(attribs, &ff_pkt->statp, sizeof(ff_pkt->statp), ff_pkt->LinkFI, data_stream);
+   } else {
+      encode_stat(attribs, &ff_pkt->statp, sizeof(ff_pkt->statp), ff_pkt->LinkFI, data_stream);
+   }
 
    /** Now possibly extend the attributes */
    if (IS_FT_OBJECT(ff_pkt->type)) {
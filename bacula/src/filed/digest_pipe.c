@@ -0,0 +1,233 @@
+/*
+   Bacula® - The Network Backup Solution
+
+   Copyright (C) 2014-2014 Free Software Foundation Europe e.V.
+
+   The main author of Bacula is Kern Sibbald, with contributions from many
+   others, a complete list can be found in the file AUTHORS.
+
+   You may use this file and others of this release according to the
+   license defined in the LICENSE file, which includes the Affero General
+   Public License, v3.0 ("AGPLv3") and some additional permissions and
+   terms pursuant to its AGPLv3 Section 7.
+
+   Bacula® is a registered trademark of Kern Sibbald.
+*/
+/*
+ * Digest pipeline, compute the file and signing digests of a backup
+ *  on their own threads.
+ *
+ * When "Offload Digests = yes" is set in the FileDaemon resource,
+ *  send_data() gives each buffer read from the file to this pipeline
+ *  instead of updating the digests inline.  The buffer is copied in
+ *  a ring of chunks, and one thread per digest (file digest, signing
+ *  digest) consumes the chunks in order.  Each chunk counts the
+ *  threads that still have to see it, and is reused when the count
+ *  drops to zero.  So the job thread compresses, encrypts and sends
+ *  while the digests are computed, and the two digests of a file are
+ *  computed in parallel.
+ *
+ * The digests of a file must be sent right after its data, so
+ *  save_file() drains the pipeline before it finalizes them.
+ */
+
+#include "bacula.h"
+#include "filed.h"
+
+static const int dbglvl = 200;
+
+/* Chunks in the ring */
+#define DIGEST_CHUNKS 4
+
+/* One thread for the file digest, one for the signing digest */
+#define DIGEST_THREADS 2
+
+struct DIGEST_PIPE;
+
+struct DIGEST_CHUNK {
+   POOLMEM *buf;                      /* copy of the data read */
+   uint32_t len;
+   DIGEST *digest[DIGEST_THREADS];    /* file digest, signing digest */
+   int refs;                          /* threads that did not see it yet */
+};
+
+struct DIGEST_WORKER {
+   DIGEST_PIPE *pipe;
+   int idx;                           /* digest handled in the chunks */
+   int pos;                           /* next chunk to look at */
+   pthread_t tid;
+};
+
+struct DIGEST_PIPE {
+   pthread_mutex_t mutex;
+   pthread_cond_t cond;               /* signaled on each change */
+   DIGEST_CHUNK chunks[DIGEST_CHUNKS];
+   DIGEST_WORKER workers[DIGEST_THREADS];
+   int nr_workers;                    /* threads started */
+   int tail;                          /* next chunk to fill */
+   int count;                         /* chunks in use */
+   uint32_t queued;                   /* chunks given since the start */
+   bool quit;
+};
+
+static void *digest_pipe_worker(void *arg)
+{
+   DIGEST_WORKER *w = (DIGEST_WORKER *)arg;
+   DIGEST_PIPE *pipe = w->pipe;
+   DIGEST_CHUNK *chunk;
+   uint32_t seen = 0;
+
+   P(pipe->mutex);
+   for ( ;; ) {
+      if (seen == pipe->queued) {
+         if (pipe->quit) {
+            break;
+         }
+         pthread_cond_wait(&pipe->cond, &pipe->mutex);
+         continue;
+      }
+      chunk = &pipe->chunks[w->pos];
+      V(pipe->mutex);
+
+      if (chunk->digest[w->idx]) {
+         crypto_digest_update(chunk->digest[w->idx], (uint8_t *)chunk->buf, chunk->len);
+      }
+
+      P(pipe->mutex);
+      w->pos = (w->pos + 1) % DIGEST_CHUNKS;
+      seen++;
+      if (--chunk->refs == 0) {
+         pipe->count--;
+         pthread_cond_broadcast(&pipe->cond);
+      }
+   }
+   V(pipe->mutex);
+   return NULL;
+}
+
+/*
+ * Update the digests with the data.  Without pipeline, this is done
+ *  right away, otherwise the data is copied and we only wait if
+ *  all the chunks are in use.
+ */
+void digest_pipe_update(JCR *jcr, DIGEST *digest, DIGEST *signing_digest,
+                        char *data, uint32_t len)
+{
+   DIGEST_PIPE *pipe = jcr->dpipe;
+   DIGEST_CHUNK *chunk;
+
+   if (!pipe) {
+      if (digest) {
+         crypto_digest_update(digest, (uint8_t *)data, len);
+      }
+      if (signing_digest) {
+         crypto_digest_update(signing_digest, (uint8_t *)data, len);
+      }
+      return;
+   }
+
+   P(pipe->mutex);
+   while (pipe->count == DIGEST_CHUNKS) {
+      pthread_cond_wait(&pipe->cond, &pipe->mutex);
+   }
+   chunk = &pipe->chunks[pipe->tail];
+   V(pipe->mutex);
+
+   /* Nobody looks at this chunk until queued is incremented */
+   chunk->buf = check_pool_memory_size(chunk->buf, len);
+   memcpy(chunk->buf, data, len);
+   chunk->len = len;
+   chunk->digest[0] = digest;
+   chunk->digest[1] = signing_digest;
+   chunk->refs = pipe->nr_workers;
+
+   P(pipe->mutex);
+   pipe->tail = (pipe->tail + 1) % DIGEST_CHUNKS;
+   pipe->count++;
+   pipe->queued++;
+   pthread_cond_broadcast(&pipe->cond);
+   V(pipe->mutex);
+}
+
+/*
+ * Wait until the digests are up to date, must be called before
+ *  they are finalized or freed.
+ */
+void drain_digest_pipe(JCR *jcr)
+{
+   DIGEST_PIPE *pipe = jcr->dpipe;
+
+   if (!pipe) {
+      return;
+   }
+   P(pipe->mutex);
+   while (pipe->count > 0) {
+      pthread_cond_wait(&pipe->cond, &pipe->mutex);
+   }
+   V(pipe->mutex);
+}
+
+static void stop_digest_workers(DIGEST_PIPE *pipe)
+{
+   P(pipe->mutex);
+   pipe->quit = true;
+   pthread_cond_broadcast(&pipe->cond);
+   V(pipe->mutex);
+   for (int i=0; i < pipe->nr_workers; i++) {
+      pthread_join(pipe->workers[i].tid, NULL);
+   }
+}
+
+static void free_digest_chunks(DIGEST_PIPE *pipe)
+{
+   for (int i=0; i < DIGEST_CHUNKS; i++) {
+      free_pool_memory(pipe->chunks[i].buf);
+   }
+   pthread_cond_destroy(&pipe->cond);
+   pthread_mutex_destroy(&pipe->mutex);
+   free(pipe);
+}
+
+void init_digest_pipe(JCR *jcr)
+{
+   DIGEST_PIPE *pipe;
+   int stat;
+
+   pipe = (DIGEST_PIPE *)malloc(sizeof(DIGEST_PIPE));
+   memset(pipe, 0, sizeof(DIGEST_PIPE));
+   pthread_mutex_init(&pipe->mutex, NULL);
+   pthread_cond_init(&pipe->cond, NULL);
+   for (int i=0; i < DIGEST_CHUNKS; i++) {
+      pipe->chunks[i].buf = get_pool_memory(PM_MESSAGE);
+   }
+   for (int i=0; i < DIGEST_THREADS; i++) {
+      DIGEST_WORKER *w = &pipe->workers[i];
+      w->pipe = pipe;
+      w->idx = i;
+      if ((stat = pthread_create(&w->tid, NULL, digest_pipe_worker, w)) != 0) {
+         berrno be;
+         Jmsg1(jcr, M_WARNING, 0, _("Could not start digest threads: ERR=%s\n"),
+               be.bstrerror(stat));
+         stop_digest_workers(pipe);
+         free_digest_chunks(pipe);
+         return;
+      }
+      pipe->nr_workers++;
+   }
+   jcr->dpipe = pipe;
+   Dmsg0(dbglvl, "Digest pipeline started\n");
+}
+
+void free_digest_pipe(JCR *jcr)
+{
+   DIGEST_PIPE *pipe = jcr->dpipe;
+
+   if (!pipe) {
+      return;
+   }
+   drain_digest_pipe(jcr);
+   jcr->dpipe = NULL;
+   stop_digest_workers(pipe);
+   Dmsg1(dbglvl, "Digest pipeline stopped after %u chunks\n", pipe->queued);
+   free_digest_chunks(pipe);
+}
@@ -28,11 +28,195 @@
 
 static int tally_file(JCR *jcr, FF_PKT *ff_pkt, bool);
 
+/*
+ * Walk cache
+ *
+ *  A Full estimate remembers, for each directory of the FileSet,
+ *   the stat of the directory and the number and size of the
+ *   entries directly in it. The cache is kept in the working
+ *   directory, one file per FileSet.
+ *
+ *  A "fast" estimate reuses these totals for every directory whose
+ *   device, inode, mtime and ctime did not change, and does not
+ *   stat the files of such a directory, only the subdirectories are
+ *   visited.  Files that were rewritten in place do not change their
+ *   directory, so their new size is missed: the result is an
+ *   estimate, not a count.
+ */
+static const char walk_cache_id[] = "BaculaWalk1\n";
+
+struct WALK_DIR {
+   int64_t dev;
+   int64_t ino;
+   int64_t mtime;
+   int64_t ctime;
+   uint64_t files;                    /* entries directly in the directory */
+   uint64_t bytes;                    /* their size */
+   uint32_t len;                      /* path length */
+};
+
+/* Directory being walked */
+struct WALK_FRAME {
+   WALK_DIR d;
+   bool cached;                       /* totals taken from the cache */
+   char *path;
+};
+
+struct WALK_CACHE {
+   ohtable *old_dirs;                 /* previous walk, or NULL */
+   ohtable *new_dirs;                 /* this walk */
+   alist *frames;                     /* directories being walked */
+   uint32_t reused;                   /* directories taken from old_dirs */
+};
+
+static void make_walk_cache_name(JCR *jcr, POOLMEM *&fname)
+{
+   char ed1[50];
+   bsnprintf(ed1, sizeof(ed1), "%016llx", (long long unsigned)jcr->fileset_hash);
+   Mmsg(fname, "%s/%s.%s.walk", me->working_directory, my_name, ed1);
+}
+
+static void add_walk_dir(ohtable *dirs, WALK_DIR *d, const char *path)
+{
+   WALK_DIR *item = (WALK_DIR *)dirs->hash_malloc(sizeof(WALK_DIR) + d->len + 1);
+   char *key = (char *)(item + 1);
+
+   memcpy(item, d, sizeof(WALK_DIR));
+   memcpy(key, path, d->len);
+   key[d->len] = 0;
+   dirs->insert(key, item);
+}
+
+static ohtable *read_walk_cache(JCR *jcr)
+{
+   POOL_MEM fname(PM_FNAME), path(PM_FNAME);
+   char id[sizeof(walk_cache_id)];
+   ohtable *dirs;
+   WALK_DIR d;
+   FILE *fp;
+
+   make_walk_cache_name(jcr, fname.addr());
+   if ((fp = fopen(fname.c_str(), "rb")) == NULL) {
+      Dmsg1(50, "No walk cache %s\n", fname.c_str());
+      return NULL;
+   }
+   if (fread(id, sizeof(id), 1, fp) != 1 || memcmp(id, walk_cache_id, sizeof(id)) != 0) {
+      Dmsg1(50, "Bad walk cache header %s\n", fname.c_str());
+      fclose(fp);
+      return NULL;
+   }
+   dirs = New(ohtable(10000));
+   while (fread(&d, sizeof(d), 1, fp) == 1) {
+      path.check_size(d.len + 1);
+      if (fread(path.c_str(), d.len, 1, fp) != 1) {
+         break;
+      }
+      add_walk_dir(dirs, &d, path.c_str());
+   }
+   fclose(fp);
+   Dmsg2(50, "Read %d directories from %s\n", dirs->size(), fname.c_str());
+   return dirs;
+}
+
+static void write_walk_cache(JCR *jcr, ohtable *dirs)
+{
+   POOL_MEM fname(PM_FNAME), tmp(PM_FNAME);
+   WALK_DIR *d;
+   FILE *fp;
+   bool ok;
+
+   make_walk_cache_name(jcr, fname.addr());
+   Mmsg(tmp, "%s.tmp", fname.c_str());
+   if ((fp = fopen(tmp.c_str(), "wb")) == NULL) {
+      berrno be;
+      Dmsg2(50, "Cannot create %s: ERR=%s\n", tmp.c_str(), be.bstrerror());
+      return;
+   }
+   ok = fwrite(walk_cache_id, sizeof(walk_cache_id), 1, fp) == 1;
+   foreach_ohtable(d, dirs) {
+      if (!ok) {
+         break;
+      }
+      ok = fwrite(d, sizeof(WALK_DIR) + d->len, 1, fp) == 1;
+   }
+   if (fclose(fp) != 0 || !ok || rename(tmp.c_str(), fname.c_str()) != 0) {
+      berrno be;
+      Dmsg2(50, "Cannot write %s: ERR=%s\n", fname.c_str(), be.bstrerror());
+      unlink(tmp.c_str());
+   }
+}
+
+static void free_walk_frame(WALK_FRAME *frame)
+{
+   free(frame->path);
+   free(frame);
+}
+
+/*
+ * A directory was entered: push it, and in fast mode
+ *   take its totals from the previous walk if it did not change.
+ */
+static void walk_dir_begin(JCR *jcr, WALK_CACHE *wc, FF_PKT *ff_pkt)
+{
+   WALK_FRAME *frame = (WALK_FRAME *)malloc(sizeof(WALK_FRAME));
+   WALK_DIR *old;
+
+   memset(frame, 0, sizeof(WALK_FRAME));
+   frame->path = bstrdup(ff_pkt->fname);
+   frame->d.len = strlen(frame->path);
+   frame->d.dev = ff_pkt->statp.st_dev;
+   frame->d.ino = ff_pkt->statp.st_ino;
+   frame->d.mtime = ff_pkt->statp.st_mtime;
+   frame->d.ctime = ff_pkt->statp.st_ctime;
+   if (wc->old_dirs && (old = (WALK_DIR *)wc->old_dirs->lookup(frame->path)) &&
+       old->dev == frame->d.dev && old->ino == frame->d.ino &&
+       old->mtime == frame->d.mtime && old->ctime == frame->d.ctime) {
+      frame->cached = true;
+      frame->d.files = old->files;
+      frame->d.bytes = old->bytes;
+      jcr->num_files_examined += old->files;
+      jcr->JobFiles += old->files;
+      jcr->JobBytes += old->bytes;
+      ff_pkt->skip_dir_files = true;
+      wc->reused++;
+   }
+   wc->frames->push(frame);
+}
+
+/* The directory is done, remember its totals */
+static void walk_dir_end(WALK_CACHE *wc)
+{
+   WALK_FRAME *frame = (WALK_FRAME *)wc->frames->pop();
+   add_walk_dir(wc->new_dirs, &frame->d, frame->path);
+   free_walk_frame(frame);
+}
+
+/*
+ * Count an entry in its directory.
+ *  Returns: false if the entry is already counted from the cache
+ */
+static bool walk_count(WALK_CACHE *wc, FF_PKT *ff_pkt, uint64_t bytes)
+{
+   WALK_FRAME *frame = (WALK_FRAME *)wc->frames->last();
+
+   if (!frame) {
+      return true;                    /* top level */
+   }
+   if (frame->cached) {
+      return false;
+   }
+   frame->d.files++;
+   frame->d.bytes += bytes;
+   return true;
+}
+
 /*
  * Find all the requested files and count them.
  */
 int make_estimate(JCR *jcr)
 {
+   WALK_CACHE wc;
+   WALK_FRAME *frame;
    int stat;
 
    jcr->setJobStatus(JS_Running);
@@ -43,8 +227,36 @@ int make_estimate(JCR *jcr)
       set_find_changed_function((FF_PKT *)jcr->ff, accurate_check_file);
    }
 
+   /* Only a Full estimate knows the totals of each directory */
+   memset(&wc, 0, sizeof(wc));
+   if (!jcr->incremental) {
+      if (jcr->fast_estimate && !jcr->listing) {
+         wc.old_dirs = read_walk_cache(jcr);
+      }
+      wc.new_dirs = New(ohtable(10000));
+      wc.frames = New(alist(100, not_owned_by_alist));
+      jcr->walk_cache = &wc;
+   }
+
    stat = find_files(jcr, (FF_PKT *)jcr->ff, tally_file, plugin_estimate);
    accurate_free(jcr);
+
+   if (wc.new_dirs) {
+      jcr->walk_cache = NULL;
+      if (stat && !job_canceled(jcr)) {
+         write_walk_cache(jcr, wc.new_dirs);
+      }
+      if (wc.old_dirs) {
+         Jmsg(jcr, M_INFO, 0, _("Fast estimate: %u of %u directories taken from the previous walk.\n"),
+              wc.reused, wc.new_dirs->size());
+         delete wc.old_dirs;
+      }
+      while ((frame = (WALK_FRAME *)wc.frames->pop())) {
+         free_walk_frame(frame);
+      }
+      delete wc.frames;
+      delete wc.new_dirs;
+   }
    return stat;
 }
 
@@ -54,11 +266,36 @@ int make_estimate(JCR *jcr)
  */
 static int tally_file(JCR *jcr, FF_PKT *ff_pkt, bool top_level)
 {
+   WALK_CACHE *wc = jcr->walk_cache;
+   WALK_FRAME *frame;
+   uint64_t bytes = 0;
    ATTR attr;
 
    if (job_canceled(jcr)) {
       return 0;
    }
+   if (wc) {
+      switch (ff_pkt->type) {
+      case FT_DIRBEGIN:
+         walk_dir_begin(jcr, wc, ff_pkt);
+         return 1;
+      case FT_DIREND:
+         walk_dir_end(wc);
+         break;
+      case FT_NORECURSE:
+      case FT_NOFSCHG:
+      case FT_INVALIDFS:
+      case FT_NOOPEN:
+         /* Directory entered but not walked */
+         frame = (WALK_FRAME *)wc->frames->last();
+         if (frame && strcmp(frame->path, ff_pkt->fname) == 0) {
+            free_walk_frame((WALK_FRAME *)wc->frames->pop());
+         }
+         break;
+      default:
+         break;
+      }
+   }
    switch (ff_pkt->type) {
    case FT_LNKSAVED:                  /* Hard linked, file already saved */
    case FT_REGE:
@@ -89,17 +326,21 @@ static int tally_file(JCR *jcr, FF_PKT *ff_pkt, bool top_level)
 
    if (ff_pkt->type != FT_LNKSAVED && S_ISREG(ff_pkt->statp.st_mode)) {
       if (ff_pkt->statp.st_size > 0) {
-         jcr->JobBytes += ff_pkt->statp.st_size;
+         bytes += ff_pkt->statp.st_size;
       }
 #ifdef HAVE_DARWIN_OS
       if (ff_pkt->flags & FO_HFSPLUS) {
          if (ff_pkt->hfsinfo.rsrclength > 0) {
-            jcr->JobBytes += ff_pkt->hfsinfo.rsrclength;
+            bytes += ff_pkt->hfsinfo.rsrclength;
          }
-         jcr->JobBytes += 32;    /* Finder info */
+         bytes += 32;            /* Finder info */
       }
 #endif
    }
+   if (wc && !walk_count(wc, ff_pkt, bytes)) {
+      return 1;                  /* counted with its directory */
+   }
+   jcr->JobBytes += bytes;
    jcr->num_files_examined++;
    jcr->JobFiles++;                  /* increment number of files seen */
    if (jcr->listing) {
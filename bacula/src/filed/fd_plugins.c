@@ -74,6 +74,7 @@ static bRC baculaAcceptFile(bpContext *ctx, struct save_pkt *sp);
  * These will be plugged into the global pointer structure for
  *  the findlib.
  */
+static void    stop_plugin_readahead(struct bacula_ctx *b_ctx);
 static int     my_plugin_bopen(BFILE *bfd, const char *fname, uint64_t flags, mode_t mode);
 static int     my_plugin_bclose(BFILE *bfd);
 static ssize_t my_plugin_bread(BFILE *bfd, void *buf, size_t count);
@@ -119,6 +120,45 @@ struct bacula_ctx {
    bool disabled;                        /* set if plugin disabled */
    findINCEXE *exclude;                  /* pointer to exclude files */
    findINCEXE *include;                  /* pointer to include/exclude files */
+   int read_ahead;                       /* buffers read ahead, set by plugin */
+   struct plugin_readahead *ra;          /* read ahead of the open file */
+};
+
+/* Max buffers a plugin may ask to be read ahead */
+#define PLUGIN_MAX_READAHEAD 16
+
+/*
+ * One buffer of plugin data read ahead.
+ */
+struct plugin_ra_slot {
+   char *buf;                            /* data */
+   int32_t len;                          /* bytes in buf */
+   int32_t pos;                          /* bytes already given to bread() */
+   boffset_t offset;                     /* offset returned by the plugin */
+};
+
+/*
+ * When a plugin sets bVarReadAhead, its backup data is read by a
+ *  separate thread into a ring of buffers, so that the plugin
+ *  produces the next blocks while the job thread compresses,
+ *  encrypts and sends the previous ones.
+ */
+struct plugin_readahead {
+   pthread_mutex_t mutex;
+   pthread_cond_t cond;
+   pthread_t tid;
+   JCR *jcr;
+   Plugin *plugin;
+   bpContext *ctx;
+   plugin_ra_slot *slots;                /* ring of buffers */
+   int nr_slots;
+   int head;                             /* next slot for bread() */
+   int count;                            /* slots filled */
+   int32_t size;                         /* size of each buffer */
+   bool fill;                            /* gather short reads in full buffers */
+   bool quit;                            /* file closed, stop reading */
+   bool done;                            /* reader hit end of file or error */
+   struct io_pkt end;                    /* last IO_READ status */
 };
 
 /*
@@ -1244,6 +1284,7 @@ void free_plugins(JCR *jcr)
    Dmsg2(dbglvl, "Free instance plugin_ctx=%p JobId=%d\n", plugin_ctx_list, jcr->JobId);
    foreach_alist_index(i, plugin, bplugin_list) {
       /* Free the plugin instance */
+      stop_plugin_readahead((bacula_ctx *)plugin_ctx_list[i].bContext);
       plug_func(plugin)->freePlugin(&plugin_ctx_list[i]);
       free(plugin_ctx_list[i].bContext);     /* free Bacula private context */
       Dsm_check(999);
@@ -1253,6 +1294,199 @@ void free_plugins(JCR *jcr)
    jcr->plugin_ctx_list = NULL;
 }
 
+/*
+ * Call the plugin IO_READ function.  The plugin either fills buf, or
+ *  points io->buf to data in its own buffer, valid until its next
+ *  pluginIO() call, which we copy into buf.
+ */
+static void plugin_read_io(Plugin *plugin, bpContext *ctx, struct io_pkt *io,
+                           char *buf, int32_t count)
+{
+   io->pkt_size = sizeof(struct io_pkt);
+   io->pkt_end = sizeof(struct io_pkt);
+   io->func = IO_READ;
+   io->count = count;
+   io->buf = buf;
+   io->win32 = false;
+   io->offset = 0;
+   io->io_errno = 0;
+   io->lerror = 0;
+   io->status = -1;
+   plug_func(plugin)->pluginIO(ctx, io);
+   if (io->status > 0 && io->buf != buf) {
+      if (io->status > count) {
+         Jmsg2(NULL, M_ERROR, 0, _("Plugin returned %d bytes for a read of %d.\n"),
+               io->status, count);
+         io->status = -1;
+         io->io_errno = EINVAL;
+      } else {
+         memcpy(buf, io->buf, io->status);
+      }
+      io->buf = buf;
+   }
+}
+
+static void *plugin_readahead_thread(void *arg)
+{
+   plugin_readahead *ra = (plugin_readahead *)arg;
+   plugin_ra_slot *slot;
+   struct io_pkt io;
+
+   set_jcr_in_tsd(ra->jcr);
+   memset(&io, 0, sizeof(io));
+   for ( ;; ) {
+      P(ra->mutex);
+      while (ra->count == ra->nr_slots && !ra->quit) {
+         pthread_cond_wait(&ra->cond, &ra->mutex);
+      }
+      if (ra->quit) {
+         V(ra->mutex);
+         break;
+      }
+      slot = &ra->slots[(ra->head + ra->count) % ra->nr_slots];
+      V(ra->mutex);
+
+      /* Filled slots belong to the job thread, this one is ours */
+      slot->len = slot->pos = 0;
+      do {
+         plugin_read_io(ra->plugin, ra->ctx, &io, slot->buf + slot->len,
+                        ra->size - slot->len);
+         if (slot->len == 0) {
+            slot->offset = io.offset;
+         }
+         if (io.status <= 0) {
+            break;
+         }
+         slot->len += io.status;
+      } while (ra->fill && slot->len < ra->size && !ra->quit);
+
+      P(ra->mutex);
+      if (slot->len > 0 && io.status >= 0) {
+         ra->count++;
+      }
+      if (io.status <= 0) {
+         ra->end = io;
+         ra->done = true;
+      }
+      pthread_cond_broadcast(&ra->cond);
+      V(ra->mutex);
+      if (io.status <= 0) {
+         break;
+      }
+   }
+   return NULL;
+}
+
+/*
+ * Start reading ahead on the first bread() of a plugin backup.
+ *  If the thread cannot be started, we simply read directly.
+ */
+static plugin_readahead *start_plugin_readahead(JCR *jcr, bacula_ctx *b_ctx,
+                                                int32_t size)
+{
+   plugin_readahead *ra;
+   int stat;
+
+   ra = (plugin_readahead *)malloc(sizeof(plugin_readahead));
+   memset(ra, 0, sizeof(plugin_readahead));
+   pthread_mutex_init(&ra->mutex, NULL);
+   pthread_cond_init(&ra->cond, NULL);
+   ra->jcr = jcr;
+   ra->plugin = (Plugin *)jcr->plugin;
+   ra->ctx = jcr->plugin_ctx;
+   ra->size = size;
+   ra->fill = !(jcr->plugin_sp->flags & (FO_SPARSE|FO_OFFSETS));
+   ra->nr_slots = b_ctx->read_ahead;
+   ra->slots = (plugin_ra_slot *)malloc(ra->nr_slots * sizeof(plugin_ra_slot));
+   for (int i=0; i < ra->nr_slots; i++) {
+      ra->slots[i].buf = (char *)malloc(size);
+   }
+   if ((stat = pthread_create(&ra->tid, NULL, plugin_readahead_thread, ra)) != 0) {
+      berrno be;
+      Jmsg1(jcr, M_WARNING, 0, _("Cannot create plugin read thread: %s\n"),
+            be.bstrerror(stat));
+      b_ctx->read_ahead = 0;
+      for (int i=0; i < ra->nr_slots; i++) {
+         free(ra->slots[i].buf);
+      }
+      free(ra->slots);
+      pthread_mutex_destroy(&ra->mutex);
+      pthread_cond_destroy(&ra->cond);
+      free(ra);
+      return NULL;
+   }
+   Dmsg2(dbglvl, "Plugin read ahead started: %d buffers of %d bytes\n",
+         ra->nr_slots, size);
+   return ra;
+}
+
+/*
+ * Stop the reader, must be done before the plugin gets IO_CLOSE.
+ */
+static void stop_plugin_readahead(bacula_ctx *b_ctx)
+{
+   plugin_readahead *ra = b_ctx->ra;
+
+   if (!ra) {
+      return;
+   }
+   b_ctx->ra = NULL;
+   P(ra->mutex);
+   ra->quit = true;
+   pthread_cond_broadcast(&ra->cond);
+   V(ra->mutex);
+   pthread_join(ra->tid, NULL);
+   for (int i=0; i < ra->nr_slots; i++) {
+      free(ra->slots[i].buf);
+   }
+   free(ra->slots);
+   pthread_mutex_destroy(&ra->mutex);
+   pthread_cond_destroy(&ra->cond);
+   free(ra);
+}
+
+/*
+ * Give the next read ahead data to bread()
+ */
+static ssize_t plugin_readahead_read(plugin_readahead *ra, BFILE *bfd,
+                                     char *buf, int32_t count)
+{
+   plugin_ra_slot *slot;
+   int32_t len;
+
+   P(ra->mutex);
+   while (ra->count == 0 && !ra->done) {
+      pthread_cond_wait(&ra->cond, &ra->mutex);
+   }
+   if (ra->count == 0) {              /* end of file or error */
+      bfd->offset = ra->end.offset;
+      bfd->berrno = ra->end.io_errno;
+      if (ra->end.win32) {
+         errno = b_errno_win32;
+      } else {
+         errno = ra->end.io_errno;
+         bfd->lerror = ra->end.lerror;
+      }
+      V(ra->mutex);
+      return (ssize_t)ra->end.status;
+   }
+   slot = &ra->slots[ra->head];
+   V(ra->mutex);
+
+   len = MIN(count, slot->len - slot->pos);
+   memcpy(buf, slot->buf + slot->pos, len);
+   bfd->offset = slot->offset + slot->pos;
+   slot->pos += len;
+   if (slot->pos == slot->len) {
+      P(ra->mutex);
+      ra->head = (ra->head + 1) % ra->nr_slots;
+      ra->count--;
+      pthread_cond_broadcast(&ra->cond);
+      V(ra->mutex);
+   }
+   return (ssize_t)len;
+}
+
 static int my_plugin_bopen(BFILE *bfd, const char *fname, uint64_t flags, mode_t mode)
 {
    JCR *jcr = bfd->jcr;
@@ -1299,6 +1533,7 @@ static int my_plugin_bclose(BFILE *bfd)
    if (!plugin || !jcr->plugin_ctx) {
       return 0;
    }
+   stop_plugin_readahead((bacula_ctx *)jcr->plugin_ctx->bContext);
    io.pkt_size = sizeof(io);
    io.pkt_end = sizeof(io);
    io.func = IO_CLOSE;
@@ -1324,6 +1559,7 @@ static ssize_t my_plugin_bread(BFILE *bfd, void *buf, size_t count)
 {
    JCR *jcr = bfd->jcr;
    Plugin *plugin = (Plugin *)jcr->plugin;
+   bacula_ctx *b_ctx;
    struct io_pkt io;
 
    Dsm_check(999);
@@ -1331,16 +1567,15 @@ static ssize_t my_plugin_bread(BFILE *bfd, void *buf, size_t count)
    if (!plugin || !jcr->plugin_ctx) {
       return 0;
    }
-   io.pkt_size = sizeof(io);
-   io.pkt_end = sizeof(io);
-   io.func = IO_READ;
-   io.count = count;
-   io.buf = (char *)buf;
-   io.win32 = false;
-   io.offset = 0;
-   io.lerror = 0;
-   io.status = -1;
-   plug_func(plugin)->pluginIO(jcr->plugin_ctx, &io);
+   b_ctx = (bacula_ctx *)jcr->plugin_ctx->bContext;
+   if (b_ctx->read_ahead > 0 && !b_ctx->ra && jcr->plugin_sp &&
+       jcr->getJobType() == JT_BACKUP) {
+      b_ctx->ra = start_plugin_readahead(jcr, b_ctx, (int32_t)count);
+   }
+   if (b_ctx->ra) {
+      return plugin_readahead_read(b_ctx->ra, bfd, (char *)buf, (int32_t)count);
+   }
+   plugin_read_io(plugin, jcr->plugin_ctx, &io, (char *)buf, (int32_t)count);
    bfd->offset = io.offset;
    bfd->berrno = io.io_errno;
    if (io.win32) {
@@ -1529,6 +1764,9 @@ static bRC baculaGetValue(bpContext *ctx, bVariable var, void *value)
    case bVarPrefixLinks:
       *(int *)value = (int)jcr->prefix_links;
       break;
+   case bVarReadAhead:
+      *(int *)value = ((bacula_ctx *)ctx->bContext)->read_ahead;
+      break;
    case bVarFDName:             /* get warning with g++ if we missed one */
    case bVarWorkingDir:
    case bVarExePath:
@@ -1560,6 +1798,14 @@ static bRC baculaSetValue(bpContext *ctx, bVariable var, void *value)
          return bRC_Error;
       }
       break;
+   case bVarReadAhead:
+      {
+         bacula_ctx *b_ctx = (bacula_ctx *)ctx->bContext;
+         int nbuf = *(int *)value;
+         b_ctx->read_ahead = MAX(0, MIN(nbuf, PLUGIN_MAX_READAHEAD));
+         Dmsg1(dbglvl, "Plugin read ahead=%d\n", b_ctx->read_ahead);
+      }
+      break;
    default:
       break;
    }
@@ -132,6 +132,11 @@ enum {
    IO_SEEK = 5
 };
 
+/*
+ * On IO_READ, the plugin may either copy the data into buf, or point
+ *  buf to its own buffer holding status bytes.  That buffer must stay
+ *  valid until the next call to pluginIO().
+ */
 struct io_pkt {
    int32_t pkt_size;                  /* Size of this packet */
    int32_t func;                      /* Function code */
@@ -177,7 +182,8 @@ typedef enum {
   bVarDistName   = 18,
   bVarBEEF       = 19,
   bVarPrevJobName = 20,
-  bVarPrefixLinks = 21
+  bVarPrefixLinks = 21,
+  bVarReadAhead   = 22                /* int, buffers read ahead by a thread */
 } bVariable;
 
 /* Events that are passed to plugin */
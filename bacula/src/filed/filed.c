@@ -240,6 +240,7 @@ int main (int argc, char *argv[])
 
    if (!no_signals) {
       start_watchdog();               /* start watchdog thread */
+      start_message_delivery();       /* start async message delivery thread */
       init_jcr_subsystem();           /* start JCR watchdogs etc. */
    }
    server_tid = pthread_self();
@@ -322,6 +323,10 @@ static bool check_resources()
          OK = false;
       }
       my_name_is(0, NULL, me->hdr.name);
+      set_tls_kernel_offload(me->tls_kernel_offload);
+      bw_sched_set_weight(BW_CLASS_BACKUP, me->backup_bw_weight);
+      bw_sched_set_weight(BW_CLASS_RESTORE, me->restore_bw_weight);
+      bw_sched_init(me->max_bandwidth);
       if (!me->messages) {
          me->messages = (MSGS *)GetNextRes(R_MSGS, NULL);
          if (!me->messages) {
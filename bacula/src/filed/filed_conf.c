@@ -90,6 +90,8 @@ static RES_ITEM cli_items[] = {
    {"plugindirectory",  store_dir,  ITEM(res_client.plugin_directory),  0, 0, 0},
    {"scriptsdirectory", store_dir,  ITEM(res_client.scripts_directory),  0, 0, 0},
    {"maximumconcurrentjobs", store_pint32,  ITEM(res_client.MaxConcurrentJobs), 0, ITEM_DEFAULT, 20},
+   {"maximumrestorethreads", store_pint32,  ITEM(res_client.max_restore_threads), 0, ITEM_DEFAULT, 0},
+   {"offloaddigests", store_bool,   ITEM(res_client.offload_digests), 0, ITEM_DEFAULT, false},
    {"messages",      store_res, ITEM(res_client.messages), R_MSGS, 0, 0},
    {"sdconnecttimeout", store_time,ITEM(res_client.SDConnectTimeout), 0, ITEM_DEFAULT, 60 * 30},
    {"heartbeatinterval", store_time, ITEM(res_client.heartbeat_interval), 0, ITEM_DEFAULT, 0},
@@ -106,12 +108,16 @@ static RES_ITEM cli_items[] = {
    {"tlsauthenticate",       store_bool,    ITEM(res_client.tls_authenticate),  0, 0, 0},
    {"tlsenable",             store_bool,    ITEM(res_client.tls_enable),  0, 0, 0},
    {"tlsrequire",            store_bool,    ITEM(res_client.tls_require), 0, 0, 0},
+   {"tlskerneloffload",      store_bool,    ITEM(res_client.tls_kernel_offload), 0, ITEM_DEFAULT, false},
    {"tlscacertificatefile",  store_dir,       ITEM(res_client.tls_ca_certfile), 0, 0, 0},
    {"tlscacertificatedir",   store_dir,       ITEM(res_client.tls_ca_certdir), 0, 0, 0},
    {"tlscertificate",        store_dir,       ITEM(res_client.tls_certfile), 0, 0, 0},
    {"tlskey",                store_dir,       ITEM(res_client.tls_keyfile), 0, 0, 0},
    {"verid",                 store_str,       ITEM(res_client.verid), 0, 0, 0},
    {"maximumbandwidthperjob",store_speed,   ITEM(res_client.max_bandwidth_per_job), 0, 0, 0},
+   {"maximumbandwidth",      store_speed,   ITEM(res_client.max_bandwidth), 0, 0, 0},
+   {"backupbandwidthweight", store_pint32,  ITEM(res_client.backup_bw_weight), 0, ITEM_DEFAULT, 2},
+   {"restorebandwidthweight", store_pint32, ITEM(res_client.restore_bw_weight), 0, ITEM_DEFAULT, 4},
    {"disablecommand",        store_alist_str, ITEM(res_client.disable_cmds), 0, 0, 0},
    {NULL, NULL, {0}, 0, 0, 0}
 };
@@ -164,6 +170,9 @@ struct s_ct ciphertypes[] = {
    {"aes192",        CRYPTO_CIPHER_AES_192_CBC},
    {"aes256",        CRYPTO_CIPHER_AES_256_CBC},
    {"blowfish",      CRYPTO_CIPHER_BLOWFISH_CBC},
+   {"aes128gcm",     CRYPTO_CIPHER_AES_128_GCM},
+   {"aes256gcm",     CRYPTO_CIPHER_AES_256_GCM},
+   {"chacha20poly1305", CRYPTO_CIPHER_CHACHA20_POLY1305},
    {NULL,            0}
 };
 
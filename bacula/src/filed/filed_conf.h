@@ -72,6 +72,8 @@ struct CLIENT {
    char *scripts_directory;
    MSGS *messages;                    /* daemon message handler */
    uint32_t MaxConcurrentJobs;
+   uint32_t max_restore_threads;      /* Threads decompressing restored data */
+   bool offload_digests;              /* Compute backup digests on other threads */
    utime_t SDConnectTimeout;          /* timeout in seconds */
    utime_t heartbeat_interval;        /* Interval to send heartbeats */
    uint32_t max_network_buffer_size;  /* max network buf size */
@@ -85,6 +87,7 @@ struct CLIENT {
    bool tls_authenticate;             /* Authenticate with TLS */
    bool tls_enable;                   /* Enable TLS */
    bool tls_require;                  /* Require TLS */
+   bool tls_kernel_offload;           /* Let the kernel do the TLS encryption */
    char *tls_ca_certfile;             /* TLS CA Certificate File */
    char *tls_ca_certdir;              /* TLS CA Certificate Directory */
    char *tls_certfile;                /* TLS Client Certificate File */
@@ -96,6 +99,9 @@ struct CLIENT {
    TLS_CONTEXT *tls_ctx;              /* Shared TLS Context */
    char *verid;                       /* Custom Id to print in version command */
    uint64_t max_bandwidth_per_job;    /* Bandwidth limitation (global) */
+   uint64_t max_bandwidth;            /* Bandwidth shared by all the jobs */
+   uint32_t backup_bw_weight;         /* Share of max_bandwidth for backups */
+   uint32_t restore_bw_weight;        /* Share of max_bandwidth for restores */
    alist *disable_cmds;               /* Commands to disable */
    bool *disabled_cmds_array;         /* Disabled commands array */
 };
@@ -83,6 +83,7 @@ static int restore_object_cmd(JCR *jcr);
 static int set_options(findFOPTS *fo, const char *opts);
 static void set_storage_auth_key(JCR *jcr, char *key);
 static int sm_dump_cmd(JCR *jcr);
+static int profile_cmd(JCR *jcr);
 #ifdef DEVELOPER
 static int exit_cmd(JCR *jcr);
 #endif
@@ -117,6 +118,7 @@ struct s_cmds cmds[] = {
    {"accurate",     accurate_cmd,  0},
    {"restoreobject", restore_object_cmd, 0},
    {"sm_dump",      sm_dump_cmd, 0},
+   {"profile ",     profile_cmd, 0},
 #ifdef DEVELOPER
    {"exit",         exit_cmd, 0},
 #endif
@@ -147,7 +149,7 @@ static char restoreobjcmd[]  = "restoreobject JobId=%u %d,%d,%d,%d,%d,%d,%s";
 static char restoreobjcmd1[] = "restoreobject JobId=%u %d,%d,%d,%d,%d,%d\n";
 static char endrestoreobjectcmd[] = "restoreobject end\n";
 static char verifycmd[]   = "verify level=%30s";
-static char estimatecmd[] = "estimate listing=%d";
+static char estimatecmd[] = "estimate listing=%d fast=%d";
 static char runbefore[]   = "RunBeforeJob %s";
 static char runafter[]    = "RunAfterJob %s";
 static char runscript[]   = "Run OnSuccess=%d OnFailure=%d AbortOnError=%d When=%d Command=%s";
@@ -516,6 +518,18 @@ static int sm_dump_cmd(JCR *jcr)
    return 1;
 }
 
+/*
+ * Start, stop or query the sampling profiler, see lib/profiler.c
+ */
+static int profile_cmd(JCR *jcr)
+{
+   BSOCK *dir = jcr->dir_bsock;
+   POOL_MEM msg(PM_MESSAGE);
+
+   profiler_command(dir->msg, msg.addr());
+   return dir->fsend("%s", msg.c_str());
+}
+
 #ifdef DEVELOPER
 static int exit_cmd(JCR *jcr)
 {
@@ -678,7 +692,9 @@ static int estimate_cmd(JCR *jcr)
    BSOCK *dir = jcr->dir_bsock;
    char ed1[50], ed2[50];
 
-   if (sscanf(dir->msg, estimatecmd, &jcr->listing) != 1) {
+   /* fast= is not sent by older Directors */
+   jcr->fast_estimate = 0;
+   if (sscanf(dir->msg, estimatecmd, &jcr->listing, &jcr->fast_estimate) < 1) {
       pm_strcpy(jcr->errmsg, dir->msg);
       Jmsg(jcr, M_FATAL, 0, _("Bad estimate command: %s"), jcr->errmsg);
       dir->fsend(_("2992 Bad estimate command.\n"));
@@ -931,7 +947,10 @@ static int restore_object_cmd(JCR *jcr)
       jcr->got_metadata = true;
    }
 
-   generate_plugin_event(jcr, bEventRestoreObject, (void *)&rop);
+   /* ACL/xattr dictionary is for us, not for the plugins */
+   if (!load_metadata_dict(jcr, rop.object_name, rop.object, rop.object_len)) {
+      generate_plugin_event(jcr, bEventRestoreObject, (void *)&rop);
+   }
 
    if (rop.object_name) {
       free(rop.object_name);
@@ -1616,6 +1635,12 @@ static int set_options(findFOPTS *fo, const char *opts)
       case 'X':
          fo->flags |= FO_XATTR;
          break;
+      case 'L':                 /* compact stat packets */
+         fo->flags |= FO_COMPACT_ATTR;
+         break;
+      case 'Q':                 /* send identical ACLs/xattrs once */
+         fo->dedup_metadata = true;
+         break;
       default:
          Jmsg1(NULL, M_ERROR, 0, _("Unknown include/exclude option: %c\n"), *p);
          break;
@@ -1641,9 +1666,11 @@ static int fileset_cmd(JCR *jcr)
    if (!init_fileset(jcr)) {
       return 0;
    }
+   jcr->fileset_hash = 0;
    while (dir->recv() >= 0) {
       strip_trailing_junk(dir->msg);
       Dmsg1(500, "Fileset: %s\n", dir->msg);
+      jcr->fileset_hash = jcr->fileset_hash * 31 + hash_string(dir->msg);
       pm_strcpy(buf, dir->msg);
       add_fileset(jcr, buf.c_str());
    }
@@ -1990,6 +2017,7 @@ static int backup_cmd(JCR *jcr)
       dir->fsend(BADcmd, "backup");
       goto cleanup;
    }
+   sd->set_bwclass(BW_CLASS_BACKUP);
 
    dir->fsend(OKbackup);
    Dmsg1(110, "filed>dird: %s", dir->msg);
@@ -2271,6 +2299,9 @@ static int restore_cmd(JCR *jcr)
 
    jcr->setJobStatus(JS_Blocked);
 
+   if (sd) {
+      sd->set_bwclass(BW_CLASS_RESTORE);
+   }
    if (!open_sd_read_session(jcr)) {
       jcr->setJobStatus(JS_ErrorTerminated);
       goto bail_out;
@@ -2408,6 +2439,8 @@ static void filed_free_jcr(JCR *jcr)
    free_runscripts(jcr->RunScripts);
    delete jcr->RunScripts;
    free_path_list(jcr);
+   free_metadata_dict(jcr);
+   free_digest_pipe(jcr);
 
    if (jcr->JobId != 0)
       write_state_file(me->working_directory, "bacula-fd", get_first_port_host_order(me->FDaddrs));
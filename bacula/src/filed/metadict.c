@@ -0,0 +1,357 @@
+/*
+   Bacula® - The Network Backup Solution
+
+   Copyright (C) 2014-2014 Free Software Foundation Europe e.V.
+
+   The main author of Bacula is Kern Sibbald, with contributions from many
+   others, a complete list can be found in the file AUTHORS.
+
+   You may use this file and others of this release according to the
+   license defined in the LICENSE file, which includes the Affero General
+   Public License, v3.0 ("AGPLv3") and some additional permissions and
+   terms pursuant to its AGPLv3 Section 7.
+
+   Bacula® is a registered trademark of Kern Sibbald.
+*/
+/*
+ * Dictionary of ACL and Extended Attribute streams.
+ *
+ * On file servers many files carry exactly the same ACL or the same
+ *  set of extended attributes.  When "Dedup Metadata = yes" is set in
+ *  the FileSet Options, the first occurrence of each ACL/xattr stream
+ *  is sent as usual, and every following occurrence in the same Job
+ *  is replaced by a small STREAM_ACL_REF or STREAM_XATTR_REF record
+ *  that holds the original stream number, the length and the SHA1
+ *  digest of the content.
+ *
+ * At the end of the backup, the streams that were referenced are saved
+ *  as a Restore Object.  The Director sends it back before a restore,
+ *  so the references can be resolved even when the file holding the
+ *  first occurrence is not part of the restore.
+ */
+
+#include "bacula.h"
+#include "filed.h"
+
+static const int dbglvl = 200;
+
+/* Name of the Restore Object holding the dictionary */
+static const char *metadict_object_name = "bacula_metadata_dict";
+
+/* Limit the memory used by one Job, past it streams are sent in full */
+#define METADICT_MAX_SIZE   (32 * 1024 * 1024)
+
+/* Streams not longer than a reference are always sent in full */
+#define METADICT_MIN_LEN    64
+
+struct META_BLOB {
+   hlink link;
+   int32_t stream;                    /* original ACL or xattr stream */
+   uint32_t len;                      /* length of data */
+   bool referenced;                   /* sent at least once as reference */
+   uint8_t digest[SHA1HashSize];      /* digest of stream and data */
+   char data[1];                      /* content, malloced with the blob */
+};
+
+struct META_DICT {
+   htable *blobs;                     /* blobs indexed by digest */
+   uint64_t size;                     /* bytes held by the blobs */
+   uint32_t nr_refs;                  /* references sent or resolved */
+   uint64_t saved;                    /* bytes not sent to the SD */
+};
+
+static void compute_digest(int32_t stream, char *content, uint32_t len,
+                           uint8_t *digest)
+{
+   SHA1Context ctx;
+   uint32_t s = htonl((uint32_t)stream);
+
+   SHA1Init(&ctx);
+   SHA1Update(&ctx, (const uint8_t *)&s, sizeof(s));
+   SHA1Update(&ctx, (const uint8_t *)content, len);
+   SHA1Final(&ctx, digest);
+}
+
+/* The htable key is simply the first 64 bits of the digest */
+static uint64_t digest_key(uint8_t *digest)
+{
+   uint64_t key;
+   memcpy(&key, digest, sizeof(key));
+   return key;
+}
+
+static void digest_to_hex(uint8_t *digest, char *buf)
+{
+   static const char hex[] = "0123456789abcdef";
+   for (int i=0; i < SHA1HashSize; i++) {
+      *buf++ = hex[digest[i] >> 4];
+      *buf++ = hex[digest[i] & 0xF];
+   }
+   *buf = 0;
+}
+
+static bool hex_to_digest(const char *buf, uint8_t *digest)
+{
+   for (int i=0; i < SHA1HashSize; i++) {
+      int val = 0;
+      for (int j=0; j < 2; j++) {
+         char c = *buf++;
+         val <<= 4;
+         if (c >= '0' && c <= '9') {
+            val += c - '0';
+         } else if (c >= 'a' && c <= 'f') {
+            val += c - 'a' + 10;
+         } else {
+            return false;
+         }
+      }
+      digest[i] = val;
+   }
+   return *buf == 0;
+}
+
+static META_DICT *new_metadata_dict()
+{
+   META_DICT *dict;
+   META_BLOB *blob = NULL;
+
+   dict = (META_DICT *)malloc(sizeof(META_DICT));
+   memset(dict, 0, sizeof(META_DICT));
+   dict->blobs = (htable *)malloc(sizeof(htable));
+   dict->blobs->init(blob, &blob->link, 1000);
+   return dict;
+}
+
+/*
+ * Find a blob, or add it if there is still room.  Returns NULL when
+ *  the blob is not known and cannot be added, or if another blob
+ *  has the same key.
+ */
+static META_BLOB *intern_blob(META_DICT *dict, int32_t stream, char *content,
+                              uint32_t len, uint8_t *digest, bool *added)
+{
+   META_BLOB *blob;
+   uint64_t key = digest_key(digest);
+
+   *added = false;
+   blob = (META_BLOB *)dict->blobs->lookup(key);
+   if (blob) {
+      if (blob->stream == stream && blob->len == len &&
+          memcmp(blob->digest, digest, SHA1HashSize) == 0) {
+         return blob;
+      }
+      return NULL;
+   }
+   if (dict->size + len > METADICT_MAX_SIZE) {
+      return NULL;
+   }
+   blob = (META_BLOB *)dict->blobs->hash_malloc(sizeof(META_BLOB) + len);
+   blob->stream = stream;
+   blob->len = len;
+   blob->referenced = false;
+   memcpy(blob->digest, digest, SHA1HashSize);
+   memcpy(blob->data, content, len);
+   dict->blobs->insert(key, blob);
+   dict->size += len;
+   *added = true;
+   return blob;
+}
+
+/*
+ * Called at the start of a backup, the dictionary is used only
+ *  if one of the Include Options asks for it.
+ */
+void init_metadata_dict(JCR *jcr)
+{
+   findFILESET *fileset = jcr->ff->fileset;
+
+   if (!fileset || jcr->meta_dict) {
+      return;
+   }
+   for (int i=0; i < fileset->include_list.size(); i++) {
+      findINCEXE *incexe = (findINCEXE *)fileset->include_list.get(i);
+      for (int j=0; j < incexe->opts_list.size(); j++) {
+         findFOPTS *fo = (findFOPTS *)incexe->opts_list.get(j);
+         if (fo->dedup_metadata) {
+            jcr->meta_dict = new_metadata_dict();
+            Dmsg0(dbglvl, "ACL/xattr dictionary enabled\n");
+            return;
+         }
+      }
+   }
+}
+
+/*
+ * Called by send_acl_stream() and send_xattr_stream() with the exact
+ *  buffer that would be sent to the SD.
+ *
+ * Returns: 1  if a reference was sent in place of the stream
+ *          0  if the caller must send the stream itself
+ *         -1  on network error
+ */
+int send_metadata_ref(JCR *jcr, int stream, char *content, uint32_t len)
+{
+   META_DICT *dict = jcr->meta_dict;
+   BSOCK *sd = jcr->store_bsock;
+   META_BLOB *blob;
+   uint8_t digest[SHA1HashSize];
+   char hex[SHA1HashSize * 2 + 1];
+   int ref_stream;
+   bool added;
+
+   if (!dict || len <= METADICT_MIN_LEN) {
+      return 0;
+   }
+   compute_digest(stream, content, len, digest);
+   blob = intern_blob(dict, stream, content, len, digest, &added);
+   if (!blob || added) {
+      return 0;                       /* first occurrence, or no room */
+   }
+
+   ref_stream = stream < STREAM_ACL_REF ? STREAM_ACL_REF : STREAM_XATTR_REF;
+   if (!sd->fsend("%ld %d 0", jcr->JobFiles, ref_stream)) {
+      goto bail_out;
+   }
+   digest_to_hex(digest, hex);
+   sd->msglen = Mmsg(sd->msg, "%d %u %s", stream, len, hex) + 1;
+   if (!sd->send()) {
+      goto bail_out;
+   }
+   jcr->JobBytes += sd->msglen;
+   if (!sd->signal(BNET_EOD)) {
+      goto bail_out;
+   }
+   blob->referenced = true;
+   dict->nr_refs++;
+   dict->saved += len;
+   Dmsg3(dbglvl, "Sent reference for stream=%d len=%u of %s\n", stream, len,
+         jcr->last_fname);
+   return 1;
+
+bail_out:
+   Jmsg1(jcr, M_FATAL, 0, _("Network send error to SD. ERR=%s\n"),
+         sd->bstrerror());
+   return -1;
+}
+
+/*
+ * At the end of the backup, save the blobs that were referenced in a
+ *  Restore Object.  Each entry is "<stream> <length>\n" followed by
+ *  the content.
+ */
+void save_metadata_dict(JCR *jcr)
+{
+   META_DICT *dict = jcr->meta_dict;
+   META_BLOB *blob;
+   POOL_MEM obj(PM_MESSAGE);
+   char ed1[50];
+   int32_t len = 0;
+   int nr_blobs = 0;
+
+   if (!dict || dict->nr_refs == 0) {
+      return;
+   }
+   foreach_htable(blob, dict->blobs) {
+      if (!blob->referenced) {
+         continue;
+      }
+      obj.check_size(len + blob->len + 50);
+      len += bsnprintf(obj.c_str() + len, 50, "%d %u\n", blob->stream, blob->len);
+      memcpy(obj.c_str() + len, blob->data, blob->len);
+      len += blob->len;
+      nr_blobs++;
+   }
+
+   FF_PKT *ff_pkt = jcr->ff;
+   ff_pkt->fname = (char *)"*all*";
+   ff_pkt->type = FT_RESTORE_FIRST;
+   ff_pkt->flags &= ~(FO_ACL|FO_XATTR);
+   ff_pkt->LinkFI = 0;
+   ff_pkt->object_name = (char *)metadict_object_name;
+   ff_pkt->object = obj.c_str();
+   ff_pkt->object_len = len;
+   ff_pkt->object_index = (int)time(NULL);
+   save_file(jcr, ff_pkt, true);
+
+   Jmsg(jcr, M_INFO, 0, _("%d ACL/xattr streams replaced by references to %d unique streams, %s bytes saved.\n"),
+        dict->nr_refs, nr_blobs, edit_uint64_with_commas(dict->saved, ed1));
+}
+
+/*
+ * Called by restore_object_cmd(), returns false if the object
+ *  is not ours.
+ */
+bool load_metadata_dict(JCR *jcr, char *object_name, char *object, int32_t len)
+{
+   META_DICT *dict;
+   char *p = object, *end = object + len;
+   uint8_t digest[SHA1HashSize];
+   bool added;
+
+   if (strcmp(object_name, metadict_object_name) != 0) {
+      return false;
+   }
+   if (!jcr->meta_dict) {
+      jcr->meta_dict = new_metadata_dict();
+   }
+   dict = jcr->meta_dict;
+   while (p < end) {
+      int32_t stream;
+      uint32_t blen;
+      char *data = (char *)memchr(p, '\n', end - p);
+      if (!data || sscanf(p, "%d %u", &stream, &blen) != 2 ||
+          blen > (uint32_t)(end - data - 1)) {
+         Jmsg(jcr, M_WARNING, 0, _("Malformed ACL/xattr dictionary ignored.\n"));
+         break;
+      }
+      data++;
+      compute_digest(stream, data, blen, digest);
+      intern_blob(dict, stream, data, blen, digest, &added);
+      p = data + blen;
+   }
+   Dmsg1(dbglvl, "Loaded ACL/xattr dictionary, %lld bytes\n", dict->size);
+   return true;
+}
+
+/*
+ * Resolve a STREAM_ACL_REF or STREAM_XATTR_REF record received during
+ *  a restore.  On success, returns the content and sets the original
+ *  stream and the length.
+ */
+char *resolve_metadata_ref(JCR *jcr, char *ref, int32_t *stream, uint32_t *len)
+{
+   META_BLOB *blob;
+   uint8_t digest[SHA1HashSize];
+   char hex[SHA1HashSize * 2 + 1];
+
+   if (sscanf(ref, "%d %u %40s", stream, len, hex) != 3 ||
+       !hex_to_digest(hex, digest)) {
+      Jmsg(jcr, M_WARNING, 0, _("Malformed ACL/xattr reference for \"%s\".\n"),
+           jcr->last_fname);
+      return NULL;
+   }
+   if (jcr->meta_dict) {
+      blob = (META_BLOB *)jcr->meta_dict->blobs->lookup(digest_key(digest));
+      if (blob && blob->stream == *stream && blob->len == *len &&
+          memcmp(blob->digest, digest, SHA1HashSize) == 0) {
+         jcr->meta_dict->nr_refs++;
+         return blob->data;
+      }
+   }
+   Jmsg(jcr, M_WARNING, 0, _("ACL/xattr stream %d referenced by \"%s\" not found in the dictionary.\n"),
+        *stream, jcr->last_fname);
+   return NULL;
+}
+
+void free_metadata_dict(JCR *jcr)
+{
+   META_DICT *dict = jcr->meta_dict;
+
+   if (!dict) {
+      return;
+   }
+   jcr->meta_dict = NULL;
+   dict->blobs->destroy();
+   free(dict->blobs);
+   free(dict);
+}
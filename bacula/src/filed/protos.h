@@ -25,6 +25,12 @@ extern int authenticate_director(JCR *jcr);
 extern int authenticate_storagedaemon(JCR *jcr);
 extern int make_estimate(JCR *jcr);
 
+/* From restore.c */
+bool sparse_data(JCR *jcr, BFILE *bfd, uint64_t *addr, char **data, uint32_t *length);
+bool decompress_buffer(JCR *jcr, int32_t stream, char **data, uint32_t *length,
+                       POOLMEM **buf, int32_t *buf_size);
+bool store_data(JCR *jcr, BFILE *bfd, char *data, const int32_t length, bool win32_decomp);
+
 /* From verify.c */
 int digest_file(JCR *jcr, FF_PKT *ff_pkt, DIGEST *digest);
 void do_verify(JCR *jcr);
@@ -49,11 +55,34 @@ void accurate_free(JCR *jcr);
 bool encode_and_send_attributes(JCR *jcr, FF_PKT *ff_pkt, int &data_stream);
 void strip_path(FF_PKT *ff_pkt);
 void unstrip_path(FF_PKT *ff_pkt);
+int save_file(JCR *jcr, FF_PKT *ff_pkt, bool top_level);
 
 /* from xattr.c */
 bxattr_exit_code build_xattr_streams(JCR *jcr, FF_PKT *ff_pkt);
 bxattr_exit_code parse_xattr_streams(JCR *jcr, int stream, char *content, uint32_t content_length);
 
+/* from metadict.c */
+void init_metadata_dict(JCR *jcr);
+int send_metadata_ref(JCR *jcr, int stream, char *content, uint32_t len);
+void save_metadata_dict(JCR *jcr);
+bool load_metadata_dict(JCR *jcr, char *object_name, char *object, int32_t len);
+char *resolve_metadata_ref(JCR *jcr, char *ref, int32_t *stream, uint32_t *len);
+void free_metadata_dict(JCR *jcr);
+
+/* from restore_pipe.c */
+void init_restore_pipe(JCR *jcr, int nr_threads);
+bool restore_pipe_submit(JCR *jcr, BFILE *bfd, uint64_t *addr, int flags,
+                         int32_t stream, char *data, uint32_t len);
+bool drain_restore_pipe(JCR *jcr);
+void free_restore_pipe(JCR *jcr);
+
+/* from digest_pipe.c */
+void init_digest_pipe(JCR *jcr);
+void digest_pipe_update(JCR *jcr, DIGEST *digest, DIGEST *signing_digest,
+                        char *data, uint32_t len);
+void drain_digest_pipe(JCR *jcr);
+void free_digest_pipe(JCR *jcr);
+
 /* from job.c */
 findINCEXE *new_exclude(JCR *jcr);
 findINCEXE *new_preinclude(JCR *jcr);
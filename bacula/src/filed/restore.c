@@ -80,6 +80,7 @@ static void deallocate_cipher(r_ctx &rctx);
 static void deallocate_fork_cipher(r_ctx &rctx);
 static void free_signature(r_ctx &rctx);
 static void free_session(r_ctx &rctx);
+static bool open_data_record(JCR *jcr, r_ctx &rctx, BSOCK *sd);
 static bool close_previous_stream(JCR *jcr, r_ctx &rctx);
 static bool verify_signature(JCR *jcr, r_ctx &rctx);
 int32_t extract_data(JCR *jcr, BFILE *bfd, POOLMEM *buf, int32_t buflen,
@@ -141,6 +142,18 @@ static bool restore_finderinfo(JCR *jcr, POOLMEM *buf, int32_t buflen)
  * Cleanup of delayed restore stack with streams for later
  * processing.
  */
+/*
+ * Wait for the data of the current file that is still in the restore
+ *  pipeline.  If one of the writes failed, stop extracting the file.
+ */
+static void drain_restore_data(JCR *jcr, r_ctx &rctx)
+{
+   if (jcr->rpipe && !drain_restore_pipe(jcr)) {
+      rctx.extract = false;
+      bclose(&rctx.bfd);
+   }
+}
+
 static inline void drop_delayed_restore_streams(r_ctx &rctx, bool reuse)
 {
    RESTORE_DATA_STREAM *rds;
@@ -408,8 +421,13 @@ void do_restore(JCR *jcr)
    }
 #endif
 
+   if (client) {
+      init_restore_pipe(jcr, client->max_restore_threads);
+   }
+
    if (have_crypto) {
       rctx.cipher_ctx.buf = get_memory(CRYPTO_CIPHER_MAX_BLOCK_SIZE);
+      rctx.aead_buf = get_pool_memory(PM_MESSAGE);
       if (have_darwin_os) {
          rctx.fork_cipher_ctx.buf = get_memory(CRYPTO_CIPHER_MAX_BLOCK_SIZE);
       }
@@ -496,6 +514,50 @@ void do_restore(JCR *jcr)
       Dmsg3(130, "Got stream: %s len=%d extract=%d\n", stream_to_ascii(rctx.stream),
             sd->msglen, rctx.extract);
 
+      /*
+       * A reference to an ACL or XATTR stream sent for an other file,
+       * replace it by the content found in the dictionary and handle
+       * it as the original stream.
+       */
+      if (rctx.stream == STREAM_ACL_REF || rctx.stream == STREAM_XATTR_REF) {
+         int32_t ref_stream;
+         uint32_t ref_len;
+         char *content;
+
+         if ((!rctx.extract && jcr->last_type != FT_DIREND) ||
+             (*jcr->last_fname == 0)) {
+            continue;
+         }
+         content = resolve_metadata_ref(jcr, sd->msg, &ref_stream, &ref_len);
+         if (!content) {
+            continue;
+         }
+         sd->msg = check_pool_memory_size(sd->msg, ref_len + 1);
+         memcpy(sd->msg, content, ref_len);
+         sd->msglen = ref_len;
+         rctx.stream = ref_stream;
+      }
+
+      /*
+       * A record sealed with an AEAD cipher, open it and handle it
+       * as the original stream.
+       */
+      if (rctx.stream == STREAM_AEAD_DATA) {
+         if (!open_data_record(jcr, rctx, sd)) {
+            rctx.extract = false;
+            bclose(&rctx.bfd);
+            continue;
+         }
+         if (rctx.aead_last) {
+            continue;                 /* end of the sealed stream */
+         }
+      }
+
+      /* The data of the previous stream must be on disk before we go on */
+      if (rctx.stream != rctx.prev_stream) {
+         drain_restore_data(jcr, rctx);
+      }
+
       /*
        * If we change streams, close and reset alternate data streams
        */
@@ -1036,6 +1098,7 @@ void do_restore(JCR *jcr)
          break;
       } /* end switch(stream) */
    } /* end while get_msg() */
+   drain_restore_data(jcr, rctx);
 
    /*
     * If output file is still open, it was the last one in the
@@ -1055,6 +1118,7 @@ bail_out:
    jcr->setJobStatus(JS_ErrorTerminated);
 
 ok_out:
+   free_restore_pipe(jcr);
    /*
     * First output the statistics.
     */
@@ -1122,6 +1186,10 @@ ok_out:
       free_pool_memory(rctx.fork_cipher_ctx.buf);
       rctx.fork_cipher_ctx.buf = NULL;
    }
+   if (rctx.aead_buf) {
+      free_pool_memory(rctx.aead_buf);
+      rctx.aead_buf = NULL;
+   }
 
    if (jcr->compress_buf) {
       free_pool_memory(jcr->compress_buf);
@@ -1344,6 +1412,18 @@ bool sparse_data(JCR *jcr, BFILE *bfd, uint64_t *addr, char **data, uint32_t *le
 }
 
 bool decompress_data(JCR *jcr, int32_t stream, char **data, uint32_t *length)
+{
+   return decompress_buffer(jcr, stream, data, length, &jcr->compress_buf,
+                            &jcr->compress_buf_size);
+}
+
+/*
+ * Decompress data into buf, that is grown if needed.  This is called
+ *  by the restore pipeline workers, so it must not touch the jcr
+ *  except to send messages.
+ */
+bool decompress_buffer(JCR *jcr, int32_t stream, char **data, uint32_t *length,
+                       POOLMEM **buf, int32_t *buf_size)
 {
 #if defined(HAVE_LZO) || defined(HAVE_LIBZ)
    char ec1[50]; /* Buffer printing huge values */
@@ -1385,27 +1465,26 @@ bool decompress_data(JCR *jcr, int32_t stream, char **data, uint32_t *length)
       switch(comp_magic) {
 #ifdef HAVE_LZO
          case COMPRESS_LZO1X:
-            compress_len = jcr->compress_buf_size;
+            compress_len = *buf_size;
             cbuf = (const unsigned char*)*data + sizeof(comp_stream_header);
             real_compress_len = *length - sizeof(comp_stream_header);
             Dmsg2(200, "Comp_len=%d msglen=%d\n", compress_len, *length);
             while ((r=lzo1x_decompress_safe(cbuf, real_compress_len,
-                                            (unsigned char *)jcr->compress_buf, &compress_len, NULL)) == LZO_E_OUTPUT_OVERRUN)
+                                            (unsigned char *)*buf, &compress_len, NULL)) == LZO_E_OUTPUT_OVERRUN)
             {
                /*
                 * The buffer size is too small, try with a bigger one
                 */
-               compress_len = jcr->compress_buf_size = jcr->compress_buf_size + (jcr->compress_buf_size >> 1);
+               compress_len = *buf_size = *buf_size + (*buf_size >> 1);
                Dmsg2(200, "Comp_len=%d msglen=%d\n", compress_len, *length);
-               jcr->compress_buf = check_pool_memory_size(jcr->compress_buf,
-                                                    compress_len);
+               *buf = check_pool_memory_size(*buf, compress_len);
             }
             if (r != LZO_E_OK) {
                Qmsg(jcr, M_ERROR, 0, _("LZO uncompression error on file %s. ERR=%d\n"),
                     jcr->last_fname, r);
                return false;
             }
-            *data = jcr->compress_buf;
+            *data = *buf;
             *length = compress_len;
             Dmsg2(200, "Write uncompressed %d bytes, total before write=%s\n", compress_len, edit_uint64(jcr->JobBytes, ec1));
             return true;
@@ -1424,25 +1503,24 @@ bool decompress_data(JCR *jcr, int32_t stream, char **data, uint32_t *length)
        * needed by the zlib routines, they should not otherwise
        * be used in Bacula.
        */
-      compress_len = jcr->compress_buf_size;
+      compress_len = *buf_size;
       Dmsg2(200, "Comp_len=%d msglen=%d\n", compress_len, *length);
-      while ((stat=uncompress((Byte *)jcr->compress_buf, &compress_len,
+      while ((stat=uncompress((Byte *)*buf, &compress_len,
                               (const Byte *)*data, (uLong)*length)) == Z_BUF_ERROR)
       {
          /*
           * The buffer size is too small, try with a bigger one
           */
-         compress_len = jcr->compress_buf_size = jcr->compress_buf_size + (jcr->compress_buf_size >> 1);
+         compress_len = *buf_size = *buf_size + (*buf_size >> 1);
          Dmsg2(200, "Comp_len=%d msglen=%d\n", compress_len, *length);
-         jcr->compress_buf = check_pool_memory_size(jcr->compress_buf,
-                                                    compress_len);
+         *buf = check_pool_memory_size(*buf, compress_len);
       }
       if (stat != Z_OK) {
          Qmsg(jcr, M_ERROR, 0, _("Uncompression error on file %s. ERR=%s\n"),
               jcr->last_fname, zlib_strerror(stat));
          return false;
       }
-      *data = jcr->compress_buf;
+      *data = *buf;
       *length = compress_len;
       Dmsg2(200, "Write uncompressed %d bytes, total before write=%s\n", compress_len, edit_uint64(jcr->JobBytes, ec1));
       return true;
@@ -1603,24 +1681,31 @@ int32_t extract_data(JCR *jcr, BFILE *bfd, POOLMEM *buf, int32_t buflen,
       Dmsg2(130, "Encryption writing full block, %u bytes, remaining %u bytes in buffer\n", wsize, cipher_ctx->buf_len);
    }
 
-   if ((flags & FO_SPARSE) || (flags & FO_OFFSETS)) {
-      if (!sparse_data(jcr, bfd, addr, &wbuf, &wsize)) {
+   if ((flags & FO_COMPRESS) && jcr->rpipe) {
+      /* Decompressed and written later, see restore_pipe.c */
+      if (!restore_pipe_submit(jcr, bfd, addr, flags, stream, wbuf, wsize)) {
          goto bail_out;
       }
-   }
+   } else {
+      if ((flags & FO_SPARSE) || (flags & FO_OFFSETS)) {
+         if (!sparse_data(jcr, bfd, addr, &wbuf, &wsize)) {
+            goto bail_out;
+         }
+      }
 
-   if (flags & FO_COMPRESS) {
-      if (!decompress_data(jcr, stream, &wbuf, &wsize)) {
-         goto bail_out;
+      if (flags & FO_COMPRESS) {
+         if (!decompress_data(jcr, stream, &wbuf, &wsize)) {
+            goto bail_out;
+         }
       }
-   }
 
-   if (!store_data(jcr, bfd, wbuf, wsize, (flags & FO_WIN32DECOMP) != 0)) {
-      goto bail_out;
+      if (!store_data(jcr, bfd, wbuf, wsize, (flags & FO_WIN32DECOMP) != 0)) {
+         goto bail_out;
+      }
+      jcr->JobBytes += wsize;
+      *addr += wsize;
+      Dmsg2(130, "Write %u bytes, JobBytes=%s\n", wsize, edit_uint64(jcr->JobBytes, ec1));
    }
-   jcr->JobBytes += wsize;
-   *addr += wsize;
-   Dmsg2(130, "Write %u bytes, JobBytes=%s\n", wsize, edit_uint64(jcr->JobBytes, ec1));
 
    /*
     * Clean up crypto buffers
@@ -1653,6 +1738,10 @@ static bool close_previous_stream(JCR *jcr, r_ctx &rctx)
     * If extracting, it was from previous stream, so
     * close the output file and validate the signature.
     */
+   if (rctx.extract && rctx.aead_file) {
+      Jmsg1(jcr, M_ERROR, 0, _("Encrypted data of %s is truncated.\n"), jcr->last_fname);
+   }
+   rctx.aead_file = 0;
    if (rctx.extract) {
       if (rctx.size > 0 && !is_bopen(&rctx.bfd)) {
          Jmsg0(rctx.jcr, M_ERROR, 0, _("Logic error: output file should be open\n"));
@@ -1831,8 +1920,105 @@ static void free_signature(r_ctx &rctx)
    }
 }
 
+/*
+ * Open a record sealed by seal_data_record() in backup.c.  The clear
+ *  header gives the original stream, that is returned in rctx even
+ *  when we do not extract.  When we do, sd->msg is replaced by the
+ *  original record, and rctx.aead_last is set for the record that
+ *  closes the stream.
+ */
+static bool open_data_record(JCR *jcr, r_ctx &rctx, BSOCK *sd)
+{
+   uint8_t *buf = (uint8_t *)sd->msg;
+   int32_t stream, file_index;
+   uint32_t file_no, record_no, len, block_size;
+   uint64_t nonce;
+   POOLMEM *tmp;
+   unser_declare;
+
+   if (sd->msglen < STREAM_AEAD_HEADER_SIZE + CRYPTO_CIPHER_TAG_SIZE) {
+      Jmsg1(jcr, M_ERROR, 0, _("Malformed encrypted record for %s\n"), jcr->last_fname);
+      return false;
+   }
+   unser_begin(buf, STREAM_AEAD_HEADER_SIZE);
+   unser_int32(stream);
+   unser_int32(file_index);
+   unser_uint32(file_no);
+   unser_uint32(record_no);
+   rctx.full_stream = stream;
+   rctx.aead_last = false;
+   rctx.stream = stream & STREAMMASK_TYPE;
+   if (!rctx.extract) {
+      return true;
+   }
+
+   if (!rctx.aead_cipher) {
+      if (!rctx.cs) {
+         Jmsg1(jcr, M_ERROR, 0, _("Missing encryption session data stream for %s\n"), jcr->last_fname);
+         return false;
+      }
+      rctx.aead_cipher = crypto_cipher_new(rctx.cs, false, &block_size);
+      if (!rctx.aead_cipher || !crypto_cipher_is_aead(rctx.aead_cipher)) {
+         Jmsg1(jcr, M_ERROR, 0, _("Failed to initialize decryption context for %s\n"), jcr->last_fname);
+         free_session(rctx);
+         return false;
+      }
+   }
+
+   /*
+    * Each record opens alone, but the records of a stream belong to
+    *  the file being restored, are numbered from zero, and end with
+    *  a record giving their number.  A missing, replayed or swapped
+    *  record is an error, a truncated stream is found when the file
+    *  is closed.
+    */
+   if (file_index != rctx.attr->file_index) {
+      Jmsg1(jcr, M_ERROR, 0, _("Encrypted record of another file found for %s\n"),
+            jcr->last_fname);
+      return false;
+   }
+   nonce = ((uint64_t)file_no << 32) | record_no;
+   rctx.aead_last = (record_no & STREAM_AEAD_LAST_RECORD) != 0;
+   record_no &= ~STREAM_AEAD_LAST_RECORD;
+   if (rctx.aead_file == 0 && record_no == 0) {
+      rctx.aead_file = file_no;       /* start of a stream */
+      rctx.aead_next = 0;
+   }
+   if (file_no != rctx.aead_file || record_no != rctx.aead_next) {
+      Jmsg1(jcr, M_ERROR, 0, _("Encrypted record out of sequence for %s\n"), jcr->last_fname);
+      rctx.aead_file = 0;
+      return false;
+   }
+
+   len = sd->msglen - STREAM_AEAD_HEADER_SIZE;
+   rctx.aead_buf = check_pool_memory_size(rctx.aead_buf, len);
+   if (!crypto_cipher_open(rctx.aead_cipher, nonce, buf, STREAM_AEAD_HEADER_SIZE,
+          buf + STREAM_AEAD_HEADER_SIZE, len, (uint8_t *)rctx.aead_buf, &len)) {
+      Jmsg1(jcr, M_ERROR, 0, _("Decryption error, record of %s is damaged or was modified.\n"),
+            jcr->last_fname);
+      rctx.aead_file = 0;
+      return false;
+   }
+   if (rctx.aead_last) {
+      rctx.aead_file = 0;             /* all the records were seen */
+      return len == 0;
+   }
+   rctx.aead_next++;
+
+   /* Swap the buffers, sd->msg now holds the original record */
+   tmp = sd->msg;
+   sd->msg = rctx.aead_buf;
+   rctx.aead_buf = tmp;
+   sd->msglen = len;
+   return true;
+}
+
 static void free_session(r_ctx &rctx)
 {
+   if (rctx.aead_cipher) {
+      crypto_cipher_free(rctx.aead_cipher);
+      rctx.aead_cipher = NULL;
+   }
    if (rctx.cs) {
       crypto_session_free(rctx.cs);
       rctx.cs = NULL;
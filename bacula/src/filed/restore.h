@@ -55,6 +55,11 @@ struct r_ctx {
    CRYPTO_SESSION *cs;                 /* Cryptographic session data (if any) for file */
    RESTORE_CIPHER_CTX cipher_ctx;      /* Cryptographic restore context (if any) for file */
    RESTORE_CIPHER_CTX fork_cipher_ctx; /* Cryptographic restore context (if any) for alternative stream */
+   CIPHER_CONTEXT *aead_cipher;        /* AEAD decryption context (if any) for file */
+   uint32_t aead_file;                 /* AEAD stream being read, 0 if none */
+   uint32_t aead_next;                 /* Number of the next expected AEAD record */
+   bool aead_last;                     /* Last AEAD record, no data */
+   POOLMEM *aead_buf;                  /* Decrypted AEAD record */
 };
 
 #endif
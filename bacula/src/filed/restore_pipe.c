@@ -0,0 +1,263 @@
+/*
+   Bacula® - The Network Backup Solution
+
+   Copyright (C) 2014-2014 Free Software Foundation Europe e.V.
+
+   The main author of Bacula is Kern Sibbald, with contributions from many
+   others, a complete list can be found in the file AUTHORS.
+
+   You may use this file and others of this release according to the
+   license defined in the LICENSE file, which includes the Affero General
+   Public License, v3.0 ("AGPLv3") and some additional permissions and
+   terms pursuant to its AGPLv3 Section 7.
+
+   Bacula® is a registered trademark of Kern Sibbald.
+*/
+/*
+ * Restore pipeline, decompress the data records on several threads.
+ *
+ * When "Maximum Restore Threads" is set in the FileDaemon resource,
+ *  extract_data() gives each compressed record to this pipeline
+ *  instead of decompressing it inline.  The records are decrypted
+ *  before, in the job thread, because the cipher context is chained
+ *  from one record to the next.  A pool of workers inflates them in
+ *  parallel, and the job thread writes them to the file in the order
+ *  they were received, between two reads from the SD.
+ *
+ * The writes, the signature digest and the sparse seeks are still
+ *  done by the job thread, so the data reaches the file exactly as
+ *  with the inline code.  Before anything else is done with the file
+ *  (end of the data stream, next file, ...) the pipeline is drained.
+ */
+
+#include "bacula.h"
+#include "filed.h"
+
+static const int dbglvl = 200;
+
+/* Records in flight per worker */
+#define RESTORE_CHUNKS_PER_THREAD 2
+
+struct RESTORE_PIPE;
+
+struct RESTORE_CHUNK {
+   RESTORE_PIPE *pipe;
+   BFILE *bfd;                        /* where to write */
+   uint64_t *addr;                    /* write address to update */
+   int flags;                         /* Options for extract_data() */
+   int32_t stream;
+   POOLMEM *in;                       /* record as received, after decryption */
+   uint32_t in_len;
+   POOLMEM *out;                      /* decompressed data */
+   int32_t out_size;                  /* size of out */
+   char *data;                        /* data to write */
+   uint32_t len;                      /* length to write */
+   bool ok;                           /* set if decompressed */
+   bool done;                         /* set by the worker */
+};
+
+struct RESTORE_PIPE {
+   JCR *jcr;
+   workq_t wq;
+   pthread_mutex_t mutex;
+   pthread_cond_t cond;               /* signaled when a chunk is done */
+   RESTORE_CHUNK *chunks;             /* ring of chunks */
+   int nr_chunks;
+   int head;                          /* next chunk to write */
+   int count;                         /* chunks in flight */
+   bool error;                        /* a write failed, discard the rest */
+};
+
+static void *restore_pipe_worker(void *arg)
+{
+   RESTORE_CHUNK *chunk = (RESTORE_CHUNK *)arg;
+   RESTORE_PIPE *pipe = chunk->pipe;
+   char *data = chunk->in;
+   uint32_t len = chunk->in_len;
+   bool ok = false;
+
+   /* The write address stays in front, it is used by the writer */
+   if (chunk->flags & (FO_SPARSE|FO_OFFSETS)) {
+      if (len >= OFFSET_FADDR_SIZE) {
+         data += OFFSET_FADDR_SIZE;
+         len -= OFFSET_FADDR_SIZE;
+         ok = true;
+      }
+   } else {
+      ok = true;
+   }
+   if (ok) {
+      ok = decompress_buffer(pipe->jcr, chunk->stream, &data, &len,
+                             &chunk->out, &chunk->out_size);
+   }
+
+   P(pipe->mutex);
+   chunk->data = data;
+   chunk->len = len;
+   chunk->ok = ok;
+   chunk->done = true;
+   pthread_cond_broadcast(&pipe->cond);
+   V(pipe->mutex);
+   return NULL;
+}
+
+/*
+ * Write the chunks in order, and wait until no more than keep
+ *  chunks are in flight.  Called by the job thread only.
+ */
+static bool restore_pipe_write(RESTORE_PIPE *pipe, int keep)
+{
+   JCR *jcr = pipe->jcr;
+   RESTORE_CHUNK *chunk;
+   char *p;
+   uint32_t l;
+
+   P(pipe->mutex);
+   while (pipe->count > 0) {
+      chunk = &pipe->chunks[pipe->head];
+      if (!chunk->done) {
+         if (pipe->count <= keep) {
+            break;
+         }
+         pthread_cond_wait(&pipe->cond, &pipe->mutex);
+         continue;
+      }
+      V(pipe->mutex);
+
+      if (!pipe->error) {
+         p = chunk->in;
+         l = chunk->in_len;
+         if (!chunk->ok) {
+            pipe->error = true;
+         } else if ((chunk->flags & (FO_SPARSE|FO_OFFSETS)) &&
+                    !sparse_data(jcr, chunk->bfd, chunk->addr, &p, &l)) {
+            pipe->error = true;
+         } else if (!store_data(jcr, chunk->bfd, chunk->data, chunk->len,
+                                (chunk->flags & FO_WIN32DECOMP) != 0)) {
+            pipe->error = true;
+         } else {
+            jcr->JobBytes += chunk->len;
+            *chunk->addr += chunk->len;
+         }
+      }
+
+      P(pipe->mutex);
+      chunk->done = false;
+      pipe->head = (pipe->head + 1) % pipe->nr_chunks;
+      pipe->count--;
+   }
+   V(pipe->mutex);
+   return !pipe->error;
+}
+
+/*
+ * Give a record to the workers, the data is copied.  On error,
+ *  the pipeline is drained before we return false.
+ */
+bool restore_pipe_submit(JCR *jcr, BFILE *bfd, uint64_t *addr, int flags,
+                         int32_t stream, char *data, uint32_t len)
+{
+   RESTORE_PIPE *pipe = jcr->rpipe;
+   RESTORE_CHUNK *chunk;
+   workq_ele_t *item;
+   int stat;
+
+   /* Make room, and write what is ready */
+   if (!restore_pipe_write(pipe, pipe->nr_chunks - 1)) {
+      return drain_restore_pipe(jcr);
+   }
+
+   P(pipe->mutex);
+   chunk = &pipe->chunks[(pipe->head + pipe->count) % pipe->nr_chunks];
+   pipe->count++;
+   V(pipe->mutex);
+
+   chunk->bfd = bfd;
+   chunk->addr = addr;
+   chunk->flags = flags;
+   chunk->stream = stream;
+   chunk->in = check_pool_memory_size(chunk->in, len);
+   memcpy(chunk->in, data, len);
+   chunk->in_len = len;
+   chunk->done = false;
+
+   if ((stat = workq_add(&pipe->wq, chunk, &item, 0)) != 0) {
+      berrno be;
+      Jmsg1(jcr, M_ERROR, 0, _("Could not add restore job to work queue: ERR=%s\n"),
+            be.bstrerror(stat));
+      restore_pipe_worker(chunk);     /* do it here */
+   }
+   Dmsg2(dbglvl, "Submitted chunk len=%u in flight=%d\n", len, pipe->count);
+   return true;
+}
+
+/*
+ * Write everything that is in flight.  Returns false if one of the
+ *  writes failed since the last drain.
+ */
+bool drain_restore_pipe(JCR *jcr)
+{
+   RESTORE_PIPE *pipe = jcr->rpipe;
+   bool ok;
+
+   if (!pipe) {
+      return true;
+   }
+   restore_pipe_write(pipe, 0);
+   ok = !pipe->error;
+   pipe->error = false;
+   return ok;
+}
+
+void init_restore_pipe(JCR *jcr, int nr_threads)
+{
+   RESTORE_PIPE *pipe;
+   int stat;
+
+   if (nr_threads <= 0 || !jcr->compress_buf) {   /* no compression support */
+      return;
+   }
+   pipe = (RESTORE_PIPE *)malloc(sizeof(RESTORE_PIPE));
+   memset(pipe, 0, sizeof(RESTORE_PIPE));
+   pipe->jcr = jcr;
+   if ((stat = workq_init(&pipe->wq, nr_threads, restore_pipe_worker)) != 0) {
+      berrno be;
+      Jmsg1(jcr, M_WARNING, 0, _("Could not start restore threads: ERR=%s\n"),
+            be.bstrerror(stat));
+      free(pipe);
+      return;
+   }
+   pthread_mutex_init(&pipe->mutex, NULL);
+   pthread_cond_init(&pipe->cond, NULL);
+   pipe->nr_chunks = nr_threads * RESTORE_CHUNKS_PER_THREAD;
+   pipe->chunks = (RESTORE_CHUNK *)malloc(pipe->nr_chunks * sizeof(RESTORE_CHUNK));
+   memset(pipe->chunks, 0, pipe->nr_chunks * sizeof(RESTORE_CHUNK));
+   for (int i=0; i < pipe->nr_chunks; i++) {
+      pipe->chunks[i].pipe = pipe;
+      pipe->chunks[i].in = get_pool_memory(PM_MESSAGE);
+      pipe->chunks[i].out_size = jcr->compress_buf_size;
+      pipe->chunks[i].out = get_memory(pipe->chunks[i].out_size);
+   }
+   jcr->rpipe = pipe;
+   Dmsg1(dbglvl, "Restore pipeline started with %d threads\n", nr_threads);
+}
+
+void free_restore_pipe(JCR *jcr)
+{
+   RESTORE_PIPE *pipe = jcr->rpipe;
+
+   if (!pipe) {
+      return;
+   }
+   drain_restore_pipe(jcr);
+   jcr->rpipe = NULL;
+   workq_destroy(&pipe->wq);
+   for (int i=0; i < pipe->nr_chunks; i++) {
+      free_pool_memory(pipe->chunks[i].in);
+      free_pool_memory(pipe->chunks[i].out);
+   }
+   free(pipe->chunks);
+   pthread_cond_destroy(&pipe->cond);
+   pthread_mutex_destroy(&pipe->mutex);
+   free(pipe);
+}
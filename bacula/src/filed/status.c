@@ -146,6 +146,12 @@ static void  list_status_header(STATUS_PKT *sp)
               edit_uint64(debug_level, b2), get_trace(), (int)DEVELOPER_MODE, (int)BEEF,
               edit_uint64_with_commas(me->max_bandwidth_per_job/1024, b1));
    sendit(msg.c_str(), len, sp);
+   if ((len = edit_message_delivery_status(msg.addr())) > 0) {
+      sendit(msg.c_str(), len, sp);
+   }
+   if ((len = edit_bw_sched_status(msg.addr())) > 0) {
+      sendit(msg.c_str(), len, sp);
+   }
    if (bplugin_list->size() > 0) {
       Plugin *plugin;
       int len;
@@ -78,6 +78,19 @@ static bxattr_exit_code send_xattr_stream(JCR *jcr, int stream)
       return bxattr_exit_ok;
    }
 
+   /*
+    * Send only a reference when the same xattrs were already sent
+    */
+   switch (send_metadata_ref(jcr, stream, jcr->xattr_data->u.build->content,
+                             jcr->xattr_data->u.build->content_length)) {
+   case -1:
+      return bxattr_exit_fatal;
+   case 1:
+      return bxattr_exit_ok;
+   default:
+      break;
+   }
+
    /*
     * Send header
     */
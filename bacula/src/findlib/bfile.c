@@ -213,6 +213,8 @@ const char *stream_to_ascii(int stream)
       return _("Encrypted Win32 Compressed data");
    case STREAM_ENCRYPTED_MACOS_FORK_DATA:
       return _("Encrypted MacOS fork data");
+   case STREAM_AEAD_DATA:
+      return _("AEAD encrypted data");
    case STREAM_PLUGIN_NAME:
       return _("Plugin Name");
    case STREAM_PLUGIN_DATA:
@@ -257,6 +259,10 @@ const char *stream_to_ascii(int stream)
       return _("GNU Hurd Specific Default ACL attribs");
    case STREAM_ACL_HURD_ACCESS_ACL:
       return _("GNU Hurd Specific Access ACL attribs");
+   case STREAM_ACL_REF:
+      return _("ACL attribs reference");
+   case STREAM_XATTR_REF:
+      return _("Extended attribs reference");
    case STREAM_XATTR_HURD:
       return _("GNU Hurd Specific Extended attribs");
    case STREAM_XATTR_IRIX:
@@ -546,6 +552,7 @@ bool is_restore_stream_supported(int stream)
    case STREAM_ENCRYPTED_FILE_GZIP_DATA:
    case STREAM_ENCRYPTED_WIN32_DATA:
    case STREAM_ENCRYPTED_WIN32_GZIP_DATA:
+   case STREAM_AEAD_DATA:
 #endif
 #ifdef HAVE_DARWIN_OS
    case STREAM_MACOS_FORK_DATA:
@@ -381,6 +381,192 @@ void encode_stat(char *buf, struct stat *statp, int stat_size, int32_t LinkFI, i
 #endif
 
 
+/*
+ * Compact stat packet
+ *
+ *  The legacy packet spends one character per 6 bits plus a space
+ *   per field, and the three times are each stored in full.  The
+ *   compact packet starts with "#1" (a legacy packet never starts
+ *   with '#') followed by one varint per field.  Each character of a
+ *   varint is a base64 digit holding 5 bits of the value, the 6th
+ *   bit tells that another character follows, so no separator is
+ *   needed.  atime and ctime are stored as a zigzag delta from mtime,
+ *   usually a single character.  Fields missing at the end of the
+ *   packet are zero, fields added by a later version are ignored.
+ *
+ *  The packet is still made of base64 digits, so it is sent in the
+ *   attribute records without any change.  The Director and bscan
+ *   turn it back into the legacy form before it goes into the LStat
+ *   column (see stat_compact_to_legacy()).  The FD produces it only
+ *   when the FileSet asks for it (CompactAttributes = yes), every
+ *   decode_stat() understands both formats.
+ */
+#define LSTAT_COMPACT_MARK    '#'
+#define LSTAT_COMPACT_VERSION '1'
+
+static const char compact_digits[64] = {
+  'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M',
+  'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z',
+  'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm',
+  'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z',
+  '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '+', '/'
+};
+
+/* Character to digit, 0xFF for anything that is not a digit (EOS) */
+static uint8_t compact_map[256];
+static bool compact_map_inited = false;
+
+static void init_compact_map()
+{
+   memset(compact_map, 0xFF, sizeof(compact_map));
+   for (int i=0; i < 64; i++) {
+      compact_map[(uint8_t)compact_digits[i]] = i;
+   }
+   compact_map_inited = true;
+}
+
+static inline char *put_varint(char *p, uint64_t val)
+{
+   while (val >= 32) {
+      *p++ = compact_digits[32 | (val & 31)];
+      val >>= 5;
+   }
+   *p++ = compact_digits[val];
+   return p;
+}
+
+/* A 64 bit value takes at most 13 digits of 5 bits, the last one has 4 */
+#define VARINT_MAX_SHIFT 60
+
+/*
+ * Returns false at the end of the packet, or for a value that does
+ *  not fit in 64 bits (damaged packet).
+ */
+static inline bool get_varint(uint8_t *&p, uint64_t *val)
+{
+   uint64_t v = 0;
+   int shift = 0;
+   uint8_t d;
+
+   if ((d = compact_map[*p]) == 0xFF) {
+      return false;
+   }
+   for ( ;; ) {
+      if (shift == VARINT_MAX_SHIFT && (d & ~15)) {
+         return false;                /* too long */
+      }
+      p++;
+      v |= (uint64_t)(d & 31) << shift;
+      if (!(d & 32) || (d = compact_map[*p]) == 0xFF) {
+         break;
+      }
+      shift += 5;
+   }
+   *val = v;
+   return true;
+}
+
+static inline uint64_t zigzag(int64_t val)
+{
+   return ((uint64_t)val << 1) ^ (uint64_t)(val >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t val)
+{
+   return (int64_t)(val >> 1) ^ -(int64_t)(val & 1);
+}
+
+/*
+ * Encode a stat structure into a compact packet, buf must be
+ *   as big as for encode_stat().
+ */
+void encode_stat_compact(char *buf, struct stat *statp, int stat_size,
+                         int32_t LinkFI, int data_stream)
+{
+   char *p = buf;
+   int64_t mtime = (int64_t)statp->st_mtime;
+
+   ASSERT(stat_size == (int)sizeof(struct stat));
+
+   *p++ = LSTAT_COMPACT_MARK;
+   *p++ = LSTAT_COMPACT_VERSION;
+   p = put_varint(p, (uint64_t)statp->st_mode);
+   p = put_varint(p, (uint64_t)statp->st_size);
+   p = put_varint(p, (uint64_t)mtime);
+   p = put_varint(p, zigzag((int64_t)statp->st_atime - mtime));
+   p = put_varint(p, zigzag((int64_t)statp->st_ctime - mtime));
+   p = put_varint(p, (uint64_t)statp->st_ino);
+   p = put_varint(p, (uint64_t)statp->st_dev);
+   p = put_varint(p, (uint64_t)statp->st_nlink);
+   p = put_varint(p, (uint64_t)statp->st_uid);
+   p = put_varint(p, (uint64_t)statp->st_gid);
+   p = put_varint(p, (uint64_t)statp->st_rdev);
+#ifndef HAVE_MINGW
+   p = put_varint(p, (uint64_t)statp->st_blksize);
+   p = put_varint(p, (uint64_t)statp->st_blocks);
+#else
+   p = put_varint(p, 0);              /* place holder */
+   p = put_varint(p, 0);              /* place holder */
+#endif
+   p = put_varint(p, (uint64_t)(uint32_t)LinkFI);
+#ifdef HAVE_CHFLAGS
+   p = put_varint(p, (uint64_t)statp->st_flags);
+#else
+   p = put_varint(p, 0);              /* place holder */
+#endif
+   p = put_varint(p, (uint64_t)data_stream);
+#ifdef HAVE_MINGW
+   p = put_varint(p, (uint64_t)statp->st_fattrs);
+#endif
+   *p = 0;
+}
+
+/* Compact packet fields, in order */
+enum {
+   CS_MODE, CS_SIZE, CS_MTIME, CS_ATIME, CS_CTIME, CS_INO, CS_DEV,
+   CS_NLINK, CS_UID, CS_GID, CS_RDEV, CS_BLKSIZE, CS_BLOCKS,
+   CS_LINKFI, CS_FLAGS, CS_STREAM, CS_FATTRS, CS_MAX
+};
+
+static int decode_stat_compact(char *buf, struct stat *statp, int32_t *LinkFI)
+{
+   uint64_t v[CS_MAX];
+   uint8_t *p = (uint8_t *)buf + 2;   /* skip mark and version */
+   int i;
+
+   if (!compact_map_inited) {
+      init_compact_map();
+   }
+   for (i=0; i < CS_MAX && get_varint(p, &v[i]); i++)
+      { }
+   for ( ; i < CS_MAX; i++) {
+      v[i] = 0;                       /* missing fields */
+   }
+   plug(statp->st_dev, v[CS_DEV]);
+   plug(statp->st_ino, v[CS_INO]);
+   plug(statp->st_mode, v[CS_MODE]);
+   plug(statp->st_nlink, v[CS_NLINK]);
+   plug(statp->st_uid, v[CS_UID]);
+   plug(statp->st_gid, v[CS_GID]);
+   plug(statp->st_rdev, v[CS_RDEV]);
+   plug(statp->st_size, v[CS_SIZE]);
+#ifndef HAVE_MINGW
+   plug(statp->st_blksize, v[CS_BLKSIZE]);
+   plug(statp->st_blocks, v[CS_BLOCKS]);
+#endif
+   plug(statp->st_mtime, v[CS_MTIME]);
+   plug(statp->st_atime, (int64_t)v[CS_MTIME] + unzigzag(v[CS_ATIME]));
+   plug(statp->st_ctime, (int64_t)v[CS_MTIME] + unzigzag(v[CS_CTIME]));
+   *LinkFI = (int32_t)v[CS_LINKFI];
+#ifdef HAVE_CHFLAGS
+   plug(statp->st_flags, v[CS_FLAGS]);
+#endif
+#ifdef HAVE_MINGW
+   plug(statp->st_fattrs, v[CS_FATTRS]);
+#endif
+   return (int)v[CS_STREAM];
+}
+
 /*
  * Decode a stat packet from base64 characters
  * returns: data_stream
@@ -398,6 +584,10 @@ int decode_stat(char *buf, struct stat *statp, int stat_size, int32_t *LinkFI)
     */
    ASSERT(stat_size == (int)sizeof(struct stat));
 
+   if (buf[0] == LSTAT_COMPACT_MARK) {
+      return decode_stat_compact(buf, statp, LinkFI);
+   }
+
    p += from_base64(&val, p);
    plug(statp->st_dev, val);
    p++;
@@ -500,6 +690,12 @@ int32_t decode_LinkFI(char *buf, struct stat *statp, int stat_size)
     */
    ASSERT(stat_size == (int)sizeof(struct stat));
 
+   if (buf[0] == LSTAT_COMPACT_MARK) {
+      int32_t LinkFI;
+      decode_stat_compact(buf, statp, &LinkFI);
+      return LinkFI;
+   }
+
    skip_nonspaces(&p);                /* st_dev */
    p++;                               /* skip space */
    skip_nonspaces(&p);                /* st_ino */
@@ -536,6 +732,27 @@ int32_t decode_LinkFI(char *buf, struct stat *statp, int stat_size)
    return 0;
 }
 
+/*
+ * The catalog keeps the legacy stat packet: the SQL functions
+ *  (base64_decode_lstat() used by BVFS and the queries) pick the
+ *  fields by position.  If attr is a compact packet, put its legacy
+ *  form in buf (at least MAXSTRING bytes) and return true.
+ */
+bool stat_compact_to_legacy(char *attr, char *buf)
+{
+   struct stat statp;
+   int32_t LinkFI;
+   int data_stream;
+
+   if (attr[0] != LSTAT_COMPACT_MARK) {
+      return false;
+   }
+   memset(&statp, 0, sizeof(statp));
+   data_stream = decode_stat_compact(attr, &statp, &LinkFI);
+   encode_stat(buf, &statp, sizeof(statp), LinkFI, data_stream);
+   return true;
+}
+
 /**
  * Set file modes, permissions and times
  *
@@ -665,3 +882,156 @@ int encode_attribsEx(JCR *jcr, char *attribsEx, FF_PKT *ff_pkt)
 }
 
 #endif
+
+#ifdef TEST_PROGRAM
+/*
+ * Check that both stat packet formats give back what was encoded,
+ *  then time them on the files of a directory (default /usr/include)
+ *
+ *   file_attrs_test [directory [loops]]
+ */
+static bool same_stat(struct stat *a, struct stat *b)
+{
+   return a->st_dev == b->st_dev && a->st_ino == b->st_ino &&
+      a->st_mode == b->st_mode && a->st_nlink == b->st_nlink &&
+      a->st_uid == b->st_uid && a->st_gid == b->st_gid &&
+      a->st_rdev == b->st_rdev && a->st_size == b->st_size &&
+      a->st_blksize == b->st_blksize && a->st_blocks == b->st_blocks &&
+      a->st_atime == b->st_atime && a->st_mtime == b->st_mtime &&
+      a->st_ctime == b->st_ctime;
+}
+
+/*
+ * What base64_decode_lstat(field, LStat) gives in SQL, e.g. field 8
+ *  is the size summed by the BVFS queries.
+ */
+static int64_t sql_lstat_field(char *lstat, int field)
+{
+   char *p = lstat;
+   int64_t val;
+
+   for (int i=1; i < field; i++) {
+      skip_nonspaces(&p);
+      p++;
+   }
+   from_base64(&val, p);
+   return val;
+}
+
+static int check_stat(struct stat *statp, int32_t LinkFI, int stream)
+{
+   char buf[500], lstat[MAXSTRING], legacy[500];
+   struct stat statn;
+   int32_t fi;
+   int errors = 0;
+
+   encode_stat_compact(buf, statp, sizeof(struct stat), LinkFI, stream);
+   memset(&statn, 0, sizeof(statn));
+   if (decode_stat(buf, &statn, sizeof(statn), &fi) != stream ||
+       fi != LinkFI || !same_stat(statp, &statn) ||
+       decode_LinkFI(buf, &statn, sizeof(statn)) != LinkFI) {
+      printf("compact mismatch: %s\n", buf);
+      errors++;
+   }
+   /* What the catalog stores for it, as read by BVFS */
+   encode_stat(legacy, statp, sizeof(struct stat), LinkFI, stream);
+   if (!stat_compact_to_legacy(buf, lstat) || strcmp(lstat, legacy) != 0 ||
+       sql_lstat_field(lstat, 8) != (int64_t)statp->st_size ||
+       stat_compact_to_legacy(legacy, lstat)) {
+      printf("catalog LStat mismatch: %s\n", buf);
+      errors++;
+   }
+   encode_stat(buf, statp, sizeof(struct stat), LinkFI, stream);
+   memset(&statn, 0, sizeof(statn));
+   if (decode_stat(buf, &statn, sizeof(statn), &fi) != stream ||
+       fi != LinkFI || !same_stat(statp, &statn)) {
+      printf("legacy mismatch: %s\n", buf);
+      errors++;
+   }
+   return errors;
+}
+
+int main(int argc, char *argv[])
+{
+   const char *dir = argc > 1 ? argv[1] : "/usr/include";
+   int loops = argc > 2 ? atoi(argv[2]) : 20;
+   alist files(1000, owned_by_alist);
+   struct stat statp, statn, *sp;
+   char buf[500], path[1024];
+   uint64_t llen = 0, clen = 0;
+   int32_t fi;
+   int errors = 0;
+   btime_t t0;
+   DIR *dp;
+   struct dirent *entry;
+
+   /* Edge cases */
+   memset(&statp, 0, sizeof(statp));
+   errors += check_stat(&statp, 0, 0);
+   statp.st_dev = 0xFD01;
+   statp.st_ino = (ino_t)0x7FFFFFFFFFFFLL;
+   statp.st_mode = S_IFREG | 0644;
+   statp.st_nlink = 3;
+   statp.st_uid = 65534;
+   statp.st_gid = 100;
+   statp.st_size = (off_t)0x7FFFFFFFFFFFFFFFLL;
+   statp.st_blksize = 4096;
+   statp.st_blocks = 123456789;
+   statp.st_mtime = 1400000000;
+   statp.st_atime = 1400000005;
+   statp.st_ctime = -1000;           /* before the Epoch */
+   errors += check_stat(&statp, 123456, 2);
+   errors += check_stat(&statp, 0, 26);
+
+   /* Real files */
+   if ((dp = opendir(dir)) == NULL) {
+      berrno be;
+      printf("Cannot open %s: ERR=%s\n", dir, be.bstrerror());
+      exit(1);
+   }
+   while ((entry = readdir(dp)) != NULL) {
+      bsnprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+      if (lstat(path, &statp) == 0) {
+         sp = (struct stat *)malloc(sizeof(struct stat));
+         memcpy(sp, &statp, sizeof(statp));
+         files.append(sp);
+         errors += check_stat(sp, 0, 1);
+         encode_stat(buf, sp, sizeof(statp), 0, 1);
+         llen += strlen(buf);
+         encode_stat_compact(buf, sp, sizeof(statp), 0, 1);
+         clen += strlen(buf);
+      }
+   }
+   closedir(dp);
+   if (files.size() == 0) {
+      printf("No files in %s\n", dir);
+      exit(1);
+   }
+   printf("%d files, average packet length legacy=%d compact=%d\n", files.size(),
+          (int)(llen / files.size()), (int)(clen / files.size()));
+
+   t0 = get_current_btime();
+   for (int i=0; i < loops; i++) {
+      foreach_alist(sp, &files) {
+         encode_stat(buf, sp, sizeof(statp), 0, 1);
+         decode_stat(buf, &statn, sizeof(statn), &fi);
+      }
+   }
+   printf("legacy:  %lld usec\n", (long long)(get_current_btime() - t0));
+   t0 = get_current_btime();
+   for (int i=0; i < loops; i++) {
+      foreach_alist(sp, &files) {
+         encode_stat_compact(buf, sp, sizeof(statp), 0, 1);
+         decode_stat(buf, &statn, sizeof(statn), &fi);
+      }
+   }
+   printf("compact: %lld usec\n", (long long)(get_current_btime() - t0));
+
+   if (errors) {
+      printf("%d errors\n", errors);
+      exit(1);
+   }
+   printf("OK\n");
+   return 0;
+}
+#endif /* TEST_PROGRAM */
@@ -100,6 +100,7 @@ struct findFOPTS {
    uint32_t Compress_algo;            /* compression algorithm. 4 letters stored as an interger */
    int Compress_level;                /* compression level */
    int strip_path;                    /* strip path count */
+   bool dedup_metadata;               /* send identical ACLs/xattrs once */
    char VerifyOpts[MAX_FOPTS];        /* verify options */
    char AccurateOpts[MAX_FOPTS];      /* accurate mode options */
    char BaseJobOpts[MAX_FOPTS];       /* basejob mode options */
@@ -188,6 +189,7 @@ struct FF_PKT {
    int (*file_save)(JCR *, FF_PKT *, bool); /* User's callback */
    int (*plugin_save)(JCR *, FF_PKT *, bool); /* User's callback */
    bool (*check_fct)(JCR *, FF_PKT *); /* optionnal user fct to check file changes */
+   bool skip_dir_files;               /* set on FT_DIRBEGIN: do not stat the non-directory entries */
 
    /* Values set by accept_file while processing Options */
    uint32_t flags;                    /* backup options */
@@ -564,6 +564,7 @@ find_one_file(JCR *jcr, FF_PKT *ff_pkt,
       int status;
       dev_t our_device = ff_pkt->statp.st_dev;
       bool recurse = true;
+      bool skip_files = false;           /* set by handle_file() on FT_DIRBEGIN */
       bool volhas_attrlist = ff_pkt->volhas_attrlist;    /* Remember this if we recurse */
 
       /*
@@ -604,7 +605,10 @@ find_one_file(JCR *jcr, FF_PKT *ff_pkt,
        * do not immediately save it, but do so only after everything
        * in the directory is seen (i.e. the FT_DIREND).
        */
+      ff_pkt->skip_dir_files = false;
       rtn_stat = handle_file(jcr, ff_pkt, top_level);
+      skip_files = ff_pkt->skip_dir_files;
+      ff_pkt->skip_dir_files = false;
       if (rtn_stat < 1 || ff_pkt->type == FT_REPARSE ||
           ff_pkt->type == FT_JUNCTION) {   /* ignore or error status */
          free(link);
@@ -706,6 +710,12 @@ find_one_file(JCR *jcr, FF_PKT *ff_pkt,
              (p[1] == '.' && p[2] == '\0')))) {
             continue;
          }
+#ifdef _DIRENT_HAVE_D_TYPE
+         /* The caller knows this directory, only look for subdirectories */
+         if (skip_files && entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN) {
+            continue;
+         }
+#endif
 
          if ((int)NAMELEN(entry) + len >= link_len) {
              link_len = len + NAMELEN(entry) + 1;
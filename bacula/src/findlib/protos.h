@@ -20,8 +20,10 @@
 
 /* from attribs.c */
 void    encode_stat       (char *buf, struct stat *statp, int stat_size, int32_t LinkFI, int data_stream);
+void    encode_stat_compact(char *buf, struct stat *statp, int stat_size, int32_t LinkFI, int data_stream);
 int     decode_stat       (char *buf, struct stat *statp, int stat_size, int32_t *LinkFI);
 int32_t decode_LinkFI     (char *buf, struct stat *statp, int stat_size);
+bool    stat_compact_to_legacy(char *attr, char *buf);
 int     encode_attribsEx  (JCR *jcr, char *attribsEx, FF_PKT *ff_pkt);
 bool    set_attributes    (JCR *jcr, ATTR *attr, BFILE *ofd);
 int     select_data_stream(FF_PKT *ff_pkt);
@@ -156,6 +156,8 @@ struct CRYPTO_CTX {
    POOLMEM *pki_session_encoded;      /* Cached DER-encoded copy of pki_session */
    int32_t pki_session_encoded_size;  /* Size of DER-encoded pki_session */
    POOLMEM *crypto_buf;               /* Encryption/Decryption buffer */
+   CIPHER_CONTEXT *pki_aead;          /* Record cipher if the PKI Cipher is an AEAD one */
+   uint32_t aead_files;               /* Number of streams sealed with pki_aead */
 };
 #endif
 
@@ -212,6 +214,7 @@ public:
    dlist *msg_queue;                  /* Queued messages */
    pthread_mutex_t msg_queue_mutex;   /* message queue mutex */
    bool dequeuing_msgs;               /* Set when dequeuing messages */
+   int32_t msg_pending;               /* Messages waiting for async delivery */
    alist job_end_push;                /* Job end pushed calls */
    POOLMEM *VolumeName;               /* Volume name desired -- pool_memory */
    POOLMEM *errmsg;                   /* edited error message */
@@ -348,6 +351,7 @@ public:
    int32_t FDVersion;                 /* File daemon version number */
    int32_t SDVersion;                 /* Storage daemon version number */
    int64_t spool_size;                /* Spool size for this job */
+   utime_t est_run_time;              /* Run time estimated from previous Jobs */
    volatile bool sd_msg_thread_done;  /* Set when Storage message thread done */
    bool SD_msg_chan_started;          /* Set if message thread started */
    bool wasVirtualFull;               /* set if job was VirtualFull */
@@ -375,6 +379,7 @@ public:
    bool RescheduleIncompleteJobs;     /* set if incomplete can be rescheduled */
    bool use_all_JobIds;               /* Use all jobids present in command line */
    bool sd_client;                    /* This job runs as SD client */
+   bool backfilled;                   /* Started ahead of higher priority Jobs */
 #endif /* DIRECTOR_DAEMON */
 
 
@@ -386,12 +391,18 @@ public:
    pthread_cond_t job_start_wait;     /* Wait for SD to start Job */
    acl_data_t *acl_data;              /* ACLs for backup/restore */
    xattr_data_t *xattr_data;          /* Extended Attributes for backup/restore */
+   struct META_DICT *meta_dict;       /* ACL/xattr dictionary for backup/restore */
+   struct RESTORE_PIPE *rpipe;        /* decompression threads for restore */
+   struct DIGEST_PIPE *dpipe;         /* digest threads for backup */
    int32_t last_type;                 /* type of last file saved/verified */
    int incremental;                   /* set if incremental for SINCE */
    time_t last_stat_time;             /* Last time stats sent to Dir */
    time_t stat_interval;              /* Stats send interval */
    utime_t mtime;                     /* begin time for SINCE */
    int listing;                       /* job listing in estimate */
+   int fast_estimate;                 /* estimate from the walk cache */
+   uint64_t fileset_hash;             /* identifies the FileSet for the walk cache */
+   struct WALK_CACHE *walk_cache;     /* directory totals for estimate */
    long Ticket;                       /* Ticket */
    char *big_buf;                     /* I/O buffer */
    POOLMEM *compress_buf;             /* Compression buffer */
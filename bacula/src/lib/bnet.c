@@ -106,6 +106,9 @@ int32_t read_nbytes(BSOCK * bsock, char *ptr, int32_t nbytes)
       if (bsock->use_bwlimit()) {
          bsock->control_bwlimit(nread);
       }
+      if (bsock->get_bwclass()) {
+         bw_sched_account(bsock->get_bwclass(), nread);
+      }
    }
    return nbytes - nleft;          /* return >= 0 */
 }
@@ -134,8 +137,8 @@ int32_t write_nbytes(BSOCK * bsock, char *ptr, int32_t nbytes)
    }
 
 #ifdef HAVE_TLS
-   if (bsock->tls) {
-      /* TLS enabled */
+   if (bsock->tls && !tls_bsock_kernel_send(bsock)) {
+      /* TLS enabled, and not done by the kernel */
       return (tls_bsock_writen(bsock, ptr, nbytes));
    }
 #endif /* HAVE_TLS */
@@ -192,6 +195,9 @@ int32_t write_nbytes(BSOCK * bsock, char *ptr, int32_t nbytes)
       if (bsock->use_bwlimit()) {
          bsock->control_bwlimit(nwritten);
       }
+      if (bsock->get_bwclass()) {
+         bw_sched_account(bsock->get_bwclass(), nwritten);
+      }
    }
    return nbytes - nleft;
 }
@@ -38,6 +38,15 @@ class BSOCK;
 btimer_t *start_bsock_timer(BSOCK *bs, uint32_t wait);
 void stop_bsock_timer(btimer_t *wid);
 
+/* Classes of the daemon wide bandwidth scheduler, see bwsched.c */
+enum {
+   BW_CLASS_NONE = 0,                 /* not scheduled */
+   BW_CLASS_BACKUP,
+   BW_CLASS_RESTORE,
+   BW_CLASS_COPY,
+   BW_NR_CLASSES
+};
+
 
 class BSOCK {
 /*
@@ -88,6 +97,7 @@ private:
    int64_t m_bwlimit;                 /* set to limit bandwidth */
    int64_t m_nb_bytes;                /* bytes sent/recv since the last tick */
    btime_t m_last_tick;               /* last tick used by bwlimit */
+   int m_bwclass;                     /* BW_CLASS_xxx for the scheduler */
 
    void fin_init(JCR * jcr, int sockfd, const char *who, const char *host, int port,
                struct sockaddr *lclient_addr);
@@ -155,6 +165,8 @@ public:
    int32_t get_lastFileIndex() { return m_lastFileIndex; };
    void set_bwlimit(int64_t maxspeed) { m_bwlimit = maxspeed; };
    bool use_bwlimit() { return m_bwlimit > 0;};
+   void set_bwclass(int bwclass) { m_bwclass = bwclass; };
+   int get_bwclass() { return m_bwclass; };
    void set_spooling() { m_spool = true; };
    void clear_spooling() { m_spool = false; };
    void set_duped() { m_duped = true; };
@@ -0,0 +1,219 @@
+/*
+   Bacula® - The Network Backup Solution
+
+   Copyright (C) 2014-2014 Free Software Foundation Europe e.V.
+
+   The main author of Bacula is Kern Sibbald, with contributions from many
+   others, a complete list can be found in the file AUTHORS.
+
+   You may use this file and others of this release according to the
+   license defined in the LICENSE file, which includes the Affero General
+   Public License, v3.0 ("AGPLv3") and some additional permissions and
+   terms pursuant to its AGPLv3 Section 7.
+
+   Bacula® is a registered trademark of Kern Sibbald.
+*/
+/*
+ * Daemon wide bandwidth scheduler.
+ *
+ * BSOCK::control_bwlimit() limits one connection.  Here, all the
+ *  data connections of the daemon share one rate, set with the
+ *  "Maximum Bandwidth" directive.  Each connection belongs to a class
+ *  (Backup, Restore, Copy) and each class has a weight.  In the SD,
+ *  the connection between the reading and the writing SD of a Copy
+ *  or Migration Job is in the Copy class on both sides.  The rate is
+ *  split between the classes that had traffic in the last second, in
+ *  proportion to their weight, so a restore can get most of the link
+ *  while backups are running, and gets all of it when they are done.
+ *
+ * Each class has a token bucket.  A connection takes its bytes from
+ *  the bucket of its class after each read or write, going in debt if
+ *  needed, and then waits in small steps until the debt is paid.  The
+ *  bucket holds at most BW_BURST_USEC worth of data, so the pacing
+ *  stays smooth.
+ */
+
+#include "bacula.h"
+#include "jcr.h"
+
+static const int dbglvl = 400;
+
+/* A class without traffic for this time does not get a share */
+#define BW_ACTIVE_USEC  1000000
+
+/* Tokens kept at most by a class */
+#define BW_BURST_USEC   50000
+
+/* Longest sleep before we look again at the bucket */
+#define BW_MAX_SLEEP    20000
+
+struct BW_CLASS {
+   const char *name;
+   uint32_t weight;                   /* share of the rate, 0 = no limit */
+   double tokens;                     /* bytes that can be sent, may be < 0 */
+   btime_t last_use;                  /* last traffic in this class */
+   uint64_t bytes;                    /* bytes seen */
+   uint64_t waits;                    /* times we had to wait */
+};
+
+static pthread_mutex_t bw_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int64_t bw_rate = 0;           /* bytes/s for the daemon, 0 = off */
+static btime_t bw_last_tick = 0;
+static BW_CLASS bw_classes[BW_NR_CLASSES] = {
+   { "None",    0, 0, 0, 0, 0 },
+   { "Backup",  2, 0, 0, 0, 0 },
+   { "Restore", 4, 0, 0, 0, 0 },
+   { "Copy",    1, 0, 0, 0, 0 }
+};
+
+void bw_sched_init(int64_t rate)
+{
+   P(bw_mutex);
+   bw_rate = rate;
+   bw_last_tick = get_current_btime();
+   V(bw_mutex);
+   Dmsg1(dbglvl, "Bandwidth scheduler rate=%lld\n", rate);
+}
+
+void bw_sched_set_weight(int bwclass, uint32_t weight)
+{
+   if (bwclass <= BW_CLASS_NONE || bwclass >= BW_NR_CLASSES) {
+      return;
+   }
+   P(bw_mutex);
+   bw_classes[bwclass].weight = weight;
+   V(bw_mutex);
+}
+
+/* Class of the data connection of a Job */
+int bw_class_of_job(int JobType)
+{
+   switch (JobType) {
+   case JT_BACKUP:
+      return BW_CLASS_BACKUP;
+   case JT_RESTORE:
+      return BW_CLASS_RESTORE;
+   case JT_COPY:
+   case JT_MIGRATE:
+      return BW_CLASS_COPY;
+   default:
+      return BW_CLASS_NONE;
+   }
+}
+
+static bool is_active(BW_CLASS *c, btime_t now)
+{
+   return c->weight > 0 && c->last_use > 0 && now - c->last_use < BW_ACTIVE_USEC;
+}
+
+/* Rate given to a class, in bytes per microsecond.  Needs bw_mutex */
+static double class_rate(BW_CLASS *c, btime_t now)
+{
+   uint32_t total = 0;
+
+   for (int i=BW_CLASS_NONE+1; i < BW_NR_CLASSES; i++) {
+      if (is_active(&bw_classes[i], now)) {
+         total += bw_classes[i].weight;
+      }
+   }
+   if (total == 0) {
+      return 0;
+   }
+   return (double)bw_rate * c->weight / total / 1000000.0;
+}
+
+/* Give each active class its share of the elapsed time.  Needs bw_mutex */
+static void refill(btime_t now)
+{
+   btime_t elapsed = now - bw_last_tick;
+
+   if (elapsed <= 0) {
+      return;
+   }
+   if (elapsed > 10 * BW_ACTIVE_USEC) {   /* Take care of clock problems */
+      elapsed = BW_BURST_USEC;
+   }
+   bw_last_tick = now;
+   for (int i=BW_CLASS_NONE+1; i < BW_NR_CLASSES; i++) {
+      BW_CLASS *c = &bw_classes[i];
+      if (!is_active(c, now)) {
+         continue;
+      }
+      double rate = class_rate(c, now);
+      c->tokens += rate * elapsed;
+      if (c->tokens > rate * BW_BURST_USEC) {
+         c->tokens = rate * BW_BURST_USEC;
+      }
+   }
+}
+
+/*
+ * Called after bytes were read or written on a connection of the
+ *  class, waits until the class is back under its rate.
+ */
+void bw_sched_account(int bwclass, int bytes)
+{
+   BW_CLASS *c;
+   btime_t now;
+   int64_t usec;
+   double rate;
+
+   if (bytes <= 0 || bwclass <= BW_CLASS_NONE || bwclass >= BW_NR_CLASSES) {
+      return;
+   }
+   c = &bw_classes[bwclass];
+   P(bw_mutex);
+   if (bw_rate <= 0 || c->weight == 0) {
+      V(bw_mutex);
+      return;
+   }
+   now = get_current_btime();
+   c->last_use = now;
+   refill(now);
+   c->tokens -= bytes;
+   c->bytes += bytes;
+   if (c->tokens < 0) {
+      c->waits++;
+   }
+   while (c->tokens < 0) {
+      rate = class_rate(c, now);
+      usec = rate > 0 ? (int64_t)(-c->tokens / rate) : BW_MAX_SLEEP;
+      usec = MAX(100, MIN(usec, BW_MAX_SLEEP));
+      V(bw_mutex);
+      bmicrosleep(0, usec);
+      P(bw_mutex);
+      now = get_current_btime();
+      c->last_use = now;
+      refill(now);
+      if (bw_rate <= 0) {
+         break;
+      }
+   }
+   V(bw_mutex);
+}
+
+/* For the status commands */
+int edit_bw_sched_status(POOLMEM *&buf)
+{
+   POOL_MEM tmp;
+   char b1[50], b2[50];
+   int len;
+
+   *buf = 0;
+   P(bw_mutex);
+   if (bw_rate <= 0) {
+      V(bw_mutex);
+      return 0;
+   }
+   len = Mmsg(buf, _(" Bandwidth: rate=%skB/s"), edit_uint64_with_commas(bw_rate/1024, b1));
+   for (int i=BW_CLASS_NONE+1; i < BW_NR_CLASSES; i++) {
+      BW_CLASS *c = &bw_classes[i];
+      Mmsg(tmp, " %s=%u:%sMB:%s", c->name, c->weight,
+           edit_uint64_with_commas(c->bytes/(1024*1024), b1),
+           edit_uint64_with_commas(c->waits, b2));
+      len = pm_strcat(buf, tmp.c_str());
+   }
+   len = pm_strcat(buf, "\n");
+   V(bw_mutex);
+   return len;
+}
@@ -289,6 +289,9 @@ struct Crypto_Session {
 /* Symmetric Cipher Context */
 struct Cipher_Context {
    EVP_CIPHER_CTX ctx;
+   bool aead;                                     /* Authenticated cipher, see crypto_cipher_seal() */
+   int iv_len;                                    /* Length of iv */
+   unsigned char iv[EVP_MAX_IV_LENGTH];           /* Session IV, the record nonces are mixed in */
 };
 
 /* PEM Password Dispatch Context */
@@ -1027,6 +1030,27 @@ CRYPTO_SESSION *crypto_session_new (crypto_cipher_t cipher, alist *pubkeys)
       cs->cryptoData->contentEncryptionAlgorithm = OBJ_nid2obj(NID_bf_cbc);
       ec = EVP_bf_cbc();
       break;
+#ifdef NID_aes_128_gcm
+   case CRYPTO_CIPHER_AES_128_GCM:
+      /* AES 128 bit GCM */
+      cs->cryptoData->contentEncryptionAlgorithm = OBJ_nid2obj(NID_aes_128_gcm);
+      ec = EVP_aes_128_gcm();
+      break;
+#ifndef HAVE_OPENSSL_EXPORT_LIBRARY
+   case CRYPTO_CIPHER_AES_256_GCM:
+      /* AES 256 bit GCM */
+      cs->cryptoData->contentEncryptionAlgorithm = OBJ_nid2obj(NID_aes_256_gcm);
+      ec = EVP_aes_256_gcm();
+      break;
+#endif
+#endif
+#ifdef NID_chacha20_poly1305
+   case CRYPTO_CIPHER_CHACHA20_POLY1305:
+      /* ChaCha20 with Poly1305 authenticator */
+      cs->cryptoData->contentEncryptionAlgorithm = OBJ_nid2obj(NID_chacha20_poly1305);
+      ec = EVP_chacha20_poly1305();
+      break;
+#endif
    default:
       Jmsg0(NULL, M_ERROR, 0, _("Unsupported cipher type specified\n"));
       crypto_session_free(cs);
@@ -1311,6 +1335,20 @@ CIPHER_CONTEXT *crypto_cipher_new(CRYPTO_SESSION *cs, bool encrypt, uint32_t *bl
       goto err;
    }
 
+   /* Keep the IV, AEAD ciphers derive a nonce for each record from it */
+   cipher_ctx->aead = false;
+   cipher_ctx->iv_len = M_ASN1_STRING_length(cs->cryptoData->iv);
+   memcpy(cipher_ctx->iv, M_ASN1_STRING_data(cs->cryptoData->iv), cipher_ctx->iv_len);
+#ifdef EVP_CIPH_FLAG_AEAD_CIPHER
+   if (EVP_CIPHER_flags(ec) & EVP_CIPH_FLAG_AEAD_CIPHER) {
+      if (cipher_ctx->iv_len < (int)sizeof(uint64_t)) {
+         Jmsg0(NULL, M_ERROR, 0, _("Encryption session provided a too short IV\n"));
+         goto err;
+      }
+      cipher_ctx->aead = true;
+   }
+#endif
+
    *blocksize = EVP_CIPHER_CTX_block_size(&cipher_ctx->ctx);
    return cipher_ctx;
 
@@ -1354,6 +1392,119 @@ bool crypto_cipher_finalize (CIPHER_CONTEXT *cipher_ctx, uint8_t *dest, uint32_t
 }
 
 
+/*
+ * Returns true if the cipher context must be used with
+ *  crypto_cipher_seal() and crypto_cipher_open().
+ */
+bool crypto_cipher_is_aead(CIPHER_CONTEXT *cipher_ctx)
+{
+   return cipher_ctx->aead;
+}
+
+#ifdef EVP_CIPH_FLAG_AEAD_CIPHER
+/*
+ * Reset the context for a new record.  The nonce is XORed into the
+ *  last 8 bytes of the session IV, so it must never be used twice
+ *  with the same session.
+ */
+static bool cipher_start_record(CIPHER_CONTEXT *cipher_ctx, uint64_t nonce,
+                                const uint8_t *aad, uint32_t aad_len)
+{
+   unsigned char iv[EVP_MAX_IV_LENGTH];
+   int len;
+
+   memcpy(iv, cipher_ctx->iv, cipher_ctx->iv_len);
+   for (int i = 0; i < (int)sizeof(uint64_t); i++) {
+      iv[cipher_ctx->iv_len - 1 - i] ^= (unsigned char)(nonce >> (8 * i));
+   }
+   if (!EVP_CipherInit_ex(&cipher_ctx->ctx, NULL, NULL, NULL, iv, -1)) {
+      return false;
+   }
+   /* Additional data, authenticated but not encrypted */
+   if (aad_len > 0 &&
+       !EVP_CipherUpdate(&cipher_ctx->ctx, NULL, &len, (const unsigned char *)aad, aad_len)) {
+      return false;
+   }
+   return true;
+}
+
+/*
+ * Encrypt one record with an AEAD cipher.  The records are independent
+ *  of each other, so they can be processed in any order or by several
+ *  contexts of the same session.  dest must have room for length +
+ *  CRYPTO_CIPHER_TAG_SIZE bytes, the tag is written after the data.
+ *
+ * Returns: true on success, number of bytes output in written
+ *          false on failure
+ */
+bool crypto_cipher_seal(CIPHER_CONTEXT *cipher_ctx, uint64_t nonce,
+                        const uint8_t *aad, uint32_t aad_len,
+                        const uint8_t *data, uint32_t length,
+                        uint8_t *dest, uint32_t *written)
+{
+   int len, flen;
+
+   if (!cipher_ctx->aead || !cipher_start_record(cipher_ctx, nonce, aad, aad_len)) {
+      return false;
+   }
+   if (!EVP_CipherUpdate(&cipher_ctx->ctx, (unsigned char *)dest, &len,
+                         (const unsigned char *)data, length)) {
+      return false;
+   }
+   if (!EVP_CipherFinal_ex(&cipher_ctx->ctx, (unsigned char *)dest + len, &flen)) {
+      return false;
+   }
+   len += flen;
+   if (!EVP_CIPHER_CTX_ctrl(&cipher_ctx->ctx, EVP_CTRL_GCM_GET_TAG,
+                            CRYPTO_CIPHER_TAG_SIZE, dest + len)) {
+      return false;
+   }
+   *written = len + CRYPTO_CIPHER_TAG_SIZE;
+   return true;
+}
+
+/*
+ * Decrypt and authenticate one record sealed by crypto_cipher_seal()
+ *  with the same nonce and additional data.
+ *
+ * Returns: true on success, number of bytes output in written
+ *          false on failure, or if the record was modified
+ */
+bool crypto_cipher_open(CIPHER_CONTEXT *cipher_ctx, uint64_t nonce,
+                        const uint8_t *aad, uint32_t aad_len,
+                        const uint8_t *data, uint32_t length,
+                        uint8_t *dest, uint32_t *written)
+{
+   int len, flen;
+
+   if (!cipher_ctx->aead || length < CRYPTO_CIPHER_TAG_SIZE ||
+       !cipher_start_record(cipher_ctx, nonce, aad, aad_len)) {
+      return false;
+   }
+   length -= CRYPTO_CIPHER_TAG_SIZE;
+   if (!EVP_CIPHER_CTX_ctrl(&cipher_ctx->ctx, EVP_CTRL_GCM_SET_TAG,
+                            CRYPTO_CIPHER_TAG_SIZE, (void *)(data + length))) {
+      return false;
+   }
+   if (!EVP_CipherUpdate(&cipher_ctx->ctx, (unsigned char *)dest, &len,
+                         (const unsigned char *)data, length)) {
+      return false;
+   }
+   /* Fails if the tag does not match */
+   if (!EVP_CipherFinal_ex(&cipher_ctx->ctx, (unsigned char *)dest + len, &flen)) {
+      return false;
+   }
+   *written = len + flen;
+   return true;
+}
+
+#else /* EVP_CIPH_FLAG_AEAD_CIPHER */
+
+bool crypto_cipher_seal(CIPHER_CONTEXT *cipher_ctx, uint64_t nonce, const uint8_t *aad, uint32_t aad_len, const uint8_t *data, uint32_t length, uint8_t *dest, uint32_t *written) { return false; }
+bool crypto_cipher_open(CIPHER_CONTEXT *cipher_ctx, uint64_t nonce, const uint8_t *aad, uint32_t aad_len, const uint8_t *data, uint32_t length, uint8_t *dest, uint32_t *written) { return false; }
+
+#endif /* EVP_CIPH_FLAG_AEAD_CIPHER */
+
 /*
  * Free memory associated with a cipher context.
  */
@@ -1575,6 +1726,9 @@ CIPHER_CONTEXT *crypto_cipher_new (CRYPTO_SESSION *cs, bool encrypt, uint32_t *b
 bool crypto_cipher_update (CIPHER_CONTEXT *cipher_ctx, const uint8_t *data, uint32_t length, const uint8_t *dest, uint32_t *written) { return false; }
 bool crypto_cipher_finalize (CIPHER_CONTEXT *cipher_ctx, uint8_t *dest, uint32_t *written) { return false; }
 void crypto_cipher_free (CIPHER_CONTEXT *cipher_ctx) { }
+bool crypto_cipher_is_aead (CIPHER_CONTEXT *cipher_ctx) { return false; }
+bool crypto_cipher_seal (CIPHER_CONTEXT *cipher_ctx, uint64_t nonce, const uint8_t *aad, uint32_t aad_len, const uint8_t *data, uint32_t length, uint8_t *dest, uint32_t *written) { return false; }
+bool crypto_cipher_open (CIPHER_CONTEXT *cipher_ctx, uint64_t nonce, const uint8_t *aad, uint32_t aad_len, const uint8_t *data, uint32_t length, uint8_t *dest, uint32_t *written) { return false; }
 
 #endif /* HAVE_CRYPTO */
 
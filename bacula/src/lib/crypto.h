@@ -77,7 +77,10 @@ typedef enum {
    CRYPTO_CIPHER_AES_128_CBC,   /* Keep AES128 as the first one */
    CRYPTO_CIPHER_AES_192_CBC,
    CRYPTO_CIPHER_AES_256_CBC,
-   CRYPTO_CIPHER_BLOWFISH_CBC
+   CRYPTO_CIPHER_BLOWFISH_CBC,
+   CRYPTO_CIPHER_AES_128_GCM,   /* AEAD ciphers, each record is sealed alone */
+   CRYPTO_CIPHER_AES_256_GCM,
+   CRYPTO_CIPHER_CHACHA20_POLY1305
 } crypto_cipher_t;
 
 /* Crypto API Errors */
@@ -98,6 +101,9 @@ typedef enum {
 #define CRYPTO_DIGEST_SHA256_SIZE 32  /* 256 bits */
 #define CRYPTO_DIGEST_SHA512_SIZE 64  /* 512 bits */
 
+/* Authentication tag appended by crypto_cipher_seal() */
+#define CRYPTO_CIPHER_TAG_SIZE 16     /* 128 bits */
+
 /* Maximum Message Digest Size */
 #ifdef HAVE_OPENSSL
 
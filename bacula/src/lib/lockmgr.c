@@ -163,6 +163,8 @@ typedef enum {
 /*
  * Object associated with each mutex per thread
  */
+struct lmgr_site_t;
+
 class lmgr_lock_t: public SMARTALLOC
 {
 public:
@@ -175,10 +177,16 @@ public:
    const char *file;
    int line;
 
+   lmgr_site_t *site;           /* Contention statistics of file:line */
+   btime_t wanted;              /* When the lock was requested */
+   btime_t granted;             /* When it was granted, 0 if unknown */
+
    lmgr_lock_t() {
       lock = NULL;
       state = LMGR_LOCK_EMPTY;
       priority = max_priority = 0;
+      site = NULL;
+      wanted = granted = 0;
    }
 
    lmgr_lock_t(void *l) {
@@ -271,6 +279,96 @@ typedef struct
 
 static int32_t global_event_id=0;
 
+/*
+ * Contention statistics, one entry per place where a lock is taken
+ *  (the file:line given to P() or to rwl_writelock()).  The entries
+ *  are never freed, they are updated with atomic operations, and are
+ *  shown by "status storage" and dumped on SIGUSR1.
+ */
+#define LMGR_MAX_SITES      1024      /* must be a power of 2 */
+#define LMGR_SITE_PROBES    16
+#define LMGR_WAIT_BUCKETS   16        /* < 1us, < 2us, ... , >= 16ms */
+#define LMGR_CONTENDED_USEC 2         /* shorter waits are not counted */
+
+struct lmgr_site_t {
+   const char * volatile file;  /* NULL while the entry is free */
+   int line;
+   uint64_t count;              /* Times the lock was granted */
+   uint64_t contended;          /* Times we had to wait for it */
+   uint64_t wait_total;         /* Microseconds */
+   uint64_t wait_max;
+   uint64_t hold_total;
+   uint64_t hold_max;
+   uint64_t wait_hist[LMGR_WAIT_BUCKETS];
+};
+
+static lmgr_site_t lmgr_sites[LMGR_MAX_SITES];
+static pthread_mutex_t lmgr_site_mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile bool lmgr_stats_requested = false;
+
+/* Find or add the entry of file:line, NULL if the table is full */
+static lmgr_site_t *lmgr_get_site(const char *file, int line)
+{
+   uint32_t h = (uint32_t)(((uint64_t)(intptr_t)file >> 3) * 31 + line);
+   lmgr_site_t *s;
+
+   for (int i=0; i < LMGR_SITE_PROBES; i++) {
+      s = &lmgr_sites[(h + i) & (LMGR_MAX_SITES - 1)];
+      if (s->file == NULL) {
+         lmgr_p(&lmgr_site_mutex);
+         if (s->file == NULL) {
+            s->line = line;
+            __sync_synchronize();
+            s->file = file;
+         }
+         lmgr_v(&lmgr_site_mutex);
+      }
+      if (s->file == file && s->line == line) {
+         return s;
+      }
+   }
+   return NULL;
+}
+
+static void lmgr_update_max(uint64_t *max, uint64_t val)
+{
+   uint64_t old = *max;
+   while (val > old) {
+      if (__sync_bool_compare_and_swap(max, old, val)) {
+         break;
+      }
+      old = *max;
+   }
+}
+
+static void lmgr_site_granted(lmgr_site_t *s, btime_t wait)
+{
+   int bucket = 0;
+
+   if (wait < 0) {
+      wait = 0;
+   }
+   __sync_fetch_and_add(&s->count, 1);
+   if (wait >= LMGR_CONTENDED_USEC) {
+      __sync_fetch_and_add(&s->contended, 1);
+      __sync_fetch_and_add(&s->wait_total, (uint64_t)wait);
+      lmgr_update_max(&s->wait_max, wait);
+   }
+   while (bucket < LMGR_WAIT_BUCKETS - 1 && wait >= ((btime_t)1 << bucket)) {
+      bucket++;
+   }
+   __sync_fetch_and_add(&s->wait_hist[bucket], 1);
+}
+
+static void lmgr_site_released(lmgr_site_t *s, btime_t hold)
+{
+   if (hold < 0) {
+      hold = 0;
+   }
+   __sync_fetch_and_add(&s->hold_total, (uint64_t)hold);
+   lmgr_update_max(&s->hold_max, hold);
+}
+
 /* Keep this number of event per thread */
 #ifdef _TEST_IT
 # define LMGR_THREAD_EVENT_MAX  15
@@ -422,6 +520,8 @@ public:
                       const char *f="*unknown*", int l=0)
    {
       int max_prio = max_priority;
+      lmgr_site_t *site = lmgr_get_site(f, l);
+      btime_t now = get_current_btime();
 
       if (chk_dbglvl(DBGLEVEL_EVENT) || debug_flags & DEBUG_MUTEX_EVENT) {
          /* Keep track of this event */
@@ -441,6 +541,9 @@ public:
          lock_list[current].line = l;
          lock_list[current].priority = priority;
          lock_list[current].max_priority = MAX(priority, max_priority);
+         lock_list[current].site = site;
+         lock_list[current].wanted = now;
+         lock_list[current].granted = 0;
          max = MAX(current, max);
          max_priority = MAX(priority, max_priority);
       }
@@ -466,6 +569,11 @@ public:
       ASSERT2(current >= 0, "Lock stack when negative");
       ASSERT(lock_list[current].state == LMGR_LOCK_WANTED);
       lock_list[current].state = LMGR_LOCK_GRANTED;
+      if (lock_list[current].site) {
+         lock_list[current].granted = get_current_btime();
+         lmgr_site_granted(lock_list[current].site,
+                           lock_list[current].granted - lock_list[current].wanted);
+      }
    }
 
    /* Using this function is some sort of bug */
@@ -500,6 +608,10 @@ public:
       lmgr_p(&mutex);
       {
          if (lock_list[current].lock == m) {
+            if (lock_list[current].site && lock_list[current].granted) {
+               lmgr_site_released(lock_list[current].site,
+                                  get_current_btime() - lock_list[current].granted);
+            }
             lock_list[current].lock = NULL;
             lock_list[current].state = LMGR_LOCK_EMPTY;
             current--;
@@ -684,6 +796,14 @@ void dbg_print_lock(FILE *fp)
    foreach_dlist(item, global_mgr) {
       item->_dump(fp);
    }
+   for (int i=0; i < LMGR_MAX_SITES; i++) {
+      lmgr_site_t *s = &lmgr_sites[i];
+      if (s->file && s->contended > 0) {
+         fprintf(fp, "lock site %s:%d count=%lld contended=%lld wait=%lld max_wait=%lld max_hold=%lld\n",
+                 s->file, s->line, (long long)s->count, (long long)s->contended,
+                 (long long)s->wait_total, (long long)s->wait_max, (long long)s->hold_max);
+      }
+   }
 }
 
 /*
@@ -701,6 +821,82 @@ void lmgr_dump()
    lmgr_v(&lmgr_global_mutex);
 }
 
+/*
+ * Edit the statistics of the max sites that waited the most
+ */
+static int lmgr_cmp_site(const void *a, const void *b)
+{
+   uint64_t wa = (*(lmgr_site_t **)a)->wait_total;
+   uint64_t wb = (*(lmgr_site_t **)b)->wait_total;
+   return wa < wb ? 1 : (wa > wb ? -1 : 0);
+}
+
+int lmgr_edit_contention(POOLMEM *&buf, int max)
+{
+   lmgr_site_t **sites;
+   POOL_MEM tmp(PM_MESSAGE);
+   char ed1[50], ed2[50], ed3[50];
+   int nb = 0, len;
+
+   *buf = 0;
+   if (!lmgr_is_active()) {
+      return 0;
+   }
+   sites = (lmgr_site_t **)malloc(LMGR_MAX_SITES * sizeof(lmgr_site_t *));
+   for (int i=0; i < LMGR_MAX_SITES; i++) {
+      if (lmgr_sites[i].file && lmgr_sites[i].count > 0) {
+         sites[nb++] = &lmgr_sites[i];
+      }
+   }
+   qsort(sites, nb, sizeof(lmgr_site_t *), lmgr_cmp_site);
+   len = Mmsg(buf, _(" Lock contention (%d sites, wait in us, histogram buckets are powers of 2 us):\n"), nb);
+   for (int i=0; i < nb && i < max; i++) {
+      lmgr_site_t *s = sites[i];
+      len = Mmsg(tmp, "  %s:%d count=%s contended=%s wait=%s max_wait=%lld max_hold=%lld avg_hold=%lld hist=",
+                 s->file, s->line,
+                 edit_uint64(s->count, ed1), edit_uint64(s->contended, ed2),
+                 edit_uint64(s->wait_total, ed3), (long long)s->wait_max,
+                 (long long)s->hold_max, (long long)(s->hold_total / s->count));
+      for (int j=0; j < LMGR_WAIT_BUCKETS; j++) {
+         len += bsnprintf(ed1, sizeof(ed1), "%s%lld", j ? "/" : "", (long long)s->wait_hist[j]);
+         pm_strcat(tmp, ed1);
+      }
+      pm_strcat(tmp, "\n");
+      len = pm_strcat(buf, tmp.c_str());
+   }
+   free(sites);
+   return len;
+}
+
+/*
+ * Called from the signal handler on SIGUSR1, the statistics are
+ *  written by the undertaker thread.  Returns false if the lock
+ *  manager is not running.
+ */
+bool lmgr_request_contention_dump()
+{
+   if (!lmgr_is_active() || !use_undertaker) {
+      return false;
+   }
+   lmgr_stats_requested = true;
+   return true;
+}
+
+static void lmgr_write_contention()
+{
+   POOL_MEM buf(PM_MESSAGE), fname(PM_FNAME);
+   FILE *fp;
+
+   Mmsg(fname, "%s/%s.%d.lockstats", working_directory ? working_directory : ".",
+        my_name, (int)getpid());
+   if ((fp = fopen(fname.c_str(), "a")) == NULL) {
+      return;
+   }
+   lmgr_edit_contention(buf.addr(), LMGR_MAX_SITES);
+   fprintf(fp, "%s", buf.c_str());
+   fclose(fp);
+}
+
 void cln_hdl(void *a)
 {
    lmgr_cleanup_thread();
@@ -709,12 +905,17 @@ void cln_hdl(void *a)
 void *check_deadlock(void *)
 {
    int old;
+   int tick = 0;
    lmgr_init_thread();
    pthread_cleanup_push(cln_hdl, NULL);
 
-   while (!bmicrosleep(30, 0)) {
+   while (!bmicrosleep(1, 0)) {
       pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old);
-      if (lmgr_detect_deadlock()) {
+      if (lmgr_stats_requested) {
+         lmgr_stats_requested = false;
+         lmgr_write_contention();
+      }
+      if (++tick % 30 == 0 && lmgr_detect_deadlock()) {
          /* If we have information about P()/V(), display them */
          if (debug_flags & DEBUG_MUTEX_EVENT || chk_dbglvl(DBGLEVEL_EVENT)) {
             debug_flags |= DEBUG_PRINT_EVENT;
@@ -151,6 +151,14 @@ void lmgr_add_event_p(const char *comment, intptr_t user_data, int32_t flags, co
  */
 bool lmgr_detect_deadlock_unlocked();
 
+/*
+ * Lock contention statistics per P() call site, for the status
+ *  commands.  SIGUSR1 asks the undertaker thread to write them in
+ *  <working directory>/<name>.<pid>.lockstats
+ */
+int lmgr_edit_contention(POOLMEM *&buf, int max);
+bool lmgr_request_contention_dump();
+
 /*
  * This function will run your thread with lmgr_init_thread() and
  * lmgr_cleanup_thread().
@@ -216,6 +224,8 @@ int bthread_kill(pthread_t thread, int sig,
 # define lmgr_do_lock(m, prio, f, l)
 # define lmgr_do_unlock(m)
 # define lmgr_cleanup_main()
+# define lmgr_edit_contention(buf, max)  (*(buf) = 0, 0)
+# define lmgr_request_contention_dump()  (false)
 # define bthread_mutex_set_priority(a,b)
 # define bthread_mutex_lock(a)           pthread_mutex_lock(a)
 # define bthread_mutex_lock_p(a, f, l)   pthread_mutex_lock(a)
@@ -518,22 +518,27 @@ static void make_unique_mail_filename(JCR *jcr, POOLMEM *&name, DEST *d)
 }
 
 /*
- * Open a mail pipe
+ * Edit the mail command, it needs the jcr for the job codes
  */
-static BPIPE *open_mail_pipe(JCR *jcr, POOLMEM *&cmd, DEST *d)
+static void edit_mail_cmd(JCR *jcr, POOLMEM *&cmd, DEST *d)
 {
-   BPIPE *bpipe;
-
    if (d->mail_cmd) {
       cmd = edit_job_codes(jcr, cmd, d->mail_cmd, d->where, message_job_code_callback);
    } else {
       Mmsg(cmd, "/usr/lib/sendmail -F Bacula %s", d->where);
    }
-   fflush(stdout);
+}
+
+/*
+ * Run an edited mail command, if we had to use sendmail, add subject
+ */
+static BPIPE *open_mail_cmd(const char *cmd, bool add_subject)
+{
+   BPIPE *bpipe;
 
-   if ((bpipe = open_bpipe(cmd, 120, "rw"))) {
-      /* If we had to use sendmail, add subject */
-      if (!d->mail_cmd) {
+   fflush(stdout);
+   if ((bpipe = open_bpipe((char *)cmd, 120, "rw"))) {
+      if (add_subject) {
          fprintf(bpipe->wfd, "Subject: %s\r\n\r\n", _("Bacula Message"));
       }
    } else {
@@ -544,6 +549,15 @@ static BPIPE *open_mail_pipe(JCR *jcr, POOLMEM *&cmd, DEST *d)
    return bpipe;
 }
 
+/*
+ * Open a mail pipe
+ */
+static BPIPE *open_mail_pipe(JCR *jcr, POOLMEM *&cmd, DEST *d)
+{
+   edit_mail_cmd(jcr, cmd, d);
+   return open_mail_cmd(cmd, d->mail_cmd == NULL);
+}
+
 /*
  * Close the messages for this Messages resource, which means to close
  *  any open files, and dispatch any pending email messages.
@@ -568,6 +582,9 @@ void close_msg(JCR *jcr)
       return;
    }
 
+   /* The delivery thread may still use the jcr */
+   wait_message_delivery(jcr);
+
    /* Wait for item to be not in use, then mark closing */
    if (msgs->is_closing()) {
       return;
@@ -735,6 +752,7 @@ void free_msgs_res(MSGS *msgs)
 void term_msg()
 {
    Dmsg0(850, "Enter term_msg\n");
+   stop_message_delivery();           /* deliver what is queued */
    close_msg(NULL);                   /* close global chain */
    free_msgs_res(daemon_msgs);        /* free the resources */
    daemon_msgs = NULL;
@@ -795,6 +813,438 @@ static void send_to_syslog(int mode, const char *msg)
    }
 }
 
+/* ===================================================================
+ *    Asynchronous message delivery
+ *
+ *  Syslog, operator mail and catalog destinations can block the
+ *  calling job thread for a long time (slow mail command, busy
+ *  syslog or catalog). Once the daemon calls start_message_delivery(),
+ *  dispatch_message() only queues the message for these destinations.
+ *  Each destination has its own queue and thread, so a slow mail
+ *  command does not hold back the catalog or the syslog messages.
+ *
+ *  When the syslog or operator queue is full, the producer waits for
+ *  room.  The catalog queue is never full: the catalog code calls
+ *  Jmsg() with the catalog lock held, and the catalog thread needs
+ *  that lock to make progress, so the messages are queued past the
+ *  limit (and we count it).  Either way the order of the messages
+ *  is kept.  Consecutive catalog messages of the same Job are stored
+ *  with a single INSERT.
+ *
+ *  A catalog message keeps the connection the Job had when it was
+ *  queued, the SQL hooks take its lock.  close_msg() and the code
+ *  that closes or replaces jcr->db wait until all the messages of
+ *  the Job are delivered, see wait_message_delivery().
+ */
+
+#define MAX_DELIVERY_QUEUE 10000      /* max messages queued per destination */
+#define MAX_DELIVERY_BATCH 100        /* max messages delivered at once */
+
+/* One queue and one thread per kind of destination */
+enum {
+   DQ_SYSLOG = 0,
+   DQ_OPERATOR,
+   DQ_CATALOG,
+   DQ_NR
+};
+
+struct MDELIVERY_ITEM {
+   dlink link;
+   JCR *jcr;                          /* Job of a catalog message */
+   B_DB *db;                          /* its catalog when queued */
+   int dest_code;                     /* MD_SYSLOG, MD_OPERATOR or MD_CATALOG */
+   utime_t mtime;                     /* message time */
+   char *cmd;                         /* edited operator command */
+   bool add_subject;                  /* operator command is sendmail */
+   int dtlen;                         /* length of the date prefix */
+   char msg[1];                       /* date prefix followed by message */
+};
+
+struct MDELIVERY_QUEUE {
+   dlist *queue;                      /* messages to deliver */
+   pthread_cond_t work;               /* queue not empty */
+   pthread_t tid;                     /* delivery thread */
+   int max_queued;                    /* high water mark */
+};
+
+static pthread_mutex_t delivery_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t delivery_done = PTHREAD_COND_INITIALIZER;  /* batch delivered */
+static MDELIVERY_QUEUE delivery_queues[DQ_NR];
+static int delivery_nr_threads = 0;        /* threads running */
+static bool delivery_started = false;
+static bool delivery_quit = false;
+
+/* Statistics, protected by delivery_mutex */
+static uint64_t delivery_queued = 0;       /* messages queued */
+static uint64_t delivery_delivered = 0;    /* messages delivered */
+static uint64_t delivery_full = 0;         /* queued on a full queue */
+static uint64_t delivery_rows = 0;         /* catalog Log rows */
+static uint64_t delivery_inserts = 0;      /* catalog INSERT statements */
+
+static int delivery_queue_index(int dest_code)
+{
+   switch (dest_code) {
+   case MD_SYSLOG:
+      return DQ_SYSLOG;
+   case MD_OPERATOR:
+      return DQ_OPERATOR;
+   case MD_CATALOG:
+      return DQ_CATALOG;
+   default:
+      return -1;
+   }
+}
+
+static bool is_delivery_thread()
+{
+   if (!delivery_started) {
+      return false;
+   }
+   for (int i=0; i < delivery_nr_threads; i++) {
+      if (pthread_equal(pthread_self(), delivery_queues[i].tid)) {
+         return true;
+      }
+   }
+   return false;
+}
+
+/*
+ * Queue a message for a delivery thread
+ *
+ *  Returns: true  if queued
+ *           false if the caller must deliver it
+ */
+static bool queue_message(JCR *jcr, DEST *d, utime_t mtime, const char *dt,
+                          int dtlen, const char *msg)
+{
+   MDELIVERY_ITEM *item;
+   MDELIVERY_QUEUE *q;
+   int idx, len;
+
+   if (!delivery_started || is_delivery_thread() ||
+       (idx = delivery_queue_index(d->dest_code)) < 0) {
+      return false;
+   }
+   q = &delivery_queues[idx];
+
+   /* Wait for room, except for the catalog, see above */
+   P(delivery_mutex);
+   if (q->queue && q->queue->size() >= MAX_DELIVERY_QUEUE) {
+      delivery_full++;
+      while (idx != DQ_CATALOG && !delivery_quit && q->queue &&
+             q->queue->size() >= MAX_DELIVERY_QUEUE) {
+         pthread_cond_wait(&delivery_done, &delivery_mutex);
+      }
+   }
+   if (delivery_quit || !q->queue) {
+      V(delivery_mutex);
+      return false;
+   }
+   V(delivery_mutex);
+
+   len = strlen(msg);
+   item = (MDELIVERY_ITEM *)malloc(sizeof(MDELIVERY_ITEM) + dtlen + len);
+   item->jcr = (d->dest_code == MD_CATALOG) ? jcr : NULL;
+   item->db = item->jcr ? jcr->db : NULL;
+   item->dest_code = d->dest_code;
+   item->mtime = mtime;
+   item->cmd = NULL;
+   item->add_subject = false;
+   item->dtlen = dtlen;
+   memcpy(item->msg, dt, dtlen);
+   memcpy(item->msg + dtlen, msg, len + 1);
+   if (d->dest_code == MD_OPERATOR) {
+      POOLMEM *cmd = get_pool_memory(PM_MESSAGE);
+      edit_mail_cmd(jcr, cmd, d);       /* needs the jcr, do it now */
+      item->cmd = bstrdup(cmd);
+      item->add_subject = d->mail_cmd == NULL;
+      free_pool_memory(cmd);
+   }
+
+   P(delivery_mutex);
+   if (delivery_quit || !q->queue) {
+      V(delivery_mutex);
+      if (item->cmd) {
+         free(item->cmd);
+      }
+      free(item);
+      return false;
+   }
+   if (item->jcr) {
+      item->jcr->msg_pending++;
+   }
+   q->queue->append(item);
+   delivery_queued++;
+   if (q->queue->size() > q->max_queued) {
+      q->max_queued = q->queue->size();
+   }
+   pthread_cond_signal(&q->work);
+   V(delivery_mutex);
+   return true;
+}
+
+/*
+ * Send one operator message, one mail per message
+ */
+static void deliver_operator(MDELIVERY_ITEM *item)
+{
+   BPIPE *bpipe;
+   int stat;
+
+   if ((bpipe = open_mail_cmd(item->cmd, item->add_subject))) {
+      fputs(item->msg, bpipe->wfd);    /* date prefix and message */
+      stat = close_bpipe(bpipe);
+      if (stat != 0) {
+         berrno be;
+         be.set_errno(stat);
+         delivery_error(_("Msg delivery error: Operator mail program terminated in error.\n"
+               "CMD=%s\n"
+               "ERR=%s\n"), item->cmd, be.bstrerror());
+      }
+   }
+}
+
+static void flush_catalog_rows(JCR *jcr, B_DB *db, POOL_MEM &cmd, int rows)
+{
+   if (!p_sql_query(jcr, db, cmd.c_str())) {
+      delivery_error(_("Msg delivery error: Unable to store data in database.\n"));
+   }
+   P(delivery_mutex);
+   delivery_inserts++;
+   delivery_rows += rows;
+   V(delivery_mutex);
+}
+
+/*
+ * Deliver a batch of messages, the catalog messages of
+ *  the same Job are sent with one multi-row INSERT.
+ */
+static void deliver_batch(dlist *batch)
+{
+   MDELIVERY_ITEM *item;
+   POOL_MEM cmd(PM_MESSAGE), row(PM_MESSAGE), esc(PM_MESSAGE);
+   char dt[MAX_TIME_LENGTH], ed1[50];
+   JCR *cjcr = NULL;
+   B_DB *cdb = NULL;
+   int rows = 0;
+   int len;
+
+   foreach_dlist(item, batch) {
+      switch (item->dest_code) {
+      case MD_SYSLOG:
+         send_to_syslog(LOG_DAEMON|LOG_ERR, item->msg + item->dtlen);
+         break;
+      case MD_OPERATOR:
+         deliver_operator(item);
+         break;
+      case MD_CATALOG:
+         if (rows > 0 && (item->jcr != cjcr || item->db != cdb)) {
+            flush_catalog_rows(cjcr, cdb, cmd, rows);
+            rows = 0;
+         }
+         cjcr = item->jcr;
+         cdb = item->db;
+         if (!p_sql_query || !p_sql_escape || !cdb) {
+            break;
+         }
+         len = strlen(item->msg + item->dtlen) + 1;
+         esc.check_size(len * 2 + 1);
+         if (!p_sql_escape(cjcr, cdb, esc.c_str(), item->msg + item->dtlen, len)) {
+            delivery_error(_("Msg delivery error: Unable to store data in database.\n"));
+            break;
+         }
+         bstrutime(dt, sizeof(dt), item->mtime);
+         Mmsg(row, "%s(%s,'%s','%s')", rows ? "," : "",
+              edit_int64(cjcr->JobId, ed1), dt, esc.c_str());
+         if (rows == 0) {
+            pm_strcpy(cmd, "INSERT INTO Log (JobId, Time, LogText) VALUES ");
+         }
+         pm_strcat(cmd, row.c_str());
+         rows++;
+         break;
+      default:
+         break;
+      }
+   }
+   if (rows > 0) {
+      flush_catalog_rows(cjcr, cdb, cmd, rows);
+   }
+}
+
+/*
+ * A delivery thread takes up to MAX_DELIVERY_BATCH messages of
+ *  its queue at a time and delivers them without holding the
+ *  queue lock.  When asked to quit, it empties its queue first.
+ */
+extern "C" void *msg_delivery_thread(void *arg)
+{
+   MDELIVERY_QUEUE *q = (MDELIVERY_QUEUE *)arg;
+   MDELIVERY_ITEM *item = NULL;
+   dlist *batch = New(dlist(item, &item->link));
+   int n;
+
+   set_jcr_in_tsd(INVALID_JCR);
+   P(delivery_mutex);
+   for ( ;; ) {
+      while (q->queue->empty() && !delivery_quit) {
+         pthread_cond_wait(&q->work, &delivery_mutex);
+      }
+      if (q->queue->empty()) {
+         break;                       /* quit and nothing left */
+      }
+      for (n=0; n < MAX_DELIVERY_BATCH && !q->queue->empty(); n++) {
+         item = (MDELIVERY_ITEM *)q->queue->first();
+         q->queue->remove(item);
+         batch->append(item);
+      }
+      V(delivery_mutex);
+
+      deliver_batch(batch);
+
+      P(delivery_mutex);
+      while ((item = (MDELIVERY_ITEM *)batch->first())) {
+         batch->remove(item);
+         if (item->jcr) {
+            item->jcr->msg_pending--;
+         }
+         if (item->cmd) {
+            free(item->cmd);
+         }
+         free(item);
+         delivery_delivered++;
+      }
+      pthread_cond_broadcast(&delivery_done);
+   }
+   V(delivery_mutex);
+   delete batch;
+   return NULL;
+}
+
+/* Stop the threads that are running and free the queues.  Needs delivery_mutex */
+static void stop_delivery_threads()
+{
+   int nr = delivery_nr_threads;
+
+   delivery_quit = true;
+   for (int i=0; i < nr; i++) {
+      pthread_cond_broadcast(&delivery_queues[i].work);
+   }
+   V(delivery_mutex);
+   for (int i=0; i < nr; i++) {
+      pthread_join(delivery_queues[i].tid, NULL);
+   }
+   P(delivery_mutex);
+   delivery_nr_threads = 0;
+   for (int i=0; i < DQ_NR; i++) {
+      if (delivery_queues[i].queue) {
+         delete delivery_queues[i].queue;
+         delivery_queues[i].queue = NULL;
+      }
+      pthread_cond_destroy(&delivery_queues[i].work);
+   }
+}
+
+/*
+ * Called by the daemons once they are running (after the fork),
+ *  programs that do not call it keep delivering synchronously.
+ */
+void start_message_delivery()
+{
+   MDELIVERY_ITEM *item = NULL;
+   int stat;
+
+   P(delivery_mutex);
+   if (delivery_started) {
+      V(delivery_mutex);
+      return;
+   }
+   delivery_quit = false;
+   for (int i=0; i < DQ_NR; i++) {
+      delivery_queues[i].queue = New(dlist(item, &item->link));
+      delivery_queues[i].max_queued = 0;
+      pthread_cond_init(&delivery_queues[i].work, NULL);
+   }
+   for (int i=0; i < DQ_NR; i++) {
+      if ((stat = pthread_create(&delivery_queues[i].tid, NULL, msg_delivery_thread,
+                                 &delivery_queues[i])) != 0) {
+         stop_delivery_threads();
+         V(delivery_mutex);
+         berrno be;
+         Emsg1(M_ERROR, 0, _("Cannot start message delivery thread: ERR=%s\n"),
+               be.bstrerror(stat));
+         return;
+      }
+      delivery_nr_threads++;
+   }
+   delivery_started = true;
+   V(delivery_mutex);
+}
+
+/*
+ * Deliver what is queued, then stop the delivery threads
+ */
+void stop_message_delivery()
+{
+   P(delivery_mutex);
+   if (!delivery_started || delivery_quit) {
+      V(delivery_mutex);
+      return;
+   }
+   stop_delivery_threads();
+   delivery_started = false;
+   V(delivery_mutex);
+}
+
+/*
+ * Wait until all the queued catalog messages of a Job are delivered.
+ *  Must be called before jcr->db is closed.
+ */
+void wait_message_delivery(JCR *jcr)
+{
+   if (!jcr || is_delivery_thread()) {
+      return;
+   }
+   P(delivery_mutex);
+   while (jcr->msg_pending > 0) {
+      pthread_cond_wait(&delivery_done, &delivery_mutex);
+   }
+   V(delivery_mutex);
+}
+
+/*
+ * Edit the delivery statistics for the status commands
+ *
+ *  Returns: length of the line, 0 if delivery is synchronous
+ */
+int edit_message_delivery_status(POOLMEM *&buf)
+{
+   char b1[50], b2[50], b3[50], b4[50], b5[50];
+   int len, pending = 0, max_pending = 0;
+
+   P(delivery_mutex);
+   if (!delivery_started) {
+      V(delivery_mutex);
+      *buf = 0;
+      return 0;
+   }
+   for (int i=0; i < DQ_NR; i++) {
+      if (delivery_queues[i].queue) {
+         pending += delivery_queues[i].queue->size();
+      }
+      max_pending = MAX(max_pending, delivery_queues[i].max_queued);
+   }
+   len = Mmsg(buf, _(" Msg delivery: queued=%s delivered=%s pending=%d max_pending=%d "
+                     "queue_full=%s catalog_rows=%s catalog_inserts=%s\n"),
+              edit_uint64_with_commas(delivery_queued, b1),
+              edit_uint64_with_commas(delivery_delivered, b2),
+              pending, max_pending,
+              edit_uint64_with_commas(delivery_full, b3),
+              edit_uint64_with_commas(delivery_rows, b4),
+              edit_uint64_with_commas(delivery_inserts, b5));
+   V(delivery_mutex);
+   return len;
+}
+
 /*
  * Handle sending the message to the appropriate place
  */
@@ -872,6 +1322,13 @@ void dispatch_message(JCR *jcr, int type, utime_t mtime, char *msg)
 
     for (d=msgs->dest_chain; d; d=d->next) {
        if (bit_is_set(type, d->msg_types)) {
+          /* Let the delivery thread handle the slow destinations */
+          if ((d->dest_code == MD_SYSLOG || d->dest_code == MD_OPERATOR ||
+               (d->dest_code == MD_CATALOG && jcr && jcr->db)) &&
+              type != M_ABORT && type != M_ERROR_TERM &&
+              queue_message(jcr, d, mtime, dt, dtlen, msg)) {
+             continue;
+          }
           switch (d->dest_code) {
              case MD_CATALOG:
                 char ed1[50];
@@ -888,7 +1345,7 @@ void dispatch_message(JCR *jcr, int type, utime_t mtime, char *msg)
                       bstrutime(dt, sizeof(dt), mtime);
                       Mmsg(cmd, "INSERT INTO Log (JobId, Time, LogText) VALUES (%s,'%s','%s')",
                             edit_int64(jcr->JobId, ed1), dt, esc_msg);
-                      if (!p_sql_query(jcr, cmd)) {
+                      if (!p_sql_query(jcr, jcr->db, cmd)) {
                          delivery_error(_("Msg delivery error: Unable to store data in database.\n"));
                       }
                    } else {
@@ -168,7 +168,7 @@ void set_debug_flags(char *options);
 const char *get_basename(const char *pathname);
 
 class B_DB;
-typedef bool (*sql_query_func)(JCR *jcr, const char *cmd);
+typedef bool (*sql_query_func)(JCR *jcr, B_DB *db, const char *cmd);
 typedef bool (*sql_escape_func)(JCR *jcr, B_DB *db, char *snew, char *old, int len);
 
 extern DLL_IMP_EXP sql_query_func     p_sql_query;
@@ -0,0 +1,699 @@
+/*
+   Bacula® - The Network Backup Solution
+
+   Copyright (C) 2014-2014 Free Software Foundation Europe e.V.
+
+   The main author of Bacula is Kern Sibbald, with contributions from many
+   others, a complete list can be found in the file AUTHORS.
+
+   You may use this file and others of this release according to the
+   license defined in the LICENSE file, which includes the Affero General
+   Public License, v3.0 ("AGPLv3") and some additional permissions and
+   terms pursuant to its AGPLv3 Section 7.
+
+   Bacula® is a registered trademark of Kern Sibbald.
+*/
+/*
+ *  Bacula open addressing hash table routines
+ *
+ *  ohtable is a hash table of items (pointers) like htable, but
+ *    the items are not chained through an hlink. Each slot of the
+ *    table holds the full 64 bit hash, the key and the item, and
+ *    collisions are resolved by linear probing, so a lookup walks
+ *    consecutive memory instead of chasing pointers through the heap.
+ *
+ *  When the table is 3/4 full, a table twice as big is allocated
+ *    and the old slots are moved over a few at a time on each
+ *    following insert, so no single insert pays for rehashing the
+ *    whole table. Until the old table is drained, lookups check
+ *    both tables. Migrated slots are left in place in the old
+ *    table so that its probe sequences stay intact.
+ *
+ *  Items are never removed, the memory is released all at once
+ *    with destroy(), exactly as with htable.
+ */
+
+#include "bacula.h"
+
+#define B_PAGE_SIZE 4096
+#define MIN_PAGES 32
+#define MAX_PAGES 2400
+#define MIN_BUF_SIZE (MIN_PAGES * B_PAGE_SIZE) /* 128 Kb */
+#define MAX_BUF_SIZE (MAX_PAGES * B_PAGE_SIZE) /* approx 10MB */
+
+#define MIN_BUCKETS  32               /* smallest slot array */
+#define MIGRATE_STEP 16               /* old slots moved per insert */
+
+#define dbglvl     500
+#define dbglvl_mem DT_MEMORY|100
+
+/* ===================================================================
+ *    Hash functions
+ */
+
+/*
+ * 64 bit string hash (MurmurHash64A by Austin Appleby, public domain).
+ *  It reads the key 8 bytes at a time and mixes much better than
+ *  the rotate and add hash of htable, which matters here because
+ *  linear probing is sensitive to clustering.
+ *  The result is never 0, which marks an empty slot.
+ */
+uint64_t hash_string(const char *key)
+{
+   const uint64_t m = UINT64_C(0xc6a4a7935bd1e995);
+   const int r = 47;
+   size_t len = strlen(key);
+   const unsigned char *p = (const unsigned char *)key;
+   const unsigned char *end = p + (len & ~(size_t)7);
+   uint64_t h = UINT64_C(0x9e3779b97f4a7c15) ^ (len * m);
+   uint64_t k;
+
+   for ( ; p < end; p += 8) {
+      memcpy(&k, p, sizeof(k));
+      k *= m;
+      k ^= k >> r;
+      k *= m;
+      h ^= k;
+      h *= m;
+   }
+   switch (len & 7) {
+   case 7: h ^= (uint64_t)p[6] << 48;
+   case 6: h ^= (uint64_t)p[5] << 40;
+   case 5: h ^= (uint64_t)p[4] << 32;
+   case 4: h ^= (uint64_t)p[3] << 24;
+   case 3: h ^= (uint64_t)p[2] << 16;
+   case 2: h ^= (uint64_t)p[1] << 8;
+   case 1: h ^= (uint64_t)p[0];
+           h *= m;
+   }
+   h ^= h >> r;
+   h *= m;
+   h ^= h >> r;
+   return h ? h : 1;
+}
+
+/*
+ * Integer keys (JobIds, FileIndexes, inodes) are often sequential,
+ *  so spread them over the whole 64 bits (MurmurHash3 finalizer).
+ */
+uint64_t hash_uint64(uint64_t key)
+{
+   key ^= key >> 33;
+   key *= UINT64_C(0xff51afd7ed558ccd);
+   key ^= key >> 33;
+   key *= UINT64_C(0xc4ceb9fe1a85ec53);
+   key ^= key >> 33;
+   return key ? key : 1;
+}
+
+/* ===================================================================
+ *    ohtable
+ */
+
+/*
+ * This subroutine gets a big buffer.
+ */
+void ohtable::malloc_big_buf(int size)
+{
+   struct h_mem *hmem;
+
+   hmem = (struct h_mem *)malloc(size);
+   total_size += size;
+   blocks++;
+   hmem->next = mem_block;
+   mem_block = hmem;
+   hmem->mem = mem_block->first;
+   hmem->rem = (char *)hmem + size - hmem->mem;
+   Dmsg3(dbglvl_mem, "malloc buf=%p size=%d rem=%d\n", hmem, size, hmem->rem);
+}
+
+/* This routine frees all the big buffers */
+void ohtable::hash_big_free()
+{
+   struct h_mem *hmem, *rel;
+
+   for (hmem=mem_block; hmem; ) {
+      rel = hmem;
+      hmem = hmem->next;
+      Dmsg1(dbglvl_mem, "free malloc buf=%p\n", rel);
+      free(rel);
+   }
+   mem_block = NULL;
+}
+
+/*
+ * Normal hash malloc routine that gets a
+ *  "small" buffer from the big buffer
+ */
+char *ohtable::hash_malloc(int size)
+{
+   int mb_size;
+   char *buf;
+   int asize = BALIGN(size);
+
+   if (!mem_block || mem_block->rem < asize) {
+      if (total_size >= (extend_length / 2)) {
+         mb_size = extend_length;
+      } else {
+         mb_size = extend_length / 2;
+      }
+      malloc_big_buf(mb_size);
+      Dmsg1(dbglvl_mem, "Created new big buffer of %ld bytes\n", mb_size);
+   }
+   mem_block->rem -= asize;
+   buf = mem_block->mem;
+   mem_block->mem += asize;
+   return buf;
+}
+
+/*
+ * tsize is the estimated number of entries in the hash table
+ */
+ohtable::ohtable(int tsize, int nr_pages)
+{
+   init(tsize, nr_pages);
+}
+
+void ohtable::init(int tsize, int nr_pages)
+{
+   int pagesize;
+   int buffer_size;
+
+   memset(this, 0, sizeof(ohtable));
+   if (tsize < 31) {
+      tsize = 31;
+   }
+   /* Keep the initial load under 3/4 */
+   for (buckets = MIN_BUCKETS; buckets < (uint32_t)tsize + tsize / 3; ) {
+      buckets <<= 1;
+   }
+   mask = buckets - 1;
+   max_items = buckets / 4 * 3;
+   table = (ohslot *)malloc(buckets * sizeof(ohslot));
+   memset(table, 0, buckets * sizeof(ohslot));
+
+#ifdef HAVE_GETPAGESIZE
+   pagesize = getpagesize();
+#else
+   pagesize = B_PAGE_SIZE;
+#endif
+   if (nr_pages == 0) {
+      buffer_size = MAX_BUF_SIZE;
+   } else {
+      buffer_size = pagesize * nr_pages;
+      if (buffer_size > MAX_BUF_SIZE) {
+         buffer_size = MAX_BUF_SIZE;
+      } else if (buffer_size < MIN_BUF_SIZE) {
+         buffer_size = MIN_BUF_SIZE;
+      }
+   }
+   malloc_big_buf(buffer_size);
+   extend_length = buffer_size;
+   Dmsg1(dbglvl_mem, "Allocated big buffer of %ld bytes\n", buffer_size);
+}
+
+uint32_t ohtable::size()
+{
+   return num_items;
+}
+
+/*
+ * Return the slot holding key, or the empty slot where
+ *  it would be inserted. The table is never full, so
+ *  the probe always ends.
+ */
+ohslot *ohtable::find(ohslot *tbl, uint32_t tmask, uint64_t hash,
+                      key_type_t type, union hlink_key *key)
+{
+   uint32_t i = (uint32_t)hash & tmask;
+   ohslot *slot;
+
+   searches++;
+   for ( ;; i = (i + 1) & tmask) {
+      slot = &tbl[i];
+      probes++;
+      if (slot->hash == 0) {
+         return slot;
+      }
+      if (slot->hash != hash) {
+         continue;
+      }
+      switch (type) {
+      case KEY_TYPE_CHAR:
+         if (strcmp(key->char_key, slot->key.char_key) == 0) {
+            return slot;
+         }
+         break;
+      case KEY_TYPE_UINT32:
+         if (key->uint32_key == slot->key.uint32_key) {
+            return slot;
+         }
+         break;
+      case KEY_TYPE_UINT64:
+         if (key->uint64_key == slot->key.uint64_key) {
+            return slot;
+         }
+         break;
+      }
+   }
+}
+
+/*
+ * Store a slot coming from the old table, the key is
+ *  known not to be in the new table.
+ */
+void ohtable::put(ohslot *slot)
+{
+   uint32_t i = (uint32_t)slot->hash & mask;
+
+   while (table[i].hash != 0) {
+      i = (i + 1) & mask;
+   }
+   table[i] = *slot;
+}
+
+/*
+ * Move count slots of the old table into the new one and
+ *  release the old table once it has been walked completely.
+ */
+void ohtable::migrate(uint32_t count)
+{
+   for ( ; count > 0 && old_index < old_buckets; count--) {
+      ohslot *slot = &old_table[old_index++];
+      if (slot->hash != 0) {
+         put(slot);
+      }
+   }
+   if (old_index >= old_buckets) {
+      Dmsg1(100, "Migration of %d buckets done.\n", old_buckets);
+      free(old_table);
+      old_table = NULL;
+      old_buckets = old_index = 0;
+   }
+}
+
+/*
+ * Allocate a table twice as big. The current one becomes
+ *  the old table and is drained by the following inserts.
+ *  With MIGRATE_STEP > 1, the old table is always empty
+ *  before we need to grow again, but be safe.
+ */
+void ohtable::grow_table()
+{
+   if (old_table) {
+      migrate(old_buckets);
+   }
+   Dmsg1(100, "Grow called old size = %d\n", buckets);
+   old_table = table;
+   old_buckets = buckets;
+   old_index = 0;
+   buckets <<= 1;
+   mask = buckets - 1;
+   max_items = buckets / 4 * 3;
+   table = (ohslot *)malloc(buckets * sizeof(ohslot));
+   memset(table, 0, buckets * sizeof(ohslot));
+}
+
+void *ohtable::search(uint64_t hash, key_type_t type, union hlink_key *key)
+{
+   ohslot *slot;
+
+   if (num_items == 0) {
+      return NULL;
+   }
+   ASSERT(key_type == type);
+   slot = find(table, mask, hash, type, key);
+   if (slot->hash == 0 && old_table) {
+      slot = find(old_table, old_buckets - 1, hash, type, key);
+   }
+   Dmsg1(dbglvl, "lookup return %p\n", slot->item);
+   return slot->hash ? slot->item : NULL;
+}
+
+bool ohtable::add(uint64_t hash, key_type_t type, union hlink_key *key, void *item)
+{
+   ohslot *slot;
+
+   if (key_type == 0) {
+      key_type = type;
+   }
+   ASSERT(key_type == type);
+   if (old_table) {
+      migrate(MIGRATE_STEP);
+   }
+   if (num_items >= max_items) {
+      Dmsg2(dbglvl, "num_items=%d max_items=%d\n", num_items, max_items);
+      grow_table();
+   }
+   slot = find(table, mask, hash, type, key);
+   if (slot->hash != 0) {
+      return false;                   /* already exists */
+   }
+   if (old_table && find(old_table, old_buckets - 1, hash, type, key)->hash != 0) {
+      return false;                   /* already exists */
+   }
+   slot->hash = hash;
+   slot->key = *key;
+   slot->item = item;
+   num_items++;
+   Dmsg3(dbglvl, "Leave insert hash=0x%llx num_items=%d item=%p\n", hash, num_items, item);
+   return true;
+}
+
+bool ohtable::insert(char *key, void *item)
+{
+   union hlink_key k;
+   k.char_key = key;
+   return add(hash_string(key), KEY_TYPE_CHAR, &k, item);
+}
+
+bool ohtable::insert(uint32_t key, void *item)
+{
+   union hlink_key k;
+   k.uint64_key = 0;
+   k.uint32_key = key;
+   return add(hash_uint64(key), KEY_TYPE_UINT32, &k, item);
+}
+
+bool ohtable::insert(uint64_t key, void *item)
+{
+   union hlink_key k;
+   k.uint64_key = key;
+   return add(hash_uint64(key), KEY_TYPE_UINT64, &k, item);
+}
+
+void *ohtable::lookup(char *key)
+{
+   union hlink_key k;
+   k.char_key = key;
+   return search(hash_string(key), KEY_TYPE_CHAR, &k);
+}
+
+void *ohtable::lookup(uint32_t key)
+{
+   union hlink_key k;
+   k.uint64_key = 0;
+   k.uint32_key = key;
+   return search(hash_uint64(key), KEY_TYPE_UINT32, &k);
+}
+
+void *ohtable::lookup(uint64_t key)
+{
+   union hlink_key k;
+   k.uint64_key = key;
+   return search(hash_uint64(key), KEY_TYPE_UINT64, &k);
+}
+
+/*
+ * Walk the current table, then the part of the old table
+ *  that is not yet migrated. As with htable, the table must
+ *  not be modified during the walk.
+ */
+void *ohtable::next()
+{
+   while (!walk_old && walk_index < buckets) {
+      ohslot *slot = &table[walk_index++];
+      if (slot->hash) {
+         return slot->item;
+      }
+   }
+   if (!walk_old) {
+      if (!old_table) {
+         return NULL;
+      }
+      walk_old = true;
+      walk_index = old_index;
+   }
+   while (walk_index < old_buckets) {
+      ohslot *slot = &old_table[walk_index++];
+      if (slot->hash) {
+         return slot->item;
+      }
+   }
+   Dmsg0(dbglvl, "next: return NULL\n");
+   return NULL;
+}
+
+void *ohtable::first()
+{
+   Dmsg0(dbglvl, "Enter first\n");
+   walk_index = 0;
+   walk_old = false;
+   return next();
+}
+
+/*
+ * Report the number of items, the average number of slots
+ *  probed per search and the distribution of the distance
+ *  between an item and its home slot.
+ */
+#define MAX_COUNT 20
+void ohtable::stats()
+{
+   int dist[MAX_COUNT];
+   uint32_t max = 0;
+   uint32_t i, d;
+
+   printf("\n\nNumItems=%d\nTotal buckets=%d\n", num_items, buckets);
+   printf("Distance from home slot: items\n");
+   for (i=0; i < MAX_COUNT; i++) {
+      dist[i] = 0;
+   }
+   for (i=0; i < buckets; i++) {
+      if (table[i].hash == 0) {
+         continue;
+      }
+      d = (i - ((uint32_t)table[i].hash & mask)) & mask;
+      if (d > max) {
+         max = d;
+      }
+      if (d < MAX_COUNT) {
+         dist[d]++;
+      }
+   }
+   for (i=0; i < MAX_COUNT; i++) {
+      printf("%2d:           %d\n", i, dist[i]);
+   }
+   printf("buckets=%d num_items=%d max_items=%d\n", buckets, num_items, max_items);
+   printf("old buckets=%d migrated=%d\n", old_buckets, old_index);
+   printf("max distance from home slot = %d\n", max);
+   printf("average probes per search = %.2f\n",
+          searches ? (double)probes / searches : 0.0);
+   printf("total bytes malloced = %lld\n", (long long int)total_size);
+   printf("total blocks malloced = %d\n", blocks);
+}
+
+/* Destroy the table and its contents */
+void ohtable::destroy()
+{
+   hash_big_free();
+
+   if (table) {
+      free(table);
+      table = NULL;
+   }
+   if (old_table) {
+      free(old_table);
+      old_table = NULL;
+   }
+   garbage_collect_memory();
+   Dmsg0(100, "Done destroy.\n");
+}
+
+
+
+#ifdef TEST_PROGRAM
+
+/*
+ * Without BENCH_OHTABLE this is a unit test, started with a
+ *  small table so that many incremental grows happen.
+ * With BENCH_OHTABLE, it compares htable and ohtable on
+ *  a file list of NITEMS paths (or argv[1]).
+ */
+struct MYJCR {
+   char *key;
+   hlink link;
+};
+
+#ifdef BENCH_OHTABLE
+#define NITEMS 10000000
+#else
+#define NITEMS 50000
+#endif
+
+static int make_path(char *buf, int i)
+{
+   return sprintf(buf, "/srv/data/home/user%04d/projects/dir%03d/file%07d.dat",
+                  i % 1000, (i / 1000) % 1000, i) + 1;
+}
+
+#ifdef BENCH_OHTABLE
+static void report(const char *what, int n, btime_t start)
+{
+   btime_t elapsed = get_current_btime() - start;
+   if (elapsed <= 0) {
+      elapsed = 1;
+   }
+   printf("%-24s %9.3f s  %8.0f ns/op\n", what, elapsed / 1000000.0,
+          elapsed * 1000.0 / n);
+}
+
+int main(int argc, char *argv[])
+{
+   char mkey[100];
+   int nitems = NITEMS;
+   int found;
+   MYJCR *items;
+   htable *htbl;
+   ohtable *otbl;
+   btime_t start;
+
+   if (argc > 1) {
+      nitems = atoi(argv[1]);
+   }
+   printf("Building %d paths\n", nitems);
+   items = (MYJCR *)malloc(nitems * sizeof(MYJCR));
+   otbl = (ohtable *)malloc(sizeof(ohtable));
+   otbl->init(nitems / 4);
+   for (int i=0; i < nitems; i++) {
+      int len = make_path(mkey, i);
+      items[i].key = otbl->hash_malloc(len);
+      memcpy(items[i].key, mkey, len);
+   }
+
+   htbl = (htable *)malloc(sizeof(htable));
+   htbl->init(items, &items->link, nitems / 4);
+   start = get_current_btime();
+   for (int i=0; i < nitems; i++) {
+      htbl->insert(items[i].key, &items[i]);
+   }
+   report("htable insert", nitems, start);
+   start = get_current_btime();
+   found = 0;
+   for (int i=0; i < nitems; i++) {
+      found += htbl->lookup(items[(int)(((int64_t)i * 7919) % nitems)].key) != NULL;
+   }
+   report("htable lookup hit", nitems, start);
+   start = get_current_btime();
+   found = 0;
+   for (int i=0; i < nitems; i++) {
+      make_path(mkey, nitems + i);
+      found += htbl->lookup(mkey) != NULL;
+   }
+   report("htable lookup miss", nitems, start);
+   htbl->destroy();
+   free(htbl);
+
+   start = get_current_btime();
+   for (int i=0; i < nitems; i++) {
+      otbl->insert(items[i].key, &items[i]);
+   }
+   report("ohtable insert", nitems, start);
+   start = get_current_btime();
+   found = 0;
+   for (int i=0; i < nitems; i++) {
+      found += otbl->lookup(items[(int)(((int64_t)i * 7919) % nitems)].key) != NULL;
+   }
+   report("ohtable lookup hit", nitems, start);
+   start = get_current_btime();
+   found = 0;
+   for (int i=0; i < nitems; i++) {
+      make_path(mkey, nitems + i);
+      found += otbl->lookup(mkey) != NULL;
+   }
+   report("ohtable lookup miss", nitems, start);
+   if (found) {
+      printf("***ERROR*** %d unexpected hits\n", found);
+   }
+   otbl->stats();
+   otbl->destroy();
+   free(otbl);
+   free(items);
+
+   sm_dump(false);
+   return 0;
+}
+
+#else  /* !BENCH_OHTABLE */
+
+int main()
+{
+   char mkey[100];
+   ohtable *jcrtbl;
+   ohtable *inttbl;
+   MYJCR *jcr, *item;
+   int count = 0;
+   int errors = 0;
+
+   jcrtbl = (ohtable *)malloc(sizeof(ohtable));
+   jcrtbl->init(31, 128);
+
+   Dmsg1(000, "Inserting %d items\n", NITEMS);
+   for (int i=0; i < NITEMS; i++) {
+      int len = make_path(mkey, i);
+      jcr = (MYJCR *)jcrtbl->hash_malloc(sizeof(MYJCR));
+      jcr->key = jcrtbl->hash_malloc(len);
+      memcpy(jcr->key, mkey, len);
+      if (!jcrtbl->insert(jcr->key, jcr)) {
+         printf("Insert of %s failed.\n", jcr->key);
+         errors++;
+      }
+      /* Every item inserted so far must be found, even during a grow */
+      make_path(mkey, i / 2);
+      if (!(item = (MYJCR *)jcrtbl->lookup(mkey)) || strcmp(item->key, mkey) != 0) {
+         printf("Bad news: %s not found.\n", mkey);
+         errors++;
+      }
+   }
+   make_path(mkey, 10);
+   if (jcrtbl->insert(mkey, jcr)) {
+      printf("Duplicate %s inserted.\n", mkey);
+      errors++;
+   }
+   make_path(mkey, NITEMS);
+   if (jcrtbl->lookup(mkey)) {
+      printf("Found %s that was never inserted.\n", mkey);
+      errors++;
+   }
+   if (jcrtbl->size() != NITEMS) {
+      printf("size()=%d expected %d\n", jcrtbl->size(), NITEMS);
+      errors++;
+   }
+
+   jcrtbl->stats();
+   printf("Walk the hash table:\n");
+   foreach_ohtable(jcr, jcrtbl) {
+      count++;
+   }
+   printf("Got %d items -- %s\n", count, count==NITEMS?"OK":"***ERROR***");
+   if (count != NITEMS) {
+      errors++;
+   }
+   printf("Calling destroy\n");
+   jcrtbl->destroy();
+   free(jcrtbl);
+
+   /* Integer keys */
+   inttbl = New(ohtable());
+   for (uint32_t i=0; i < NITEMS; i++) {
+      inttbl->insert(i, (void *)(intptr_t)(i + 1));
+   }
+   for (uint32_t i=0; i < NITEMS; i++) {
+      if (inttbl->lookup(i) != (void *)(intptr_t)(i + 1)) {
+         printf("Bad news: int %d not found.\n", i);
+         errors++;
+         break;
+      }
+   }
+   if (inttbl->lookup((uint32_t)NITEMS)) {
+      printf("Found int %d that was never inserted.\n", NITEMS);
+      errors++;
+   }
+   delete inttbl;
+
+   printf("%s\n", errors ? "***ERROR***" : "OK");
+   sm_dump(false);   /* unit test */
+   return errors ? 1 : 0;
+}
+#endif /* BENCH_OHTABLE */
+#endif /* TEST_PROGRAM */
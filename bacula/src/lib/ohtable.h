@@ -0,0 +1,102 @@
+/*
+   Bacula® - The Network Backup Solution
+
+   Copyright (C) 2014-2014 Free Software Foundation Europe e.V.
+
+   The main author of Bacula is Kern Sibbald, with contributions from many
+   others, a complete list can be found in the file AUTHORS.
+
+   You may use this file and others of this release according to the
+   license defined in the LICENSE file, which includes the Affero General
+   Public License, v3.0 ("AGPLv3") and some additional permissions and
+   terms pursuant to its AGPLv3 Section 7.
+
+   Bacula® is a registered trademark of Kern Sibbald.
+*/
+
+#ifndef OHTABLE_H
+#define OHTABLE_H
+
+/* ========================================================================
+ *
+ *   Open addressing hash table class -- ohtable
+ *
+ *   Unlike htable, the items are not linked together: the table
+ *   holds the key, the full hash and the item pointer in a flat
+ *   array of slots, so a lookup usually touches one cache line.
+ *   The table grows incrementally: a bigger slot array is allocated
+ *   and the old one is drained a few slots at a time on each insert.
+ *
+ *   The API mimics htable so that call sites can be migrated
+ *   one at a time.
+ */
+
+/*
+ * Loop var through each member of table
+ */
+#ifdef HAVE_TYPEOF
+#define foreach_ohtable(var, tbl) \
+        for((var)=(typeof(var))((tbl)->first()); \
+           (var); \
+           (var)=(typeof(var))((tbl)->next()))
+#else
+#define foreach_ohtable(var, tbl) \
+        for((*((void **)&(var))=(void *)((tbl)->first())); \
+            (var); \
+            (*((void **)&(var))=(void *)((tbl)->next())))
+#endif
+
+/* A slot with hash == 0 is empty, computed hashes are never 0 */
+struct ohslot {
+   uint64_t hash;                     /* full hash of the key */
+   union hlink_key key;               /* key for this item */
+   void *item;                        /* user item */
+};
+
+class ohtable : public SMARTALLOC {
+   ohslot *table;                     /* current slot array */
+   ohslot *old_table;                 /* slot array being drained, or NULL */
+   uint64_t total_size;               /* total bytes malloced */
+   key_type_t key_type;               /* type of the keys (one per table) */
+   uint32_t extend_length;            /* number of bytes to allocate when extending buffer */
+   uint32_t num_items;                /* current number of items */
+   uint32_t max_items;                /* maximum items before growing */
+   uint32_t buckets;                  /* size of slot array */
+   uint32_t mask;                     /* buckets - 1 */
+   uint32_t old_buckets;              /* size of old_table */
+   uint32_t old_index;                /* next old slot to migrate */
+   uint32_t walk_index;               /* table walk index */
+   bool walk_old;                     /* walking old_table */
+   uint32_t blocks;                   /* blocks malloced */
+   uint64_t probes;                   /* statistics: slots probed */
+   uint64_t searches;                 /* statistics: lookups done */
+   struct h_mem *mem_block;           /* malloc'ed memory block chain */
+   void malloc_big_buf(int size);     /* Get a big buffer */
+   void grow_table();                 /* start an incremental grow */
+   void migrate(uint32_t count);      /* move count old slots to table */
+   void put(ohslot *slot);            /* store slot without lookup */
+   ohslot *find(ohslot *tbl, uint32_t tmask, uint64_t hash,
+                key_type_t type, union hlink_key *key);
+   void *search(uint64_t hash, key_type_t type, union hlink_key *key);
+   bool add(uint64_t hash, key_type_t type, union hlink_key *key, void *item);
+
+public:
+   ohtable(int tsize = 31, int nr_pages = 0);
+   ~ohtable() { destroy(); }
+   void init(int tsize = 31, int nr_pages = 0);
+   bool insert(char *key, void *item);
+   bool insert(uint32_t key, void *item);
+   bool insert(uint64_t key, void *item);
+   void *lookup(char *key);
+   void *lookup(uint32_t key);
+   void *lookup(uint64_t key);
+   void *first();                     /* get first item in table */
+   void *next();                      /* get next item in table */
+   void destroy();
+   void stats();                      /* print stats about the table */
+   uint32_t size();                   /* return size of table */
+   char *hash_malloc(int size);       /* malloc bytes for a hash entry */
+   void hash_big_free();              /* free all hash allocated big buffers */
+};
+
+#endif  /* OHTABLE_H */
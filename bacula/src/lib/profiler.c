@@ -0,0 +1,378 @@
+/*
+   Bacula® - The Network Backup Solution
+
+   Copyright (C) 2014-2014 Free Software Foundation Europe e.V.
+
+   The main author of Bacula is Kern Sibbald, with contributions from many
+   others, a complete list can be found in the file AUTHORS.
+
+   You may use this file and others of this release according to the
+   license defined in the LICENSE file, which includes the Affero General
+   Public License, v3.0 ("AGPLv3") and some additional permissions and
+   terms pursuant to its AGPLv3 Section 7.
+
+   Bacula® is a registered trademark of Kern Sibbald.
+*/
+/*
+ * Sampling profiler, started and stopped with the ".profile" console
+ *  command, in the Director, the Storage daemon or the File daemon.
+ *
+ * While it runs, the process CPU timer (ITIMER_PROF) sends a SIGPROF
+ *  to the thread that is using the CPU, "hz" times per second of CPU.
+ *  The signal handler records the program counter of the interrupted
+ *  code, taken from the signal context, and the JobId found in the
+ *  TSD of the thread into a preallocated array.  Unwinding the stack
+ *  with backtrace() is not async-signal-safe, so the handler does not
+ *  do it: it takes no lock, does not allocate memory and calls
+ *  nothing but atomic builtins.  A JobId can be given to keep only
+ *  the samples of one Job.
+ *
+ * When the profiler is stopped, the program counters are symbolized
+ *  and written in the "folded" format used by the flame graph tools,
+ *  one line per distinct function with its number of samples:
+ *
+ *    JobId=12;Thread=7f3a...;compress_data 154
+ *
+ *  in <working directory>/<daemon name>.profile.
+ *
+ * The handler is installed with SA_RESTART, so most interrupted
+ *  system calls are restarted.  Calls that are never restarted after
+ *  a signal handler (select(), poll(), nanosleep(), socket calls with
+ *  a timeout) may still fail with EINTR while the profiler runs, the
+ *  daemon I/O loops retry on EINTR as they do for the other signals.
+ */
+
+#include "bacula.h"
+#include "jcr.h"
+
+#if defined(HAVE_BACKTRACE) && defined(HAVE_GCC) && !defined(HAVE_WIN32)
+#include <ucontext.h>
+
+/* Program counter of the code interrupted by a signal */
+#if defined(HAVE_LINUX_OS) && defined(__x86_64__)
+#define PROF_UCONTEXT_PC(uc) ((void *)(uc)->uc_mcontext.gregs[REG_RIP])
+#elif defined(HAVE_LINUX_OS) && defined(__i386__)
+#define PROF_UCONTEXT_PC(uc) ((void *)(uc)->uc_mcontext.gregs[REG_EIP])
+#elif defined(HAVE_LINUX_OS) && defined(__aarch64__)
+#define PROF_UCONTEXT_PC(uc) ((void *)(uc)->uc_mcontext.pc)
+#elif defined(HAVE_FREEBSD_OS) && defined(__x86_64__)
+#define PROF_UCONTEXT_PC(uc) ((void *)(uc)->uc_mcontext.mc_rip)
+#elif defined(HAVE_DARWIN_OS) && defined(__x86_64__)
+#define PROF_UCONTEXT_PC(uc) ((void *)(uc)->uc_mcontext->__ss.__rip)
+#endif
+#endif
+
+#ifdef PROF_UCONTEXT_PC
+#include <cxxabi.h>
+#include <execinfo.h>
+#include <sys/time.h>
+
+static const int dbglvl = 100;
+
+#define PROF_MAX_SAMPLES  16384       /* samples kept per run */
+#define PROF_DEFAULT_HZ   99          /* not a multiple of common timers */
+
+struct PROF_SAMPLE {
+   uint32_t JobId;
+   pthread_t thread;
+   void * volatile pc;                /* set last, NULL while being written */
+};
+
+/* One line of the output */
+struct PROF_STACK {
+   hlink link;
+   uint32_t count;
+   char key[1];
+};
+
+static pthread_mutex_t prof_mutex = PTHREAD_MUTEX_INITIALIZER;
+static PROF_SAMPLE *prof_samples = NULL;
+static volatile int32_t prof_next = 0;    /* next free sample */
+static volatile int32_t prof_in_handler = 0; /* handlers running */
+static volatile bool prof_running = false;
+static uint32_t prof_jobid = 0;           /* only this Job if set */
+static int prof_hz = 0;
+static time_t prof_start_time = 0;
+
+/*
+ * profiler_stop() clears prof_running, then waits for prof_in_handler
+ *  to drop to zero before it reads and frees the samples.
+ */
+static void profiler_handler(int sig, siginfo_t *info, void *context)
+{
+   int save_errno = errno;
+   uint32_t JobId;
+   int32_t idx;
+
+   __sync_fetch_and_add(&prof_in_handler, 1);
+   if (!prof_running) {
+      goto bail_out;
+   }
+   JobId = get_jobid_from_tsd();
+   if (prof_jobid && JobId != prof_jobid) {
+      goto bail_out;
+   }
+   idx = __sync_fetch_and_add(&prof_next, 1);
+   if (idx < PROF_MAX_SAMPLES) {
+      PROF_SAMPLE *s = &prof_samples[idx];
+      s->JobId = JobId;
+      s->thread = pthread_self();
+      __sync_synchronize();
+      s->pc = PROF_UCONTEXT_PC((ucontext_t *)context);
+   }
+bail_out:
+   __sync_fetch_and_sub(&prof_in_handler, 1);
+   errno = save_errno;
+}
+
+/*
+ * Name of a program counter, "function" when the symbol is known,
+ *  otherwise "binary+offset" that addr2line can resolve.
+ */
+static void frame_name(char *sym, POOL_MEM &name)
+{
+   char *begin = NULL, *end = NULL, *p;
+   char *demangled;
+   int status;
+
+   for (p = sym; *p; p++) {
+      if (*p == '(') {
+         begin = p;
+      } else if (*p == '+' && begin && !end) {
+         end = p;
+      }
+   }
+   if (!begin || !end || end == begin + 1) {
+      /* No symbol, keep the binary and the offset */
+      p = strrchr(sym, '/');
+      pm_strcpy(name, p ? p + 1 : sym);
+      if ((p = strchr(name.c_str(), ' ')) != NULL) {
+         *p = 0;
+      }
+      return;
+   }
+   *end = 0;
+   demangled = abi::__cxa_demangle(begin + 1, NULL, NULL, &status);
+   if (demangled) {
+      /* Drop the arguments, they would only split the stacks */
+      if ((p = strchr(demangled, '(')) != NULL) {
+         *p = 0;
+      }
+      pm_strcpy(name, demangled);
+      actuallyfree(demangled);
+   } else {
+      pm_strcpy(name, begin + 1);
+   }
+   *end = '+';
+   /* Spaces and semicolons are separators in the folded format */
+   for (p = name.c_str(); *p; p++) {
+      if (*p == ' ' || *p == ';') {
+         *p = '_';
+      }
+   }
+}
+
+static bool profiler_start(int hz, uint32_t JobId, POOLMEM *&msg)
+{
+   struct sigaction sigprof;
+   struct itimerval timer;
+
+   P(prof_mutex);
+   if (prof_running) {
+      V(prof_mutex);
+      Mmsg(msg, _("2999 Profiler already running.\n"));
+      return false;
+   }
+   if (hz <= 0 || hz > 1000) {
+      hz = PROF_DEFAULT_HZ;
+   }
+   if (!prof_samples) {
+      prof_samples = (PROF_SAMPLE *)malloc(PROF_MAX_SAMPLES * sizeof(PROF_SAMPLE));
+   }
+   memset(prof_samples, 0, PROF_MAX_SAMPLES * sizeof(PROF_SAMPLE));
+   prof_next = 0;
+   prof_jobid = JobId;
+   prof_hz = hz;
+   prof_start_time = time(NULL);
+
+   memset(&sigprof, 0, sizeof(sigprof));
+   sigprof.sa_sigaction = profiler_handler;
+   sigprof.sa_flags = SA_SIGINFO | SA_RESTART;   /* see EINTR above */
+   sigemptyset(&sigprof.sa_mask);
+   sigaction(SIGPROF, &sigprof, NULL);
+
+   prof_running = true;
+   timer.it_interval.tv_sec = 0;
+   timer.it_interval.tv_usec = 1000000 / hz;
+   timer.it_value = timer.it_interval;
+   if (setitimer(ITIMER_PROF, &timer, NULL) != 0) {
+      berrno be;
+      prof_running = false;
+      V(prof_mutex);
+      Mmsg(msg, _("2999 Cannot start profiler: ERR=%s\n"), be.bstrerror());
+      return false;
+   }
+   V(prof_mutex);
+   Dmsg2(dbglvl, "Profiler started hz=%d JobId=%u\n", hz, JobId);
+   Mmsg(msg, _("2000 OK profile started hz=%d jobid=%u\n"), hz, JobId);
+   return true;
+}
+
+/* Fold the samples by stack and write them.  Needs prof_mutex */
+static bool write_profile(const char *fname, int32_t nr_samples, POOLMEM *&msg)
+{
+   htable *stacks;
+   PROF_STACK *stack = NULL;
+   POOL_MEM key(PM_MESSAGE), name(PM_NAME);
+   char ed1[50];
+   int nr_stacks = 0;
+   FILE *fp;
+
+   if ((fp = fopen(fname, "w")) == NULL) {
+      berrno be;
+      Mmsg(msg, _("2999 Cannot open %s: ERR=%s\n"), fname, be.bstrerror());
+      return false;
+   }
+   stacks = (htable *)malloc(sizeof(htable));
+   stacks->init(stack, &stack->link, 1000);
+   for (int32_t i=0; i < nr_samples; i++) {
+      PROF_SAMPLE *s = &prof_samples[i];
+      void *pc = s->pc;
+      char **syms;
+
+      if (!pc) {
+         continue;
+      }
+      if ((syms = backtrace_symbols(&pc, 1)) == NULL) {
+         continue;
+      }
+      frame_name(syms[0], name);
+      actuallyfree(syms);
+      Mmsg(key, "JobId=%u;Thread=%llx;%s", s->JobId,
+           (unsigned long long)(intptr_t)s->thread, name.c_str());
+
+      stack = (PROF_STACK *)stacks->lookup(key.c_str());
+      if (!stack) {
+         int len = strlen(key.c_str());
+         stack = (PROF_STACK *)stacks->hash_malloc(sizeof(PROF_STACK) + len);
+         memcpy(stack->key, key.c_str(), len + 1);
+         stack->count = 0;
+         stacks->insert(stack->key, stack);
+         nr_stacks++;
+      }
+      stack->count++;
+   }
+   foreach_htable(stack, stacks) {
+      fprintf(fp, "%s %u\n", stack->key, stack->count);
+   }
+   stacks->destroy();
+   free(stacks);
+   fclose(fp);
+   Mmsg(msg, _("2000 OK profile stopped samples=%s stacks=%d file=%s\n"),
+        edit_uint64_with_commas(nr_samples, ed1), nr_stacks, fname);
+   return true;
+}
+
+static bool profiler_stop(POOLMEM *&msg)
+{
+   struct sigaction sigignore;
+   struct itimerval timer;
+   POOL_MEM fname(PM_FNAME);
+   int32_t nr_samples;
+   bool ok;
+
+   P(prof_mutex);
+   if (!prof_running) {
+      V(prof_mutex);
+      Mmsg(msg, _("2999 Profiler not running.\n"));
+      return false;
+   }
+   memset(&timer, 0, sizeof(timer));
+   setitimer(ITIMER_PROF, &timer, NULL);
+   prof_running = false;
+   memset(&sigignore, 0, sizeof(sigignore));
+   sigignore.sa_handler = SIG_IGN;
+   sigemptyset(&sigignore.sa_mask);
+   sigaction(SIGPROF, &sigignore, NULL);
+   __sync_synchronize();
+   while (prof_in_handler > 0) {      /* let a running handler finish */
+      bmicrosleep(0, 1000);
+   }
+
+   nr_samples = MIN(prof_next, PROF_MAX_SAMPLES);
+   Mmsg(fname, "%s/%s.profile", working_directory ? working_directory : ".", my_name);
+   ok = write_profile(fname.c_str(), nr_samples, msg);
+   free(prof_samples);
+   prof_samples = NULL;
+   V(prof_mutex);
+   Dmsg1(dbglvl, "Profiler stopped: %s", msg);
+   return ok;
+}
+
+static void profiler_status(POOLMEM *&msg)
+{
+   char ed1[50], ed2[50], ed3[50];
+   int32_t next;
+
+   P(prof_mutex);
+   if (!prof_running) {
+      Mmsg(msg, _("2000 OK profile not running\n"));
+   } else {
+      next = prof_next;
+      Mmsg(msg, _("2000 OK profile running hz=%d jobid=%u since=%s samples=%s dropped=%s\n"),
+           prof_hz, prof_jobid, bstrftimes(ed1, sizeof(ed1), prof_start_time),
+           edit_uint64_with_commas(MIN(next, PROF_MAX_SAMPLES), ed2),
+           edit_uint64_with_commas(MAX(next - PROF_MAX_SAMPLES, 0), ed3));
+   }
+   V(prof_mutex);
+}
+
+#else
+
+static bool profiler_start(int hz, uint32_t JobId, POOLMEM *&msg)
+{
+   Mmsg(msg, _("2999 Profiler not available on this platform.\n"));
+   return false;
+}
+
+static bool profiler_stop(POOLMEM *&msg)
+{
+   return profiler_start(0, 0, msg);
+}
+
+static void profiler_status(POOLMEM *&msg)
+{
+   profiler_start(0, 0, msg);
+}
+
+#endif
+
+/*
+ * Handle "profile start [hz=<n>] [jobid=<n>]", "profile stop" and
+ *  "profile status", the answer for the Director is put in msg.
+ */
+bool profiler_command(const char *cmd, POOLMEM *&msg)
+{
+   const char *p;
+   int hz = 0;
+   uint32_t JobId = 0;
+
+   if (strncmp(cmd, "profile start", 13) == 0) {
+      if ((p = strstr(cmd, "hz=")) != NULL) {
+         hz = str_to_int64((char *)p + 3);
+      }
+      if ((p = strstr(cmd, "jobid=")) != NULL) {
+         JobId = str_to_int64((char *)p + 6);
+      }
+      return profiler_start(hz, JobId, msg);
+   }
+   if (strncmp(cmd, "profile stop", 12) == 0) {
+      return profiler_stop(msg);
+   }
+   if (strncmp(cmd, "profile status", 14) == 0) {
+      profiler_status(msg);
+      return true;
+   }
+   Mmsg(msg, _("2999 Bad profile command: %s\n"), cmd);
+   return false;
+}
@@ -79,6 +79,16 @@ int       Zinflate(char *in, int in_len, char *out, int &out_len);
 void      stack_trace();
 int       safer_unlink(const char *pathname, const char *regex);
 
+/* profiler.c */
+bool       profiler_command      (const char *cmd, POOLMEM *&msg);
+
+/* bwsched.c */
+void       bw_sched_init         (int64_t rate);
+void       bw_sched_set_weight   (int bwclass, uint32_t weight);
+int        bw_class_of_job       (int JobType);
+void       bw_sched_account      (int bwclass, int bytes);
+int        edit_bw_sched_status  (POOLMEM *&buf);
+
 /* bnet.c */
 bool       bnet_tls_server       (TLS_CONTEXT *ctx, BSOCK *bsock,
                                   alist *verify_list);
@@ -141,6 +151,15 @@ CIPHER_CONTEXT *   crypto_cipher_new           (CRYPTO_SESSION *cs, bool encrypt
 bool               crypto_cipher_update        (CIPHER_CONTEXT *cipher_ctx, const uint8_t *data, uint32_t length, const uint8_t *dest, uint32_t *written);
 bool               crypto_cipher_finalize      (CIPHER_CONTEXT *cipher_ctx, uint8_t *dest, uint32_t *written);
 void               crypto_cipher_free          (CIPHER_CONTEXT *cipher_ctx);
+bool               crypto_cipher_is_aead       (CIPHER_CONTEXT *cipher_ctx);
+bool               crypto_cipher_seal          (CIPHER_CONTEXT *cipher_ctx, uint64_t nonce,
+                                                const uint8_t *aad, uint32_t aad_len,
+                                                const uint8_t *data, uint32_t length,
+                                                uint8_t *dest, uint32_t *written);
+bool               crypto_cipher_open          (CIPHER_CONTEXT *cipher_ctx, uint64_t nonce,
+                                                const uint8_t *aad, uint32_t aad_len,
+                                                const uint8_t *data, uint32_t length,
+                                                uint8_t *dest, uint32_t *written);
 X509_KEYPAIR *     crypto_keypair_new          (void);
 X509_KEYPAIR *     crypto_keypair_dup          (X509_KEYPAIR *keypair);
 int                crypto_keypair_load_cert    (X509_KEYPAIR *keypair, const char *file);
@@ -230,6 +249,10 @@ int        get_hangup            (void);
 void       set_db_type           (const char *name);
 void       set_assert_msg        (const char *file, int line, const char *msg);
 void       register_message_callback(void msg_callback(int type, char *msg));
+void       start_message_delivery(void);
+void       stop_message_delivery(void);
+void       wait_message_delivery(JCR *jcr);
+int        edit_message_delivery_status(POOLMEM *&buf);
 
 /* bnet_server.c */
 void       bnet_thread_server(dlist *addr_list, int max_clients, workq_t *client_wq,
@@ -247,6 +270,10 @@ int generate_daemon_event(JCR *jcr, const char *event);
 void             init_signals             (void terminate(int sig));
 void             init_stack_dump          (void);
 
+/* ohtable.c */
+uint64_t  hash_string            (const char *key);
+uint64_t  hash_uint64            (uint64_t key);
+
 /* scan.c */
 void             strip_leading_space     (char *str);
 void             strip_trailing_junk     (char *str);
@@ -276,6 +303,7 @@ TLS_CONTEXT      *new_tls_context        (const char *ca_certfile,
                                           const char *dhfile,
                                           bool verify_peer);
 void             free_tls_context        (TLS_CONTEXT *ctx);
+void             set_tls_kernel_offload  (bool enable);
 #ifdef HAVE_TLS
 bool             tls_postconnect_verify_host(JCR *jcr, TLS_CONNECTION *tls,
                                                const char *host);
@@ -285,6 +313,7 @@ TLS_CONNECTION   *new_tls_connection     (TLS_CONTEXT *ctx, int fd);
 bool             tls_bsock_accept        (BSOCK *bsock);
 int              tls_bsock_writen        (BSOCK *bsock, char *ptr, int32_t nbytes);
 int              tls_bsock_readn         (BSOCK *bsock, char *ptr, int32_t nbytes);
+bool             tls_bsock_kernel_send   (BSOCK *bsock);
 #endif /* HAVE_TLS */
 bool             tls_bsock_connect       (BSOCK *bsock);
 void             tls_bsock_shutdown      (BSOCK *bsock);
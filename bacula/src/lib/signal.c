@@ -134,6 +134,10 @@ extern "C" void signal_handler(int sig)
    if (sig == SIGCHLD || sig == SIGUSR2) {
       return;
    }
+   /* With the lock manager, SIGUSR1 dumps the lock contention statistics */
+   if (sig == SIGUSR1 && lmgr_request_contention_dump()) {
+      return;
+   }
    /* FreeBSD seems to generate a signal of 0, which is of course undefined */
    if (sig == 0) {
       return;
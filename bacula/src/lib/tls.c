@@ -56,8 +56,27 @@ struct TLS_Context {
 
 struct TLS_Connection {
    SSL *openssl;
+   bool ktls_send;                    /* kernel encrypts what we write */
 };
 
+/* Set by the daemons from the "TLS Kernel Offload" directive */
+static bool tls_kernel_offload = false;
+
+/*
+ * Ask for the Linux kernel TLS offload in the contexts created after
+ *  this call.  Without OpenSSL kTLS support, this is a no-op.
+ */
+void set_tls_kernel_offload(bool enable)
+{
+#ifdef SSL_OP_ENABLE_KTLS
+   tls_kernel_offload = enable;
+#else
+   if (enable) {
+      Jmsg0(NULL, M_WARNING, 0, _("TLS Kernel Offload requested, but OpenSSL has no kTLS support.\n"));
+   }
+#endif
+}
+
 /*
  * OpenSSL certificate verification callback.
  * OpenSSL has already performed internal certificate verification.
@@ -108,8 +127,24 @@ TLS_CONTEXT *new_tls_context(const char *ca_certfile, const char *ca_certdir,
 
    ctx = (TLS_CONTEXT *)malloc(sizeof(TLS_CONTEXT));
 
+#ifdef SSL_OP_ENABLE_KTLS
+   /*
+    * The kernel only does TLSv1.2 and later, so let OpenSSL negotiate
+    *  the best version with the peer.  Older peers still get TLSv1.
+    */
+   if (tls_kernel_offload) {
+      ctx->openssl = SSL_CTX_new(TLS_method());
+      if (ctx->openssl) {
+         SSL_CTX_set_min_proto_version(ctx->openssl, TLS1_VERSION);
+         SSL_CTX_set_options(ctx->openssl, SSL_OP_ENABLE_KTLS);
+      }
+   } else {
+      ctx->openssl = SSL_CTX_new(TLSv1_method());
+   }
+#else
    /* Allocate our OpenSSL TLSv1 Context */
    ctx->openssl = SSL_CTX_new(TLSv1_method());
+#endif
 
    if (!ctx->openssl) {
       openssl_post_errors(M_FATAL, _("Error initializing SSL context"));
@@ -430,6 +465,7 @@ TLS_CONNECTION *new_tls_connection(TLS_CONTEXT *ctx, int fd)
 
    /* Allocate our new tls connection */
    TLS_CONNECTION *tls = (TLS_CONNECTION *)malloc(sizeof(TLS_CONNECTION));
+   tls->ktls_send = false;
 
    /* Create the SSL object and attach the socket BIO */
    if ((tls->openssl = SSL_new(ctx->openssl)) == NULL) {
@@ -494,6 +530,19 @@ static inline bool openssl_bsock_session_start(BSOCK *bsock, bool server)
       /* Handle errors */
       switch (SSL_get_error(tls->openssl, err)) {
       case SSL_ERROR_NONE:
+#ifdef SSL_OP_ENABLE_KTLS
+         /*
+          * If OpenSSL pushed the session keys into the socket, our
+          *  writes can bypass SSL_write().  Reads still go through
+          *  SSL_read() so that the control records (alerts, session
+          *  tickets, ...) are handled, but the data is decrypted by
+          *  the kernel.
+          */
+         tls->ktls_send = BIO_get_ktls_send(SSL_get_wbio(tls->openssl)) == 1;
+         Dmsg3(100, "TLS %s established, kernel send=%d recv=%d\n",
+               SSL_get_version(tls->openssl), tls->ktls_send,
+               BIO_get_ktls_recv(SSL_get_rbio(tls->openssl)) == 1);
+#endif
          stat = true;
          goto cleanup;
       case SSL_ERROR_ZERO_RETURN:
@@ -712,6 +761,15 @@ cleanup:
 }
 
 
+/*
+ * Returns true if the data written to the socket is encrypted by
+ *  the kernel, write_nbytes() can then use plain write() calls.
+ */
+bool tls_bsock_kernel_send(BSOCK *bsock)
+{
+   return bsock->tls->ktls_send;
+}
+
 int tls_bsock_writen(BSOCK *bsock, char *ptr, int32_t nbytes)
 {
    /* SSL_write(bsock->tls->openssl, ptr, nbytes) */
@@ -733,6 +791,8 @@ int tls_bsock_readn(BSOCK *bsock, char *ptr, int32_t nbytes)
 
 
 /* Dummy routines */
+void set_tls_kernel_offload(bool enable) { }
+
 TLS_CONTEXT *new_tls_context(const char *ca_certfile, const char *ca_certdir,
                              const char *certfile, const char *keyfile,
                              CRYPTO_PEM_PASSWD_CB *pem_callback,
@@ -476,6 +476,7 @@ bool release_device(DCR *dcr)
    char tbuf[100];
    int was_blocked = BST_NOT_BLOCKED;
 
+   free_volume_prefetch(dcr);          /* release any spare drive */
 
    dev->Lock();
    if (!dev->is_blocked()) {
@@ -757,6 +758,7 @@ void free_dcr(DCR *dcr)
 
    jcr = dcr->jcr;
 
+   free_volume_prefetch(dcr);
    if (dcr->dev) {
       dcr->dev->detach_dcr_from_dev(dcr);
    }
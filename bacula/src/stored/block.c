@@ -90,6 +90,9 @@ bail_out:
    if (!dcr->is_dev_locked()) {        /* did we lock dev above? */
       /* note, do not change this to dcr->dunlock */
       dev->Unlock();                  /* unlock it now */
+      if (stat) {
+         check_volume_prefetch(dcr);  /* next Volume in a spare drive? */
+      }
    }
    return stat;
 }
@@ -323,6 +326,9 @@ bool DCR::write_block_to_dev()
       dcr->VolLastIndex = block->LastIndex;
    }
    dcr->WroteVol = true;
+   if (!dev->is_tape()) {
+      write_block_index(dcr, block, dev->file_addr, wlen);
+   }
    dev->file_addr += wlen;            /* update file address */
    dev->file_size += wlen;
    dev->part_size += wlen;
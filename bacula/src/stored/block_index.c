@@ -0,0 +1,448 @@
+/*
+   Bacula® - The Network Backup Solution
+
+   Copyright (C) 2014-2014 Free Software Foundation Europe e.V.
+
+   The main author of Bacula is Kern Sibbald, with contributions from many
+   others, a complete list can be found in the file AUTHORS.
+
+   You may use this file and others of this release according to the
+   license defined in the LICENSE file, which includes the Affero General
+   Public License, v3.0 ("AGPLv3") and some additional permissions and
+   terms pursuant to its AGPLv3 Section 7.
+
+   Bacula® is a registered trademark of Kern Sibbald.
+*/
+/*
+ *
+ *   block_index.c  -- block index sidecar for File volumes
+ *
+ *  When "Block Index = yes" is set on a File device, every block
+ *   written to a Volume is also described in a small file next to
+ *   it (<Volume>.bidx) giving its address, length, session and
+ *   FileIndex range.  On read, the index lets read_records() seek
+ *   directly to the next block wanted by the bsr instead of
+ *   reading and discarding the blocks of other interleaved jobs.
+ *
+ *  The index is only trusted from the start of the Volume up to
+ *   the first gap, so a Volume written partly without the index
+ *   (or a crash between a block write and its index entry) simply
+ *   makes the reader fall back to reading the rest sequentially.
+ */
+
+#include "bacula.h"
+#include "stored.h"
+
+static const int dbglvl = 150;
+
+static const char bidx_id[] = "BaculaBidx1";
+
+#define BIDX_HDR_LENGTH   (12 + MAX_NAME_LENGTH + 8)
+#define BIDX_ENTRY_LENGTH 32
+
+/* One block of the Volume */
+struct BIDX_ENTRY {
+   uint64_t addr;                     /* address of block on Volume */
+   uint32_t len;                      /* block length */
+   uint32_t VolSessionId;
+   uint32_t VolSessionTime;
+   int32_t  FirstIndex;               /* first FileIndex in block, 0 if labels only */
+   int32_t  LastIndex;                /* last FileIndex in block */
+};
+
+struct BLOCK_INDEX {
+   int fd;                            /* writer fd, -1 if not open */
+   bool disabled;                     /* Volume cannot be indexed by writer */
+   bool loaded;                       /* reader has loaded the index */
+   uint64_t next_addr;                /* writer: expected address of next block */
+   int32_t num_entries;               /* reader: entries in memory */
+   BIDX_ENTRY *entries;               /* reader: contiguous entries */
+   uint64_t end_addr;                 /* reader: first address not covered */
+   char VolumeName[MAX_NAME_LENGTH];  /* reader: Volume the entries describe */
+   BSR *cur_root;                     /* reader: bsr list of the cursor */
+   uint32_t cur_JobId;                /* reader: Job of the cursor */
+   uint64_t cur_addr;                 /* reader: cursor, no block wanted from */
+   uint64_t cur_next;                 /*   cur_addr up to cur_next */
+};
+
+/*
+ * Build the sidecar name from the Volume name, the same way
+ *  open_file_device() builds the Volume name.
+ */
+static void make_block_index_name(DEVICE *dev, POOL_MEM &fname)
+{
+   DEVRES *device = dev->device;
+
+   pm_strcpy(fname, dev->dev_name);
+   if (!device->changer_res || device->changer_command[0] == 0 ||
+        strcmp(device->changer_command, "/dev/null") == 0) {
+      if (!IsPathSeparator(fname.c_str()[strlen(fname.c_str())-1])) {
+         pm_strcat(fname, "/");
+      }
+      pm_strcat(fname, dev->VolHdr.VolumeName);
+   }
+   pm_strcat(fname, ".bidx");
+}
+
+static void ser_bidx_header(DEVICE *dev, char *buf)
+{
+   ser_declare;
+
+   memset(buf, 0, BIDX_HDR_LENGTH);
+   ser_begin(buf, BIDX_HDR_LENGTH);
+   ser_bytes(bidx_id, sizeof(bidx_id));
+   ser_bytes(dev->VolHdr.VolumeName, MAX_NAME_LENGTH);
+   ser_btime(dev->VolHdr.label_btime);
+   ser_end(buf, BIDX_HDR_LENGTH);
+}
+
+static BLOCK_INDEX *get_block_index(DEVICE *dev)
+{
+   if (!dev->bidx) {
+      dev->bidx = (BLOCK_INDEX *)malloc(sizeof(BLOCK_INDEX));
+      memset(dev->bidx, 0, sizeof(BLOCK_INDEX));
+      dev->bidx->fd = -1;
+   }
+   return dev->bidx;
+}
+
+/*
+ * Open the index for append.  An index whose header does not
+ *  match the mounted Volume is only reset when the Volume is
+ *  being (re)written from its start.
+ */
+static bool open_block_index_for_append(DCR *dcr, BLOCK_INDEX *bidx, uint64_t addr)
+{
+   DEVICE *dev = dcr->dev;
+   POOL_MEM fname(PM_FNAME);
+   char hdr[BIDX_HDR_LENGTH], vhdr[BIDX_HDR_LENGTH];
+   char ebuf[BIDX_ENTRY_LENGTH];
+   struct stat st;
+   bool match = false;
+
+   make_block_index_name(dev, fname);
+   bidx->fd = ::open(fname.c_str(), O_RDWR|O_CREAT|O_BINARY, 0640);
+   if (bidx->fd < 0) {
+      berrno be;
+      Jmsg2(dcr->jcr, M_WARNING, 0, _("Could not open block index %s: ERR=%s\n"),
+            fname.c_str(), be.bstrerror());
+      return false;
+   }
+   ser_bidx_header(dev, vhdr);
+   if (fstat(bidx->fd, &st) == 0 && st.st_size >= BIDX_HDR_LENGTH &&
+       read(bidx->fd, hdr, BIDX_HDR_LENGTH) == BIDX_HDR_LENGTH) {
+      match = memcmp(hdr, vhdr, BIDX_HDR_LENGTH) == 0;
+   }
+
+   if (addr == 0 || !match) {
+      if (addr != 0) {
+         Dmsg2(dbglvl, "Block index %s does not cover Volume at %lld, not indexing\n",
+               fname.c_str(), addr);
+         return false;
+      }
+      if (ftruncate(bidx->fd, 0) != 0 ||
+          lseek(bidx->fd, 0, SEEK_SET) != 0 ||
+          write(bidx->fd, vhdr, BIDX_HDR_LENGTH) != BIDX_HDR_LENGTH) {
+         berrno be;
+         Jmsg2(dcr->jcr, M_WARNING, 0, _("Could not reset block index %s: ERR=%s\n"),
+               fname.c_str(), be.bstrerror());
+         return false;
+      }
+      bidx->next_addr = 0;
+      return true;
+   }
+
+   /* Drop any partial entry then pick up where the last block ended */
+   boffset_t len = st.st_size - ((st.st_size - BIDX_HDR_LENGTH) % BIDX_ENTRY_LENGTH);
+   bidx->next_addr = 0;
+   if (len > BIDX_HDR_LENGTH) {
+      ser_declare;
+      uint64_t eaddr;
+      uint32_t elen;
+
+      if (pread(bidx->fd, ebuf, BIDX_ENTRY_LENGTH, len - BIDX_ENTRY_LENGTH) != BIDX_ENTRY_LENGTH) {
+         return false;
+      }
+      unser_begin(ebuf, BIDX_ENTRY_LENGTH);
+      unser_uint64(eaddr);
+      unser_uint32(elen);
+      bidx->next_addr = eaddr + elen;
+   }
+   if (ftruncate(bidx->fd, len) != 0 || lseek(bidx->fd, len, SEEK_SET) != len) {
+      return false;
+   }
+   Dmsg2(dbglvl, "Append to block index %s next_addr=%lld\n", fname.c_str(),
+         bidx->next_addr);
+   return true;
+}
+
+/*
+ * Record a block just written at addr.  Called from
+ *  write_block_to_dev() for File devices.
+ */
+void write_block_index(DCR *dcr, DEV_BLOCK *block, uint64_t addr, uint32_t len)
+{
+   DEVICE *dev = dcr->dev;
+   BLOCK_INDEX *bidx;
+   char buf[BIDX_ENTRY_LENGTH];
+   ser_declare;
+
+   if (!dev->has_cap(CAP_BLOCKINDEX) || !dev->is_file()) {
+      return;
+   }
+   bidx = get_block_index(dev);
+   if (addr == 0) {
+      /* Volume is being (re)labeled, start over */
+      if (bidx->fd >= 0) {
+         ::close(bidx->fd);
+         bidx->fd = -1;
+      }
+      bidx->disabled = false;
+   }
+   if (bidx->disabled) {
+      return;
+   }
+   if (bidx->fd < 0 && !open_block_index_for_append(dcr, bidx, addr)) {
+      goto bail_out;
+   }
+   if (addr != bidx->next_addr) {
+      /*
+       * A block went by without the index, stop here.  If the Volume
+       *  was cut back, entries past addr describe stale data, so
+       *  keep none of them.
+       */
+      Dmsg2(dbglvl, "Block index gap addr=%lld expected=%lld\n", addr, bidx->next_addr);
+      if (addr < bidx->next_addr && ftruncate(bidx->fd, BIDX_HDR_LENGTH) != 0) {
+         POOL_MEM fname(PM_FNAME);
+         ::close(bidx->fd);
+         bidx->fd = -1;
+         make_block_index_name(dev, fname);
+         unlink(fname.c_str());
+      }
+      goto bail_out;
+   }
+
+   memset(buf, 0, sizeof(buf));
+   ser_begin(buf, BIDX_ENTRY_LENGTH);
+   ser_uint64(addr);
+   ser_uint32(len);
+   ser_uint32(block->VolSessionId);
+   ser_uint32(block->VolSessionTime);
+   ser_int32(block->FirstIndex);
+   ser_int32(block->LastIndex);
+   if (write(bidx->fd, buf, BIDX_ENTRY_LENGTH) != BIDX_ENTRY_LENGTH) {
+      berrno be;
+      Jmsg1(dcr->jcr, M_WARNING, 0, _("Block index write error: ERR=%s\n"),
+            be.bstrerror());
+      goto bail_out;
+   }
+   bidx->next_addr = addr + len;
+   return;
+
+bail_out:
+   if (bidx->fd >= 0) {
+      ::close(bidx->fd);
+      bidx->fd = -1;
+   }
+   bidx->disabled = true;
+}
+
+/*
+ * Load the index of the mounted Volume into memory, keeping
+ *  only the run of contiguous entries from the start.
+ */
+static void load_block_index(DCR *dcr, BLOCK_INDEX *bidx)
+{
+   DEVICE *dev = dcr->dev;
+   POOL_MEM fname(PM_FNAME);
+   char hdr[BIDX_HDR_LENGTH], vhdr[BIDX_HDR_LENGTH];
+   char buf[BIDX_ENTRY_LENGTH];
+   struct stat st;
+   FILE *fp;
+   int32_t max;
+   uint64_t next = 0;
+
+   if (bidx->entries) {
+      free(bidx->entries);
+      bidx->entries = NULL;
+   }
+   bidx->num_entries = 0;
+   bidx->end_addr = 0;
+   bidx->cur_root = NULL;
+   bidx->loaded = true;
+   bstrncpy(bidx->VolumeName, dev->VolHdr.VolumeName, sizeof(bidx->VolumeName));
+   make_block_index_name(dev, fname);
+   if ((fp = fopen(fname.c_str(), "rb")) == NULL) {
+      return;                         /* no index, read sequentially */
+   }
+   ser_bidx_header(dev, vhdr);
+   if (fstat(fileno(fp), &st) != 0 ||
+       fread(hdr, 1, BIDX_HDR_LENGTH, fp) != BIDX_HDR_LENGTH ||
+       memcmp(hdr, vhdr, BIDX_HDR_LENGTH) != 0) {
+      Dmsg1(dbglvl, "Block index %s does not match Volume, ignored\n", fname.c_str());
+      fclose(fp);
+      return;
+   }
+   max = (st.st_size - BIDX_HDR_LENGTH) / BIDX_ENTRY_LENGTH;
+   bidx->entries = (BIDX_ENTRY *)malloc(sizeof(BIDX_ENTRY) * (max + 1));
+   while (bidx->num_entries < max && fread(buf, 1, BIDX_ENTRY_LENGTH, fp) == BIDX_ENTRY_LENGTH) {
+      BIDX_ENTRY *e = &bidx->entries[bidx->num_entries];
+      ser_declare;
+
+      unser_begin(buf, BIDX_ENTRY_LENGTH);
+      unser_uint64(e->addr);
+      unser_uint32(e->len);
+      unser_uint32(e->VolSessionId);
+      unser_uint32(e->VolSessionTime);
+      unser_int32(e->FirstIndex);
+      unser_int32(e->LastIndex);
+      if (e->addr != next) {
+         break;                       /* gap, trust only what precedes */
+      }
+      next = e->addr + e->len;
+      bidx->num_entries++;
+   }
+   fclose(fp);
+   bidx->end_addr = next;
+   Dmsg3(dbglvl, "Loaded block index %s entries=%d end=%lld\n", fname.c_str(),
+         bidx->num_entries, bidx->end_addr);
+}
+
+/*
+ * Can the bsr want any record of this block?
+ */
+static bool bsr_wants_block(BSR *bsr, BIDX_ENTRY *e)
+{
+   BSR_SESSID *sid;
+   BSR_SESSTIME *stime;
+   BSR_FINDEX *fi;
+
+   for (stime=bsr->sesstime; stime; stime=stime->next) {
+      if (stime->sesstime == e->VolSessionTime) {
+         break;
+      }
+   }
+   if (!stime) {
+      return false;
+   }
+   for (sid=bsr->sessid; sid; sid=sid->next) {
+      if (e->VolSessionId >= sid->sessid && e->VolSessionId <= sid->sessid2) {
+         break;
+      }
+   }
+   if (!sid) {
+      return false;
+   }
+   if (e->LastIndex <= 0 || !bsr->FileIndex) {
+      return true;                    /* session labels or whole session */
+   }
+   for (fi=bsr->FileIndex; fi; fi=fi->next) {
+      if (fi->findex <= e->LastIndex && fi->findex2 >= e->FirstIndex) {
+         return true;
+      }
+   }
+   return false;
+}
+
+static bool bsr_is_for_volume(BSR *bsr, DEVICE *dev)
+{
+   for (BSR_VOLUME *vol=bsr->volume; vol; vol=vol->next) {
+      if (strcmp(vol->VolumeName, dev->VolHdr.VolumeName) == 0) {
+         return true;
+      }
+   }
+   return false;
+}
+
+/*
+ * Given the next address we would read, return the address of
+ *  the first block at or after it that any bsr still pending on
+ *  this Volume may want.  Returns addr itself if the index cannot
+ *  tell, so the caller keeps reading sequentially.
+ *
+ * The reader calls this for each record that does not match, so
+ *  the last answer is kept as a cursor: the blocks between the
+ *  address asked and the answer are not wanted, and stay so as
+ *  bsrs only get done.  The index is then scanned once per Volume.
+ */
+uint64_t block_index_next_addr(DCR *dcr, BSR *root, uint64_t addr)
+{
+   DEVICE *dev = dcr->dev;
+   BLOCK_INDEX *bidx;
+   BSR *bsr;
+   int32_t lo, hi;
+
+   if (!root || !dev->has_cap(CAP_BLOCKINDEX) || !dev->is_file()) {
+      return addr;
+   }
+   bidx = dev->bidx;
+   if (bidx && bidx->loaded && bidx->cur_root == root &&
+       bidx->cur_JobId == (uint32_t)dcr->jcr->JobId &&
+       addr >= bidx->cur_addr && addr <= bidx->cur_next &&
+       strcmp(bidx->VolumeName, dev->VolHdr.VolumeName) == 0) {
+      return bidx->cur_next;
+   }
+   /* Every pending bsr must be described by session, else no skipping */
+   for (bsr=root; bsr; bsr=bsr->next) {
+      if (!bsr->done && bsr_is_for_volume(bsr, dev) &&
+          (!bsr->sessid || !bsr->sesstime)) {
+         return addr;
+      }
+   }
+   bidx = get_block_index(dev);
+   if (!bidx->loaded || strcmp(bidx->VolumeName, dev->VolHdr.VolumeName) != 0) {
+      load_block_index(dcr, bidx);
+   }
+   if (bidx->num_entries == 0 || addr >= bidx->end_addr) {
+      return addr;
+   }
+
+   /* Binary search for the first block at or after addr */
+   lo = 0;
+   hi = bidx->num_entries;
+   while (lo < hi) {
+      int32_t mid = (lo + hi) / 2;
+      if (bidx->entries[mid].addr < addr) {
+         lo = mid + 1;
+      } else {
+         hi = mid;
+      }
+   }
+   bidx->cur_root = root;
+   bidx->cur_JobId = dcr->jcr->JobId;
+   bidx->cur_addr = addr;
+   for ( ; lo < bidx->num_entries; lo++) {
+      BIDX_ENTRY *e = &bidx->entries[lo];
+      for (bsr=root; bsr; bsr=bsr->next) {
+         if (!bsr->done && bsr_is_for_volume(bsr, dev) && bsr_wants_block(bsr, e)) {
+            Dmsg2(dbglvl, "Block index from %lld to %lld\n", addr, e->addr);
+            bidx->cur_next = e->addr;
+            return e->addr;
+         }
+      }
+   }
+   /* Nothing wanted in the indexed part, continue after it */
+   Dmsg2(dbglvl, "Block index from %lld to end %lld\n", addr, bidx->end_addr);
+   bidx->cur_next = bidx->end_addr;
+   return bidx->end_addr;
+}
+
+/*
+ * Release the index when the Volume is closed
+ */
+void close_block_index(DEVICE *dev)
+{
+   BLOCK_INDEX *bidx = dev->bidx;
+
+   if (!bidx) {
+      return;
+   }
+   if (bidx->fd >= 0) {
+      ::close(bidx->fd);
+   }
+   if (bidx->entries) {
+      free(bidx->entries);
+   }
+   free(bidx);
+   dev->bidx = NULL;
+}
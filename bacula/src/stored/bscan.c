@@ -724,6 +724,7 @@ static bool record_cb(DCR *dcr, DEV_RECORD *rec)
    case STREAM_ENCRYPTED_FILE_COMPRESSED_DATA:
    case STREAM_ENCRYPTED_WIN32_GZIP_DATA:
    case STREAM_ENCRYPTED_WIN32_COMPRESSED_DATA:
+   case STREAM_AEAD_DATA:
       /* No correct, we should (decrypt and) expand it
          done using JCR
       */
@@ -825,6 +826,7 @@ static bool record_cb(DCR *dcr, DEV_RECORD *rec)
    case STREAM_ACL_FREEBSD_NFS4_ACL:
    case STREAM_ACL_HURD_DEFAULT_ACL:
    case STREAM_ACL_HURD_ACCESS_ACL:
+   case STREAM_ACL_REF:
       /* Ignore Unix ACL attributes */
       break;
 
@@ -839,6 +841,7 @@ static bool record_cb(DCR *dcr, DEV_RECORD *rec)
    case STREAM_XATTR_FREEBSD:
    case STREAM_XATTR_LINUX:
    case STREAM_XATTR_NETBSD:
+   case STREAM_XATTR_REF:
       /* Ignore Unix Extended attributes */
       break;
 
@@ -883,6 +886,8 @@ static int create_file_attributes_record(B_DB *db, JCR *mjcr,
                                char *ap, DEV_RECORD *rec)
 {
    DCR *dcr = mjcr->read_dcr;
+   char lstat[MAXSTRING];
+
    ar.fname = fname;
    ar.link = lname;
    ar.ClientId = mjcr->ClientId;
@@ -894,6 +899,9 @@ static int create_file_attributes_record(B_DB *db, JCR *mjcr,
       ar.FileIndex = rec->FileIndex;
    }
    ar.attr = ap;
+   if (stat_compact_to_legacy(ap, lstat)) {
+      ar.attr = lstat;                /* the catalog keeps the legacy LStat */
+   }
    if (dcr->VolFirstIndex == 0) {
       dcr->VolFirstIndex = rec->FileIndex;
    }
@@ -204,6 +204,7 @@ DEVICE *m_init_dev(JCR *jcr, DEVRES *device, bool alt)
    dev->max_file_size = device->max_file_size;
    dev->max_concurrent_jobs = device->max_concurrent_jobs;
    dev->volume_capacity = device->volume_capacity;
+   dev->prealloc_size = device->prealloc_size;
    dev->max_rewind_wait = device->max_rewind_wait;
    dev->max_open_wait = device->max_open_wait;
    dev->vol_poll_interval = device->vol_poll_interval;
@@ -378,6 +379,9 @@ bool DEVICE::open(DCR *dcr, int omode)
          return true;
       } else {
          Dmsg1(200, "Close fd=%d for mode change in open().\n", m_fd);
+         if (is_file()) {
+            release_file_space();
+         }
          d_close(m_fd);
          clear_opened();
          preserve = state & (ST_LABEL|ST_APPEND|ST_READ);
@@ -560,6 +564,10 @@ void DEVICE::close()
    case B_VTAPE_DEV:
    case B_TAPE_DEV:
       unlock_door();
+      d_close(m_fd);
+      break;
+   case B_FILE_DEV:
+      release_file_space();
       /* Fall through wanted */
    default:
       d_close(m_fd);
@@ -567,6 +575,7 @@ void DEVICE::close()
    }
 
    unmount(1);                        /* do unmount if required */
+   close_block_index(this);
 
    /* Clean up device packet so it can be reused */
    clear_opened();
@@ -785,11 +794,24 @@ ssize_t DEVICE::read(void *buf, size_t len)
 ssize_t DEVICE::write(const void *buf, size_t len)
 {
    ssize_t write_len ;
+   boffset_t pos = -1;
 
    get_timer_count();
 
+   /* Space management of File volumes, see file_dev.c */
+   if (is_file() && (prealloc_size || has_cap(CAP_WRITEBEHIND))) {
+      pos = lseek(NULL, 0, SEEK_CUR);
+      if (pos >= 0 && prealloc_size) {
+         preallocate(pos, len);
+      }
+   }
+
    write_len = d_write(m_fd, buf, len);
 
+   if (pos >= 0 && write_len > 0 && has_cap(CAP_WRITEBEHIND)) {
+      write_behind(pos, write_len);
+   }
+
    last_tick = get_timer_count();
 
    DevWriteTime += last_tick;
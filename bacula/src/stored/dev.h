@@ -121,6 +121,9 @@ enum {
 #define CAP_REQMOUNT       (1<<21)    /* Require mount/unmount */
 #define CAP_CHECKLABELS    (1<<22)    /* Check for ANSI/IBM labels */
 #define CAP_BLOCKCHECKSUM  (1<<23)    /* Create/test block checksum */
+#define CAP_BLOCKINDEX     (1<<24)    /* Keep block index sidecar for File volumes */
+#define CAP_PREFETCHVOL    (1<<25)    /* Load next Volume in a spare drive */
+#define CAP_WRITEBEHIND    (1<<26)    /* Flush and drop cache behind writes */
 
 /* Test state */
 #define dev_state(dev, st_state) ((dev)->state & (st_state))
@@ -263,6 +266,11 @@ public:
    uint64_t max_volume_size;          /* max bytes to put on one volume */
    uint64_t max_file_size;            /* max file size to put in one file on volume */
    uint64_t volume_capacity;          /* advisory capacity */
+   uint64_t prealloc_size;            /* File volume preallocation increment */
+   uint64_t prealloc_end;             /* end of space preallocated on Volume */
+   uint64_t wb_start;                 /* start of range not yet dropped from cache */
+   uint64_t wb_next;                  /* end of range already sent to disk */
+   bool no_prealloc;                  /* fallocate() not usable on this Volume */
    uint64_t max_spool_size;           /* maximum spool file size */
    uint64_t spool_size;               /* current spool size for this device */
    uint32_t max_rewind_wait;          /* max secs to allow for rewind */
@@ -285,6 +293,7 @@ public:
    DEVRES *device;                    /* pointer to Device Resource */
    VOLRES *vol;                       /* Pointer to Volume reservation item */
    btimer_t *tid;                     /* timer id */
+   struct BLOCK_INDEX *bidx;          /* block index sidecar, see block_index.c */
 
    VOLUME_CAT_INFO VolCatInfo;        /* Volume Catalog Information */
    VOLUME_LABEL VolHdr;               /* Actual volume label */
@@ -542,6 +551,10 @@ public:
 private:
    bool do_tape_mount(int mount, int dotimeout);  /* in dev.c */
    bool do_file_mount(int mount, int dotimeout);  /* in dev.c */
+   void preallocate(boffset_t pos, size_t len);   /* in file_dev.c */
+   void write_behind(boffset_t pos, size_t len);  /* in file_dev.c */
+   void reset_file_space();                       /* in file_dev.c */
+   void release_file_space();                     /* in file_dev.c */
    void set_mode(int omode);                      /* in dev.c */
 };
 inline const char *DEVICE::strerror() const { return errmsg; }
@@ -581,6 +594,7 @@ public:
    DEV_BLOCK *block;                  /* pointer to block */
    DEV_RECORD *rec;                   /* pointer to record */
    pthread_t tid;                     /* Thread running this dcr */
+   struct VOL_PREFETCH *prefetch;     /* next Volume in spare drive, see prefetch.c */
    int spool_fd;                      /* fd if spooling */
    bool spool_data;                   /* set to spool data */
    bool spooling;                     /* set when actually spooling */
@@ -129,6 +129,18 @@ bool fixup_device_block_write_error(DCR *dcr, int retries)
    dcr->StartBlock = dcr->EndBlock = 0;
    dcr->StartFile  = dcr->EndFile = 0;
 
+   /*
+    * If the next Volume was prefetched in a spare drive, continue
+    *  there.  The DCR now points to the spare, which we hold blocked
+    *  exactly as the old device above.
+    */
+   if (switch_to_prefetched_device(dcr)) {
+      dev = dcr->dev;
+      bstrncpy(dev->VolHdr.PrevVolumeName, PrevVolName, sizeof(dev->VolHdr.PrevVolumeName));
+      label_blk->dev = dev;
+      block->dev = dev;
+   }
+
    if (!dcr->mount_next_write_volume()) {
       free_block(label_blk);
       dcr->block = block;
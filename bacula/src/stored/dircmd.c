@@ -65,6 +65,7 @@ static bool client_cmd(JCR *jcr);
 static bool storage_cmd(JCR *jcr);
 static bool label_cmd(JCR *jcr);
 static bool die_cmd(JCR *jcr);
+static bool profile_cmd(JCR *jcr);
 static bool relabel_cmd(JCR *jcr);
 static bool readlabel_cmd(JCR *jcr);
 static bool release_cmd(JCR *jcr);
@@ -110,6 +111,7 @@ static struct s_cmds cmds[] = {
    {".die",        die_cmd,         0},
    {"label",       label_cmd,       0},     /* label a tape */
    {"mount",       mount_cmd,       0},
+   {"profile ",    profile_cmd,     0},     /* sampling profiler */
    {"readlabel",   readlabel_cmd,   0},
    {"release",     release_cmd,     0},
    {"relabel",     relabel_cmd,     0},     /* relabel a tape */
@@ -288,6 +290,18 @@ static bool die_cmd(JCR *jcr)
    return 0;
 }
 
+/*
+ * Start, stop or query the sampling profiler, see lib/profiler.c
+ */
+static bool profile_cmd(JCR *jcr)
+{
+   BSOCK *dir = jcr->dir_bsock;
+   POOL_MEM msg(PM_MESSAGE);
+
+   profiler_command(dir->msg, msg.addr());
+   return dir->fsend("%s", msg.c_str());
+}
+
 /*
  * Get address of client from Director
  *   We attempt to connect to the client (an FD or SD) and
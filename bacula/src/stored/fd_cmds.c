@@ -112,6 +112,14 @@ void run_job(JCR *jcr)
    jcr->start_time = time(NULL);
    jcr->run_time = jcr->start_time;
    jcr->sendJobStatus(JS_Running);
+   if (jcr->file_bsock) {
+      if (jcr->is_JobType(JT_BACKUP) && jcr->sd_client) {
+         /* Writing side of a Copy or Migration, the data comes from an SD */
+         jcr->file_bsock->set_bwclass(BW_CLASS_COPY);
+      } else {
+         jcr->file_bsock->set_bwclass(bw_class_of_job(jcr->getJobType()));
+      }
+   }
    /*
     * A migrate or copy job does both a restore (read_data) and
     *   a backup (append_data).
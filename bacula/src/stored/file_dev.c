@@ -176,10 +176,132 @@ void DEVICE::open_file_device(DCR *dcr, int omode)
       dev_errno = 0;
       file = 0;
       file_addr = 0;
+      reset_file_space();
    }
    Dmsg1(100, "open dev: disk fd=%d opened\n", m_fd);
 }
 
+/*
+ * Space management of File volumes.
+ *
+ *  With "Preallocate Size", the space of the Volume is reserved with
+ *   fallocate() in large increments ahead of the writes, so that the
+ *   Volumes written in parallel are not interleaved on the disk.  The
+ *   file size is not changed, and the space that was not used is given
+ *   back when the Volume is closed.
+ *
+ *  With "Write Behind", the data written is sent to the disk in chunks
+ *   as the Volume grows, and each chunk is dropped from the page cache
+ *   once it is on the disk.  What we write will probably not be read
+ *   for weeks, so it should not evict the cache of the rest of the
+ *   system, and the kernel should not have to flush gigabytes of dirty
+ *   pages at once.
+ *
+ *  Bacula blocks have a variable size and may start at any offset, so
+ *   O_DIRECT cannot be used without changing the Volume format.
+ */
+
+/* Size of the chunks sent to the disk by the write behind code */
+#define WRITE_BEHIND_CHUNK (8 * 1024 * 1024)
+
+void DEVICE::reset_file_space()
+{
+   prealloc_end = 0;
+   wb_start = wb_next = 0;
+   no_prealloc = false;
+}
+
+/* Called before writing len bytes at pos */
+void DEVICE::preallocate(boffset_t pos, size_t len)
+{
+#ifdef FALLOC_FL_KEEP_SIZE
+   uint64_t start = prealloc_end;
+   uint64_t end = (uint64_t)pos + len;
+   uint64_t size = prealloc_size;
+
+   if (no_prealloc || end <= prealloc_end) {
+      return;
+   }
+   if (start < (uint64_t)pos) {
+      start = pos;
+   }
+   if (size < end - start) {
+      size = end - start;
+   }
+   /* No need to go past the end of the Volume */
+   if (max_volume_size && start + size > max_volume_size && max_volume_size > end) {
+      size = max_volume_size - start;
+   }
+   if (fallocate(m_fd, FALLOC_FL_KEEP_SIZE, start, size) < 0) {
+      berrno be;
+      Dmsg2(100, "Cannot preallocate space on %s. ERR=%s\n", print_name(),
+            be.bstrerror());
+      no_prealloc = true;             /* retry with the next Volume */
+      return;
+   }
+   Dmsg3(200, "Preallocated %lld bytes at %lld on %s\n", size, start, print_name());
+   prealloc_end = start + size;
+#endif
+}
+
+/* Called after writing len bytes at pos */
+void DEVICE::write_behind(boffset_t pos, size_t len)
+{
+   uint64_t end = (uint64_t)pos + len;
+
+   if ((uint64_t)pos < wb_next || (uint64_t)pos > wb_next + WRITE_BEHIND_CHUNK) {
+      wb_start = wb_next = pos;       /* we moved, start again from here */
+   }
+   if (end - wb_next < WRITE_BEHIND_CHUNK) {
+      return;
+   }
+#ifdef SYNC_FILE_RANGE_WRITE
+   /* Start the write of the new chunk */
+   sync_file_range(m_fd, wb_next, end - wb_next, SYNC_FILE_RANGE_WRITE);
+   /* The previous one was started long ago, it should be on disk now */
+   if (wb_next > wb_start) {
+      sync_file_range(m_fd, wb_start, wb_next - wb_start,
+         SYNC_FILE_RANGE_WAIT_BEFORE|SYNC_FILE_RANGE_WRITE|SYNC_FILE_RANGE_WAIT_AFTER);
+   }
+#endif
+#if defined(HAVE_POSIX_FADVISE) && defined(POSIX_FADV_DONTNEED)
+   if (wb_next > wb_start) {
+      posix_fadvise(m_fd, wb_start, wb_next - wb_start, POSIX_FADV_DONTNEED);
+   }
+#endif
+   wb_start = wb_next;
+   wb_next = end;
+}
+
+/*
+ * Called before closing a File volume, give back the space
+ *  preallocated after the end of the data.
+ */
+void DEVICE::release_file_space()
+{
+   if (m_fd < 0) {
+      return;
+   }
+#if defined(FALLOC_FL_PUNCH_HOLE) && defined(FALLOC_FL_KEEP_SIZE)
+   struct stat st;
+   if (prealloc_end > 0 && fstat(m_fd, &st) == 0 &&
+       (uint64_t)st.st_size < prealloc_end) {
+      if (fallocate(m_fd, FALLOC_FL_PUNCH_HOLE|FALLOC_FL_KEEP_SIZE,
+                    st.st_size, prealloc_end - st.st_size) < 0) {
+         berrno be;
+         Dmsg2(100, "Cannot release preallocated space on %s. ERR=%s\n",
+               print_name(), be.bstrerror());
+      }
+   }
+#endif
+#if defined(HAVE_POSIX_FADVISE) && defined(POSIX_FADV_DONTNEED)
+   if (has_cap(CAP_WRITEBEHIND) && wb_next > wb_start) {
+      posix_fadvise(m_fd, wb_start, 0, POSIX_FADV_DONTNEED);
+   }
+#endif
+   reset_file_space();
+}
+
 
 /*
  * Truncate a volume.  If this is aligned disk, we
@@ -205,6 +327,7 @@ bool DEVICE::truncate(DCR *dcr) /* We need the DCR for DVD-writing */
                print_name(), be.bstrerror());
          return false;
       }
+      dev->reset_file_space();        /* preallocated space is gone too */
 
       /*
        * Check for a successful ftruncate() and issue a work-around for devices
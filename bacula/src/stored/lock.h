@@ -26,6 +26,8 @@
 
 void    _lock_reservations(const char *file="**Unknown**", int line=0);
 void    _unlock_reservations();
+void    _lock_reservations_shards(uint32_t shards, const char *file="**Unknown**", int line=0);
+void    _unlock_reservations_shards(uint32_t shards);
 void    _lock_volumes(const char *file="**Unknown**", int line=0);
 void    _unlock_volumes();
 
@@ -44,6 +46,19 @@ void    _unlock_volumes();
               reservations_lock_count); \
                    _unlock_reservations(); } while (0)
 
+#define lock_reservations_shards(s) \
+         do { Dmsg4(sd_dbglvl, "lock_reservations shards=%x at %s:%d precnt=%d\n", \
+              (s), __FILE__, __LINE__, \
+              reservations_lock_count); \
+              _lock_reservations_shards((s), __FILE__, __LINE__); \
+              Dmsg0(sd_dbglvl, "lock_reservations: got lock\n"); \
+         } while (0)
+#define unlock_reservations_shards(s) \
+         do { Dmsg4(sd_dbglvl, "unlock_reservations shards=%x at %s:%d precnt=%d\n", \
+              (s), __FILE__, __LINE__, \
+              reservations_lock_count); \
+                   _unlock_reservations_shards(s); } while (0)
+
 #define lock_volumes() \
          do { Dmsg3(sd_dbglvl, "lock_volumes at %s:%d precnt=%d\n", \
               __FILE__, __LINE__, \
@@ -62,6 +77,8 @@ void    _unlock_volumes();
 
 #define lock_reservations() _lock_reservations(__FILE__, __LINE__)
 #define unlock_reservations() _unlock_reservations()
+#define lock_reservations_shards(s) _lock_reservations_shards((s), __FILE__, __LINE__)
+#define unlock_reservations_shards(s) _unlock_reservations_shards(s)
 #define lock_volumes() _lock_volumes(__FILE__, __LINE__)
 #define unlock_volumes() _unlock_volumes()
 
@@ -0,0 +1,313 @@
+/*
+   Bacula® - The Network Backup Solution
+
+   Copyright (C) 2014-2014 Free Software Foundation Europe e.V.
+
+   The main author of Bacula is Kern Sibbald, with contributions from many
+   others, a complete list can be found in the file AUTHORS.
+
+   You may use this file and others of this release according to the
+   license defined in the LICENSE file, which includes the Affero General
+   Public License, v3.0 ("AGPLv3") and some additional permissions and
+   terms pursuant to its AGPLv3 Section 7.
+
+   Bacula® is a registered trademark of Kern Sibbald.
+*/
+/*
+ *
+ *   prefetch.c  -- load the next Volume in a spare autochanger drive
+ *
+ *  When "Prefetch Next Volume = yes" is set on an autochanger tape
+ *   drive, and the Volume being written gets close to its expected
+ *   capacity, we ask the Director for the next appendable Volume,
+ *   reserve it on an idle drive of the same autochanger and start
+ *   loading it there in a separate thread.  When the current Volume
+ *   hits end of medium, fixup_device_block_write_error() moves the
+ *   job's DCR to the spare drive, so the job waits neither for the
+ *   unload of the full Volume nor for the load of the next one.
+ *
+ *  The switch is only done when the job is the sole writer on the
+ *   drive and both drives use the same block sizes; in every other
+ *   case the prefetch is dropped and the normal mount code runs.
+ */
+
+#include "bacula.h"
+#include "stored.h"
+
+static const int dbglvl = 150;
+
+/* Percent of the expected capacity at which we start the prefetch */
+#define PREFETCH_PERCENT 90
+
+enum {
+   PF_LOADING = 1,                    /* loader thread running */
+   PF_READY,                          /* Volume loaded in spare drive */
+   PF_FAILED                          /* nothing to switch to */
+};
+
+struct VOL_PREFETCH {
+   char VolumeName[MAX_NAME_LENGTH];  /* Volume nearing its end */
+   DCR *pdcr;                         /* reservation on the spare drive */
+   pthread_t tid;                     /* loader thread */
+   bool thread_started;               /* set if tid must be joined */
+   volatile int state;                /* PF_xxx */
+};
+
+/*
+ * Size at which we consider the Volume to be nearly full, or
+ *  zero if we have no idea of its capacity.
+ */
+static uint64_t expected_capacity(DEVICE *dev)
+{
+   if (dev->max_volume_size) {
+      return dev->max_volume_size;
+   }
+   if (dev->VolCatInfo.VolCatMaxBytes) {
+      return dev->VolCatInfo.VolCatMaxBytes;
+   }
+   if (dev->VolCatInfo.VolCatCapacityBytes) {
+      return dev->VolCatInfo.VolCatCapacityBytes;
+   }
+   return dev->volume_capacity;
+}
+
+/*
+ * Find an idle drive in the same autochanger that can take over
+ *  the job.  Must be called with the reservations locked.
+ */
+static DEVICE *find_spare_drive(DCR *dcr)
+{
+   DEVICE *dev = dcr->dev;
+   AUTOCHANGER *changer = dcr->device->changer_res;
+   DEVRES *device;
+
+   foreach_alist(device, changer->device) {
+      DEVICE *sdev = device->dev;
+      if (!sdev || sdev == dev || !sdev->autoselect || !sdev->is_autochanger()) {
+         continue;
+      }
+      if (strcmp(device->media_type, dcr->device->media_type) != 0) {
+         continue;
+      }
+      if (sdev->max_block_size != dev->max_block_size ||
+          sdev->min_block_size != dev->min_block_size) {
+         continue;
+      }
+      if (sdev->is_busy() || sdev->is_blocked() || sdev->swap_dev) {
+         continue;
+      }
+      return sdev;
+   }
+   return NULL;
+}
+
+/*
+ * Load the reserved Volume into the spare drive.  The drive is
+ *  blocked while the changer works so that no other job grabs it.
+ */
+static void *prefetch_load_thread(void *arg)
+{
+   VOL_PREFETCH *pf = (VOL_PREFETCH *)arg;
+   DCR *pdcr = pf->pdcr;
+   DEVICE *dev = pdcr->dev;
+   bool ok = false;
+
+   set_jcr_in_tsd(pdcr->jcr);
+   dev->Lock();
+   if (!dev->is_blocked()) {
+      block_device(dev, BST_DOING_ACQUIRE);
+      dev->Unlock();
+      ok = autoload_device(pdcr, SD_APPEND, NULL) > 0;
+      dev->Lock();
+      unblock_device(dev);
+   }
+   dev->Unlock();
+   Dmsg3(dbglvl, "Prefetch of Volume \"%s\" on %s ok=%d\n",
+      pdcr->VolumeName, dev->print_name(), ok);
+   pf->state = ok ? PF_READY : PF_FAILED;
+   return NULL;
+}
+
+/*
+ * Wait for the loader and release the spare drive reservation,
+ *  keeping the record so that we do not retry on this Volume.
+ */
+static void drop_prefetch(VOL_PREFETCH *pf)
+{
+   if (pf->thread_started) {
+      pthread_join(pf->tid, NULL);
+      pf->thread_started = false;
+   }
+   if (pf->pdcr) {
+      free_dcr(pf->pdcr);
+      pf->pdcr = NULL;
+   }
+   if (pf->state != PF_READY) {
+      pf->state = PF_FAILED;
+   }
+}
+
+void free_volume_prefetch(DCR *dcr)
+{
+   VOL_PREFETCH *pf = dcr->prefetch;
+
+   if (!pf) {
+      return;
+   }
+   dcr->prefetch = NULL;
+   drop_prefetch(pf);
+   free(pf);
+}
+
+/*
+ * Called by the job thread after each block written to a device,
+ *  with the device unlocked.  Starts at most one prefetch per
+ *  Volume.
+ */
+void check_volume_prefetch(DCR *dcr)
+{
+   JCR *jcr = dcr->jcr;
+   DEVICE *dev = dcr->dev;
+   VOL_PREFETCH *pf;
+   DEVICE *sdev;
+   DCR *pdcr;
+   uint64_t capacity;
+   uint32_t shards;
+   int stat;
+
+   if (!dev->has_cap(CAP_PREFETCHVOL) || !dev->is_tape() || !dev->is_autochanger() ||
+       !dcr->device->changer_res || jcr->getJobType() == JT_SYSTEM) {
+      return;
+   }
+   pf = dcr->prefetch;
+   if (pf && strcmp(pf->VolumeName, dev->VolHdr.VolumeName) == 0) {
+      return;                         /* already done for this Volume */
+   }
+   capacity = expected_capacity(dev);
+   if (capacity == 0 ||
+       dev->VolCatInfo.VolCatBytes < capacity / 100 * PREFETCH_PERCENT) {
+      return;
+   }
+   if (pf) {
+      free_volume_prefetch(dcr);      /* stale, from a previous Volume */
+   }
+   pf = (VOL_PREFETCH *)malloc(sizeof(VOL_PREFETCH));
+   memset(pf, 0, sizeof(VOL_PREFETCH));
+   bstrncpy(pf->VolumeName, dev->VolHdr.VolumeName, sizeof(pf->VolumeName));
+   pf->state = PF_FAILED;
+   dcr->prefetch = pf;
+
+   if (dev->num_writers != 1 || !jcr->dir_bsock) {
+      return;
+   }
+
+   shards = device_reserve_shards(dcr->device);
+   lock_reservations_shards(shards);
+   sdev = find_spare_drive(dcr);
+   if (!sdev) {
+      unlock_reservations_shards(shards);
+      Dmsg1(dbglvl, "No spare drive to prefetch after Volume \"%s\"\n", pf->VolumeName);
+      return;
+   }
+   pdcr = new_dcr(jcr, NULL, sdev, SD_APPEND);
+   bstrncpy(pdcr->pool_name, dcr->pool_name, sizeof(pdcr->pool_name));
+   bstrncpy(pdcr->pool_type, dcr->pool_type, sizeof(pdcr->pool_type));
+   bstrncpy(pdcr->media_type, dcr->media_type, sizeof(pdcr->media_type));
+   bstrncpy(pdcr->dev_name, sdev->dev_name, sizeof(pdcr->dev_name));
+   pdcr->set_reserved_for_append();
+   unlock_reservations_shards(shards);
+   pf->pdcr = pdcr;
+
+   /* Reserves the Volume on sdev */
+   if (!dir_find_next_appendable_volume(pdcr) ||
+       !pdcr->VolCatInfo.InChanger || pdcr->VolCatInfo.Slot <= 0) {
+      Dmsg1(dbglvl, "No Volume to prefetch on %s\n", sdev->print_name());
+      drop_prefetch(pf);
+      return;
+   }
+   Jmsg(jcr, M_INFO, 0, _("Volume \"%s\" nearly full, prefetching Volume \"%s\" on device %s.\n"),
+      pf->VolumeName, pdcr->VolumeName, sdev->print_name());
+
+   /* The loader thread may send job messages while we talk to the Director */
+   jcr->dir_bsock->set_locking();
+   pf->state = PF_LOADING;
+   if ((stat = pthread_create(&pf->tid, NULL, prefetch_load_thread, pf)) != 0) {
+      berrno be;
+      Jmsg1(jcr, M_WARNING, 0, _("Cannot create prefetch thread: %s\n"), be.bstrerror(stat));
+      drop_prefetch(pf);
+      return;
+   }
+   pf->thread_started = true;
+}
+
+/*
+ * Called from fixup_device_block_write_error() at end of medium,
+ *  with the current device unlocked but blocked by us.  If the
+ *  next Volume is ready in a spare drive, move the DCR to that
+ *  drive and leave it blocked in the same way.
+ *
+ * Returns: true  if the DCR now points to the spare drive
+ *          false if the normal mount must be done
+ */
+bool switch_to_prefetched_device(DCR *dcr)
+{
+   JCR *jcr = dcr->jcr;
+   VOL_PREFETCH *pf = dcr->prefetch;
+   DEVICE *odev = dcr->dev;
+   DEVICE *ndev;
+   DCR *pdcr;
+
+   if (!pf || !pf->pdcr) {
+      return false;
+   }
+   if (pf->thread_started) {
+      pthread_join(pf->tid, NULL);    /* still loading, wait for it */
+      pf->thread_started = false;
+   }
+   pdcr = pf->pdcr;
+   ndev = pdcr->dev;
+   if (pf->state != PF_READY || odev->num_writers != 1 || job_canceled(jcr)) {
+      free_volume_prefetch(dcr);
+      return false;
+   }
+
+   /* Give up the old drive, it keeps its full Volume until next use */
+   odev->Lock();
+   lock_volumes();
+   odev->num_writers--;
+   if (odev->num_writers == 0 && odev->num_reserved() == 0) {
+      volume_unused(dcr);
+      generate_plugin_event(jcr, bsdEventDeviceClose, dcr);
+   }
+   unlock_volumes();
+   unblock_device(odev);
+   pthread_cond_broadcast(&odev->wait_next_vol);
+   odev->Unlock();
+   odev->detach_dcr_from_dev(dcr);
+   if (dcr->job_spool_size) {
+      P(odev->spool_mutex);
+      odev->spool_size -= dcr->job_spool_size;
+      V(odev->spool_mutex);
+      P(ndev->spool_mutex);
+      ndev->spool_size += dcr->job_spool_size;
+      V(ndev->spool_mutex);
+   }
+
+   /* Take the new one; our writer count keeps the Volume reserved */
+   dcr->device = ndev->device;
+   dcr->set_dev(ndev);
+   ndev->attach_dcr_to_dev(dcr);
+   ndev->Lock();
+   ndev->num_writers++;
+   if (strcmp(ndev->VolHdr.VolumeName, pdcr->VolumeName) != 0) {
+      ndev->clear_volhdr();           /* label not yet read */
+   }
+   block_device(ndev, BST_DOING_ACQUIRE);
+   ndev->Unlock();
+   free_volume_prefetch(dcr);         /* frees pdcr and its reservation */
+   pthread_cond_broadcast(&wait_device_release);
+
+   Jmsg(jcr, M_INFO, 0, _("Switching from device %s to device %s for next Volume.\n"),
+      odev->print_name(), ndev->print_name());
+   return true;
+}
@@ -75,6 +75,11 @@ void    ser_block_header(DEV_BLOCK *block);
 bool    is_block_empty(DEV_BLOCK *block);
 bool    terminate_writing_volume(DCR *dcr);
 
+/* From block_index.c */
+void    write_block_index(DCR *dcr, DEV_BLOCK *block, uint64_t addr, uint32_t len);
+uint64_t block_index_next_addr(DCR *dcr, BSR *root, uint64_t addr);
+void    close_block_index(DEVICE *dev);
+
 /* From block_util.c */
 bool    terminate_writing_volume(DCR *dcr);
 bool    user_volume_size_reached(DCR *dcr, bool quiet);
@@ -184,6 +189,11 @@ void     free_bsr(BSR *bsr);
 void     free_restore_volume_list(JCR *jcr);
 void     create_restore_volume_list(JCR *jcr);
 
+/* From prefetch.c */
+void     check_volume_prefetch(DCR *dcr);
+bool     switch_to_prefetched_device(DCR *dcr);
+void     free_volume_prefetch(DCR *dcr);
+
 /* From record.c */
 const char *FI_to_ascii(char *buf, int fi);
 const char *stream_to_ascii(char *buf, int stream, int fi);
@@ -203,6 +213,7 @@ bool read_records(DCR *dcr,
 /* From reserve.c */
 void    init_reservations_lock();
 void    term_reservations_lock();
+uint32_t device_reserve_shards(DEVRES *device);
 void    send_drive_reserve_messages(JCR *jcr, void sendit(const char *msg, int len, void *sarg), void *arg);
 bool    find_suitable_device_for_job(JCR *jcr, RCTX &rctx);
 int     search_res_for_device(RCTX &rctx);
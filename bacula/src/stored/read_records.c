@@ -340,6 +340,19 @@ static bool try_repositioning(JCR *jcr, DEV_RECORD *rec, DCR *dcr)
       uint64_t bsr_addr = get_bsr_start_addr(bsr, &file, &block);
 
       if (dev_addr > bsr_addr) {
+         /*
+          * Already inside the wanted range.  On a File volume with
+          *  a block index, skip over the blocks of other jobs.
+          */
+         if (dev->is_file()) {
+            uint64_t addr = block_index_next_addr(dcr, jcr->bsr, dev->file_addr);
+            if (addr > dev->file_addr) {
+               Dmsg4(dbglvl, "Block index reposition from (file:block) %u:%u to %u:%u\n",
+                     dev->file, dev->block_num, (uint32_t)(addr>>32), (uint32_t)addr);
+               dev->reposition(dcr, (uint32_t)(addr>>32), (uint32_t)addr);
+               rec->Block = 0;
+            }
+         }
          return false;
       }
       Dmsg4(dbglvl, "Try_Reposition from (file:block) %u:%u to %u:%u\n",
@@ -358,6 +371,7 @@ static BSR *position_to_first_file(JCR *jcr, DCR *dcr)
    BSR *bsr = NULL;
    DEVICE *dev = dcr->dev;
    uint32_t file, block;
+   uint64_t addr;
    /*
     * Now find and position to first file and block
     *   on this tape.
@@ -366,7 +380,17 @@ static BSR *position_to_first_file(JCR *jcr, DCR *dcr)
       jcr->bsr->reposition = true;    /* force repositioning */
       bsr = find_next_bsr(jcr->bsr, dev);
 
-      if (get_bsr_start_addr(bsr, &file, &block) > 0) {
+      addr = get_bsr_start_addr(bsr, &file, &block);
+      if (dev->is_file()) {
+         /* The block index may know of a closer first block */
+         uint64_t iaddr = block_index_next_addr(dcr, jcr->bsr, addr);
+         if (iaddr > addr) {
+            addr = iaddr;
+            file = (uint32_t)(addr>>32);
+            block = (uint32_t)addr;
+         }
+      }
+      if (addr > 0) {
          Jmsg(jcr, M_INFO, 0, _("Forward spacing Volume \"%s\" to file:block %u:%u.\n"),
               dev->VolHdr.VolumeName, file, block);
          dev->reposition(dcr, file, block);
@@ -144,6 +144,8 @@ const char *stream_to_ascii(char *buf, int stream, int fi)
          return "contENCRYPTED-WIN32-COMPRESSED";
       case STREAM_ENCRYPTED_MACOS_FORK_DATA:
          return "contENCRYPTED-MACOS-RSRC";
+      case STREAM_AEAD_DATA:
+         return "contAEAD-DATA";
       case STREAM_PLUGIN_NAME:
          return "contPLUGIN-NAME";
 
@@ -214,6 +216,8 @@ const char *stream_to_ascii(char *buf, int stream, int fi)
       return "ENCRYPTED-WIN32-COMPRESSED";
    case STREAM_ENCRYPTED_MACOS_FORK_DATA:
       return "ENCRYPTED-MACOS-RSRC";
+   case STREAM_AEAD_DATA:
+      return "AEAD-DATA";
 
    default:
       sprintf(buf, "%d", stream);
@@ -27,7 +27,27 @@
 
 const int dbglvl = 150;
 
-static brwlock_t reservation_lock;
+/*
+ * The reservations are split in RESERVE_SHARDS independent locks.
+ *  The shard of a Device is chosen by hashing its Media Type: a
+ *  Volume can only move between devices of the same Media Type, so
+ *  reserve_volume() never steals a Volume from a device that is
+ *  not covered by the shards the Job holds.  A drive of an
+ *  Autochanger takes the shards of all the Media Types of the
+ *  Autochanger.  A Job locks only the shards of the devices the
+ *  Director asked for, so Jobs that use different Media Types
+ *  reserve their drives in parallel, while the drives of one
+ *  Autochanger are still reserved one Job at a time.  The shards
+ *  are always locked in ascending order.
+ *
+ * lock_reservations() takes all the shards, keep their number small
+ *  so that the thread can still take the device and Volume locks
+ *  (the lock manager tracks at most LMGR_MAX_LOCK locks per thread).
+ */
+#define RESERVE_SHARDS   8
+#define ALL_SHARDS       ((1 << RESERVE_SHARDS) - 1)
+
+static brwlock_t reservation_lock[RESERVE_SHARDS];
 int reservations_lock_count = 0;
 
 /* Forward referenced functions */
@@ -59,42 +79,136 @@ static char BAD_use[]   = "3913 Bad use command: %s\n";
 void init_reservations_lock()
 {
    int errstat;
-   if ((errstat=rwl_init(&reservation_lock)) != 0) {
-      berrno be;
-      Emsg1(M_ABORT, 0, _("Unable to initialize reservation lock. ERR=%s\n"),
-            be.bstrerror(errstat));
+   for (int i=0; i < RESERVE_SHARDS; i++) {
+      if ((errstat=rwl_init(&reservation_lock[i])) != 0) {
+         berrno be;
+         Emsg1(M_ABORT, 0, _("Unable to initialize reservation lock. ERR=%s\n"),
+               be.bstrerror(errstat));
+      }
    }
 
    init_vol_list_lock();
 }
 
+/* Shard of the devices of a Media Type */
+static uint32_t media_type_shard(const char *media_type)
+{
+   uint32_t hash = 0;
 
-/* This applies to a drive and to Volumes */
-void _lock_reservations(const char *file, int line)
+   for (const char *p = media_type; *p; p++) {
+      hash = hash * 31 + (unsigned char)*p;
+   }
+   return (uint32_t)1 << (hash % RESERVE_SHARDS);
+}
+
+/* Shards of all the drives of an Autochanger */
+static uint32_t changer_shards(AUTOCHANGER *changer)
+{
+   DEVRES *device;
+   uint32_t shards = 0;
+
+   foreach_alist(device, changer->device) {
+      shards |= media_type_shard(device->media_type);
+   }
+   return shards;
+}
+
+/*
+ * Shards of a device name given by the Director.  The name is either
+ *  an Autochanger or a Device, possibly a drive of an Autochanger.
+ */
+static uint32_t reserve_shard(const char *device_name)
+{
+   AUTOCHANGER *changer;
+   DEVRES *device;
+
+   if ((changer = (AUTOCHANGER *)GetResWithName(R_AUTOCHANGER, device_name))) {
+      return changer_shards(changer);
+   }
+   if ((device = (DEVRES *)GetResWithName(R_DEVICE, device_name))) {
+      return device_reserve_shards(device);
+   }
+   return 0;
+}
+
+/* Shards used by a list of Director Storage resources */
+static uint32_t reserve_shards(alist *dirstore)
+{
+   DIRSTORE *store;
+   char *device_name;
+   uint32_t shards = 0;
+
+   if (!dirstore) {
+      return ALL_SHARDS;
+   }
+   foreach_alist(store, dirstore) {
+      foreach_alist(device_name, store->device) {
+         shards |= reserve_shard(device_name);
+      }
+   }
+   return shards ? shards : ALL_SHARDS;
+}
+
+/* Shards of a drive for code that works on a single device */
+uint32_t device_reserve_shards(DEVRES *device)
+{
+   if (device->changer_res) {
+      return changer_shards(device->changer_res);
+   }
+   return media_type_shard(device->media_type);
+}
+
+/*
+ * This applies to drives and to Volumes.  The lock is recursive,
+ *  and lock_reservations() takes all the shards.
+ */
+void _lock_reservations_shards(uint32_t shards, const char *file, int line)
 {
    int errstat;
-   reservations_lock_count++;
-   if ((errstat=rwl_writelock_p(&reservation_lock, file, line)) != 0) {
-      berrno be;
-      Emsg2(M_ABORT, 0, "rwl_writelock failure. stat=%d: ERR=%s\n",
-           errstat, be.bstrerror(errstat));
+   __sync_fetch_and_add(&reservations_lock_count, 1);  /* shards are locked in parallel */
+   for (int i=0; i < RESERVE_SHARDS; i++) {
+      if (!(shards & ((uint32_t)1 << i))) {
+         continue;
+      }
+      if ((errstat=rwl_writelock_p(&reservation_lock[i], file, line)) != 0) {
+         berrno be;
+         Emsg2(M_ABORT, 0, "rwl_writelock failure. stat=%d: ERR=%s\n",
+              errstat, be.bstrerror(errstat));
+      }
    }
 }
 
-void _unlock_reservations()
+void _unlock_reservations_shards(uint32_t shards)
 {
    int errstat;
-   reservations_lock_count--;
-   if ((errstat=rwl_writeunlock(&reservation_lock)) != 0) {
-      berrno be;
-      Emsg2(M_ABORT, 0, "rwl_writeunlock failure. stat=%d: ERR=%s\n",
-           errstat, be.bstrerror(errstat));
+   __sync_fetch_and_sub(&reservations_lock_count, 1);
+   for (int i=RESERVE_SHARDS-1; i >= 0; i--) {
+      if (!(shards & ((uint32_t)1 << i))) {
+         continue;
+      }
+      if ((errstat=rwl_writeunlock(&reservation_lock[i])) != 0) {
+         berrno be;
+         Emsg2(M_ABORT, 0, "rwl_writeunlock failure. stat=%d: ERR=%s\n",
+              errstat, be.bstrerror(errstat));
+      }
    }
 }
 
+void _lock_reservations(const char *file, int line)
+{
+   _lock_reservations_shards(ALL_SHARDS, file, line);
+}
+
+void _unlock_reservations()
+{
+   _unlock_reservations_shards(ALL_SHARDS);
+}
+
 void term_reservations_lock()
 {
-   rwl_destroy(&reservation_lock);
+   for (int i=0; i < RESERVE_SHARDS; i++) {
+      rwl_destroy(&reservation_lock[i]);
+   }
    term_vol_list_lock();
 }
 
@@ -281,7 +395,9 @@ static bool use_device_cmd(JCR *jcr)
       } else {
          rctx.jcr->read_dcr = jcr->dcr;
       }
-      lock_reservations();
+      /* Lock only the Autochangers and Devices we may use */
+      rctx.shards = reserve_shards(rctx.append ? jcr->write_store : jcr->read_store);
+      lock_reservations_shards(rctx.shards);
       for ( ; !fail && !job_canceled(jcr); ) {
          pop_reserve_messages(jcr);
          rctx.suitable_device = false;
@@ -337,7 +453,7 @@ static bool use_device_cmd(JCR *jcr)
             break;
          }
          /* Keep reservations locked *except* during wait_for_device() */
-         unlock_reservations();
+         unlock_reservations_shards(rctx.shards);
          /*
           * The idea of looping on repeat a few times it to ensure
           * that if there is some subtle timing problem between two
@@ -352,10 +468,10 @@ static bool use_device_cmd(JCR *jcr)
             Dmsg0(100, "Fail. !suitable_device || !wait_for_device\n");
             fail = true;
          }
-         lock_reservations();
+         lock_reservations_shards(rctx.shards);
          dir->signal(BNET_HEARTBEAT);  /* Inform Dir that we are alive */
       }
-      unlock_reservations();
+      unlock_reservations_shards(rctx.shards);
 
       if (!ok) {
          /*
@@ -57,5 +57,6 @@ public:
    bool autochanger_only;             /* look at autochangers only */
    bool notify_dir;                   /* Notify DIR about device */
    bool append;                       /* set if append device */
+   uint32_t shards;                   /* reservation locks held */
    char VolumeName[MAX_NAME_LENGTH];  /* Vol name suggested by DIR */
 };
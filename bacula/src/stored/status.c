@@ -253,6 +253,15 @@ static void list_status_header(STATUS_PKT *sp)
               (int)sizeof(boffset_t), (int)sizeof(size_t), (int)sizeof(int32_t),
               (int)sizeof(int64_t), (int)DEVELOPER_MODE, (int)BEEF);
    sendit(msg, len, sp);
+   if ((len = edit_message_delivery_status(msg.addr())) > 0) {
+      sendit(msg, len, sp);
+   }
+   if ((len = edit_bw_sched_status(msg.addr())) > 0) {
+      sendit(msg, len, sp);
+   }
+   if ((len = lmgr_edit_contention(msg.addr(), 10)) > 0) {
+      sendit(msg, len, sp);
+   }
    if (bplugin_list->size() > 0) {
       Plugin *plugin;
       int len;
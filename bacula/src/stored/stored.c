@@ -268,6 +268,7 @@ int main (int argc, char *argv[])
    }
 
    start_watchdog();                  /* start watchdog thread */
+   start_message_delivery();          /* start async message delivery thread */
    init_jcr_subsystem();              /* start JCR watchdogs etc. */
 
    /* Single server used for Director and File daemon */
@@ -309,6 +310,13 @@ static int check_resources()
          configfile);
       OK = false;
    }
+   if (me) {
+      set_tls_kernel_offload(me->tls_kernel_offload);
+      bw_sched_set_weight(BW_CLASS_BACKUP, me->backup_bw_weight);
+      bw_sched_set_weight(BW_CLASS_RESTORE, me->restore_bw_weight);
+      bw_sched_set_weight(BW_CLASS_COPY, me->copy_bw_weight);
+      bw_sched_init(me->max_bandwidth);
+   }
    if (GetNextRes(R_DIRECTOR, NULL) == NULL) {
       Jmsg1(NULL, M_ERROR, 0, _("No Director resource defined in %s. Cannot continue.\n"),
          configfile);
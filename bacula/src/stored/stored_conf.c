@@ -60,10 +60,15 @@ static RES_ITEM store_items[] = {
    {"scriptsdirectory",      store_dir,  ITEM(res_store.scripts_directory), 0, 0, 0},
    {"maximumconcurrentjobs", store_pint32, ITEM(res_store.max_concurrent_jobs), 0, ITEM_DEFAULT, 20},
    {"heartbeatinterval",     store_time, ITEM(res_store.heartbeat_interval), 0, ITEM_DEFAULT, 0},
+   {"maximumbandwidth",      store_speed, ITEM(res_store.max_bandwidth), 0, 0, 0},
+   {"backupbandwidthweight", store_pint32, ITEM(res_store.backup_bw_weight), 0, ITEM_DEFAULT, 2},
+   {"restorebandwidthweight", store_pint32, ITEM(res_store.restore_bw_weight), 0, ITEM_DEFAULT, 4},
+   {"copybandwidthweight",   store_pint32, ITEM(res_store.copy_bw_weight), 0, ITEM_DEFAULT, 1},
    {"tlsauthenticate",       store_bool,    ITEM(res_store.tls_authenticate), 0, 0, 0},
    {"tlsenable",             store_bool,    ITEM(res_store.tls_enable), 0, 0, 0},
    {"tlsrequire",            store_bool,    ITEM(res_store.tls_require), 0, 0, 0},
    {"tlsverifypeer",         store_bool,    ITEM(res_store.tls_verify_peer), 1, ITEM_DEFAULT, 1},
+   {"tlskerneloffload",      store_bool,    ITEM(res_store.tls_kernel_offload), 0, ITEM_DEFAULT, false},
    {"tlscacertificatefile",  store_dir,       ITEM(res_store.tls_ca_certfile), 0, 0, 0},
    {"tlscacertificatedir",   store_dir,       ITEM(res_store.tls_ca_certdir), 0, 0, 0},
    {"tlscertificate",        store_dir,       ITEM(res_store.tls_certfile), 0, 0, 0},
@@ -124,6 +129,9 @@ static RES_ITEM dev_items[] = {
    {"requiresmount",         store_bit,  ITEM(res_dev.cap_bits), CAP_REQMOUNT, ITEM_DEFAULT, 0},
    {"offlineonunmount",      store_bit,  ITEM(res_dev.cap_bits), CAP_OFFLINEUNMOUNT, ITEM_DEFAULT, 0},
    {"blockchecksum",         store_bit,  ITEM(res_dev.cap_bits), CAP_BLOCKCHECKSUM, ITEM_DEFAULT, 1},
+   {"blockindex",            store_bit,  ITEM(res_dev.cap_bits), CAP_BLOCKINDEX, ITEM_DEFAULT, 0},
+   {"prefetchnextvolume",    store_bit,  ITEM(res_dev.cap_bits), CAP_PREFETCHVOL, ITEM_DEFAULT, 0},
+   {"writebehind",           store_bit,  ITEM(res_dev.cap_bits), CAP_WRITEBEHIND, ITEM_DEFAULT, 0},
    {"autoselect",            store_bool, ITEM(res_dev.autoselect), 1, ITEM_DEFAULT, 1},
    {"readonly",              store_bool, ITEM(res_dev.read_only), 1, ITEM_DEFAULT, 0},
    {"changerdevice",         store_strname,ITEM(res_dev.changer_name), 0, 0, 0},
@@ -139,6 +147,7 @@ static RES_ITEM dev_items[] = {
    {"maximumvolumesize",     store_size64,   ITEM(res_dev.max_volume_size), 0, 0, 0},
    {"maximumfilesize",       store_size64,   ITEM(res_dev.max_file_size), 0, ITEM_DEFAULT, 1000000000},
    {"volumecapacity",        store_size64,   ITEM(res_dev.volume_capacity), 0, 0, 0},
+   {"preallocatesize",       store_size64,   ITEM(res_dev.prealloc_size), 0, 0, 0},
    {"maximumconcurrentjobs", store_pint32, ITEM(res_dev.max_concurrent_jobs), 0, 0, 0},
    {"spooldirectory",        store_dir,    ITEM(res_dev.spool_directory), 0, 0, 0},
    {"maximumspoolsize",      store_size64,   ITEM(res_dev.max_spool_size), 0, 0, 0},
@@ -346,6 +355,15 @@ void dump_resource(int type, RES *reshdr, void sendit(void *sock, const char *fm
       if (res->res_dev.cap_bits & CAP_OFFLINEUNMOUNT) {
          bstrncat(buf, "CAP_OFFLINEUNMOUNT ", sizeof(buf));
       }
+      if (res->res_dev.cap_bits & CAP_BLOCKINDEX) {
+         bstrncat(buf, "CAP_BLOCKINDEX ", sizeof(buf));
+      }
+      if (res->res_dev.cap_bits & CAP_PREFETCHVOL) {
+         bstrncat(buf, "CAP_PREFETCHVOL ", sizeof(buf));
+      }
+      if (res->res_dev.cap_bits & CAP_WRITEBEHIND) {
+         bstrncat(buf, "CAP_WRITEBEHIND ", sizeof(buf));
+      }
       bstrncat(buf, "\n", sizeof(buf));
       sendit(sock, buf);
       break;
@@ -79,10 +79,15 @@ public:
    utime_t ClientConnectTimeout;      /* Max time to wait to connect client */
    utime_t heartbeat_interval;        /* Interval to send hb to FD */
    utime_t client_wait;               /* Time to wait for FD to connect */
+   uint64_t max_bandwidth;            /* Bandwidth shared by all the jobs */
+   uint32_t backup_bw_weight;         /* Shares of max_bandwidth per job type */
+   uint32_t restore_bw_weight;
+   uint32_t copy_bw_weight;
    bool tls_authenticate;             /* Authenticate with TLS */
    bool tls_enable;                   /* Enable TLS */
    bool tls_require;                  /* Require TLS */
    bool tls_verify_peer;              /* TLS Verify Client Certificate */
+   bool tls_kernel_offload;           /* Let the kernel do the TLS encryption */
    char *tls_ca_certfile;             /* TLS CA Certificate File */
    char *tls_ca_certdir;              /* TLS CA Certificate Directory */
    char *tls_certfile;                /* TLS Server Certificate File */
@@ -134,6 +139,7 @@ public:
    int64_t max_volume_size;           /* max bytes to put on one volume */
    int64_t max_file_size;             /* max file size in bytes */
    int64_t volume_capacity;           /* advisory capacity */
+   int64_t prealloc_size;             /* File volume preallocation increment */
    int64_t min_free_space;            /* Minimum disk free space */
    int64_t max_spool_size;            /* Max spool size for all jobs */
    int64_t max_job_spool_size;        /* Max spool size for any single job */
@@ -872,6 +872,8 @@ get_out:
  * Create a temporary copy of the volume list.  We do this,
  *   to avoid having the volume list locked during the
  *   call to reserve_device(), which would cause a deadlock.
+ * The list is copied in a single pass under the lock, it is
+ *   already sorted by name, so each entry is simply appended.
  * Note, we may want to add an update counter on the vol_list
  *   so that if it is modified while we are traversing the copy
  *   we can take note and act accordingly (probably redo the
@@ -882,43 +884,32 @@ dlist *dup_vol_list(JCR *jcr)
    dlist *temp_vol_list;
    VOLRES *vol = NULL;
 
-   Dmsg0(dbglvl, "lock volumes\n");
-
    Dmsg0(dbglvl, "duplicate vol list\n");
    temp_vol_list = New(dlist(vol, &vol->link));
-   foreach_vol(vol) {
-      VOLRES *nvol;
+   lock_volumes();
+   foreach_dlist(vol, vol_list) {
       VOLRES *tvol = (VOLRES *)malloc(sizeof(VOLRES));
       memset(tvol, 0, sizeof(VOLRES));
       tvol->vol_name = bstrdup(vol->vol_name);
       tvol->dev = vol->dev;
-      nvol = (VOLRES *)temp_vol_list->binary_insert(tvol, name_compare);
-      if (tvol != nvol) {
-         tvol->dev = NULL;                   /* don't zap dev entry */
-         free_vol_item(tvol);
-         Pmsg0(000, "Logic error. Duplicating vol list hit duplicate.\n");
-         Jmsg(jcr, M_WARNING, 0, "Logic error. Duplicating vol list hit duplicate.\n");
-      }
+      temp_vol_list->append(tvol);
    }
-   endeach_vol(vol);
-   Dmsg0(dbglvl, "unlock volumes\n");
+   unlock_volumes();
    return temp_vol_list;
 }
 
 /*
- * Free the specified temp list.
+ * Free the specified temp list.  It belongs to the caller, so
+ *   the volume list is not locked.
  */
 void free_temp_vol_list(dlist *temp_vol_list)
 {
-   dlist *save_vol_list;
+   VOLRES *vol;
 
-   lock_volumes();
-   save_vol_list = vol_list;
-   vol_list = temp_vol_list;
-   free_volume_list();                  /* release temp_vol_list */
-   vol_list = save_vol_list;
+   foreach_dlist(vol, temp_vol_list) {
+      free(vol->vol_name);
+      vol->vol_name = NULL;
+   }
+   delete temp_vol_list;
    Dmsg0(dbglvl, "deleted temp vol list\n");
-   Dmsg0(dbglvl, "unlock volumes\n");
-   unlock_volumes();
-   debug_list_volumes("after free temp table");
 }
@@ -94,6 +94,18 @@
 #define STREAM_WIN32_COMPRESSED_DATA           31    /* Compressed Win32 BackupRead data */
 #define STREAM_ENCRYPTED_FILE_COMPRESSED_DATA  32    /* Encrypted, compressed data */
 #define STREAM_ENCRYPTED_WIN32_COMPRESSED_DATA 33    /* Encrypted, compressed Win32 BackupRead data */
+/* Data records sealed one by one with an AEAD cipher.  Each record starts with
+ * a clear header holding the original stream, the FileIndex and a record number,
+ * followed by the original record encrypted, and the authentication tag.
+ * The stream ends with an empty record flagged with STREAM_AEAD_LAST_RECORD
+ * whose record number is the number of data records.
+ * see STREAM_AEAD_HEADER_SIZE.
+ */
+#define STREAM_AEAD_DATA                       34    /* AEAD encrypted data of any data stream */
+
+/* Original stream, FileIndex, file number, record number (4 bytes each) */
+#define STREAM_AEAD_HEADER_SIZE                16
+#define STREAM_AEAD_LAST_RECORD                0x80000000 /* flag in the record number */
 
 /**
  * Additional Stream definitions. Once defined these must NEVER
@@ -163,6 +175,8 @@
 #define STREAM_ACL_HURD_ACCESS_ACL       1019    /* GNU HURD specific acl_t string representation
                                                   * from acl_to_text (POSIX acl) for access acls.
                                                   */
+#define STREAM_ACL_REF                   1020    /* Reference to an ACL stream already sent in this Job */
+#define STREAM_XATTR_REF                 1988    /* Reference to a XATTR stream already sent in this Job */
 #define STREAM_XATTR_HURD                1989    /* GNU HURD specific extended attributes */
 #define STREAM_XATTR_IRIX                1990    /* IRIX specific extended attributes */
 #define STREAM_XATTR_TRU64               1991    /* TRU64 specific extended attributes */